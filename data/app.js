@@ -15,6 +15,8 @@ const endBehaviorEl = $("endBehavior");
 const pointsTableBody = $("pointsTable").querySelector("tbody");
 const chartEl = $("profileChart");
 const chartCtx = chartEl.getContext("2d");
+const runChartEl = $("runChart");
+const runChartCtx = runChartEl.getContext("2d");
 
 const toastEl = $("toast");
 const themeToggleEl = $("themeToggle");
@@ -55,10 +57,80 @@ const format = (value, digits = 2) => {
   return Number(value).toFixed(digits);
 };
 
-const updateStatus = async () => {
-  const res = await api("/api/status");
+let liveStatus = null;
+let pollTimer = null;
+
+const RUN_TRACE_MAX = 600;
+const runTrace = [];
+
+const drawRunChart = () => {
+  const width = runChartEl.width;
+  const height = runChartEl.height;
+  runChartCtx.clearRect(0, 0, width, height);
+  runChartCtx.fillStyle = "rgba(255,255,255,0.02)";
+  runChartCtx.fillRect(0, 0, width, height);
+  if (runTrace.length < 2) return;
+
+  const temps = runTrace.flatMap((p) => [p.meas, p.set]).filter((v) => v !== null && v !== undefined);
+  if (temps.length === 0) return;
+  const minTemp = Math.min(...temps);
+  const spanTemp = Math.max(Math.max(...temps) - minTemp, 1);
+  const t0 = runTrace[0].t;
+  const spanT = Math.max(runTrace[runTrace.length - 1].t - t0, 1);
+
+  const pad = 24;
+  const xFor = (t) => pad + ((t - t0) / spanT) * (width - pad * 2);
+  const yFor = (temp) => height - pad - ((temp - minTemp) / spanTemp) * (height - pad * 2);
+
+  const line = (key, color, dash) => {
+    runChartCtx.strokeStyle = color;
+    runChartCtx.lineWidth = 2;
+    runChartCtx.setLineDash(dash);
+    runChartCtx.beginPath();
+    let pen = false;
+    runTrace.forEach((p) => {
+      const v = p[key];
+      if (v === null || v === undefined) {
+        pen = false;
+        return;
+      }
+      if (pen) runChartCtx.lineTo(xFor(p.t), yFor(v));
+      else runChartCtx.moveTo(xFor(p.t), yFor(v));
+      pen = true;
+    });
+    runChartCtx.stroke();
+  };
+  line("set", "rgba(148,163,184,0.8)", [6, 4]);
+  line("meas", "#f97316", []);
+  runChartCtx.setLineDash([]);
+};
+
+const pushTrace = (s) => {
+  if (s.t_ms === undefined) return;
+  const last = runTrace[runTrace.length - 1];
+  if (last && s.t_ms <= last.t) return;
+  runTrace.push({ t: s.t_ms, meas: s.t_meas, set: s.t_set });
+  if (runTrace.length > RUN_TRACE_MAX) runTrace.splice(0, runTrace.length - RUN_TRACE_MAX);
+  drawRunChart();
+};
+
+// Whole retained curve in one request, downsampled by the device.
+const loadHistory = async () => {
+  const res = await api(`/api/history?points=${RUN_TRACE_MAX / 2}`);
   if (!res.ok || !res.data.ok) return;
-  const s = res.data.data;
+  const h = res.data.data;
+  const live = runTrace.filter((p) => p.t > h.t0 + h.dt * h.count);
+  runTrace.length = 0;
+  for (let i = 0; i < h.count; i++) {
+    const lo = h.t_meas_min[i];
+    const hi = h.t_meas_max[i];
+    runTrace.push({ t: h.t0 + i * h.dt, meas: lo === null ? null : (lo + hi) / 2, set: h.t_set[i] });
+  }
+  runTrace.push(...live);
+  drawRunChart();
+};
+
+const renderStatus = (s) => {
   stateEl.textContent = s.state;
   tMeasEl.textContent = `${format(s.t_meas)} C`;
   tSetEl.textContent = `${format(s.t_set)} C`;
@@ -69,6 +141,50 @@ const updateStatus = async () => {
   faultEl.textContent = s.fault;
 };
 
+const updateStatus = async () => {
+  const res = await api("/api/status");
+  if (!res.ok || !res.data.ok) return;
+  renderStatus(res.data.data);
+};
+
+const startPolling = () => {
+  if (pollTimer) return;
+  updateStatus();
+  pollTimer = setInterval(updateStatus, 1000);
+};
+
+const stopPolling = () => {
+  clearInterval(pollTimer);
+  pollTimer = null;
+};
+
+// Live status over server-sent events: a "status" keyframe followed by
+// "delta" messages carrying only changed fields. Poll while the stream is
+// down; EventSource reconnects on its own.
+const connectEvents = () => {
+  if (!window.EventSource) {
+    startPolling();
+    return;
+  }
+  const source = new EventSource("/api/events");
+  source.addEventListener("status", (e) => {
+    liveStatus = JSON.parse(e.data);
+    renderStatus(liveStatus);
+    pushTrace(liveStatus);
+    stopPolling();
+  });
+  source.addEventListener("delta", (e) => {
+    if (!liveStatus) return;
+    Object.assign(liveStatus, JSON.parse(e.data));
+    renderStatus(liveStatus);
+    pushTrace(liveStatus);
+  });
+  source.addEventListener("error", () => {
+    liveStatus = null;
+    startPolling();
+  });
+};
+
 const addPointRow = (t = "", temp = "") => {
   const row = document.createElement("tr");
   row.innerHTML = `
@@ -271,7 +387,8 @@ themeToggleEl.addEventListener("click", () => {
 clearEditor();
 refreshProfiles();
 updateStatus();
-setInterval(updateStatus, 1000);
+loadHistory();
+connectEvents();
 drawChart();
 
 const savedTheme = getCookie("theme");
@@ -2,23 +2,134 @@
 
 #include <Arduino.h>
 
-// Pin assignment (VSPI defaults)
+// Pin assignment (VSPI defaults). All MAX31855 chips share SCK/MISO.
 constexpr int PIN_MAX31855_SCK = 18;
 constexpr int PIN_MAX31855_MISO = 19;
-constexpr int PIN_MAX31855_CS = 5;
-constexpr int PIN_SSR = 13;
+// Route the MAX31855 read through SPI DMA. Off by default: a 4-byte frame is
+// served from the transaction's inline buffer without it.
+constexpr bool MAX31855_SPI_DMA = false;
 constexpr int PIN_RUN_SWITCH = 2;
 
+// Heating zones: one thermocouple (own CS) and one SSR per zone. MAX_ZONES
+// sizes the per-zone arrays; ZONE_PINS lists the zones this board has.
+constexpr uint8_t MAX_ZONES = 8;
+struct ZonePins {
+  int cs;
+  int ssr;
+};
+constexpr ZonePins ZONE_PINS[] = {
+    {5, 13},  // zone 0
+};
+constexpr uint8_t ZONE_COUNT = sizeof(ZONE_PINS) / sizeof(ZONE_PINS[0]);
+static_assert(ZONE_COUNT >= 1 && ZONE_COUNT <= MAX_ZONES, "ZONE_PINS must list 1..MAX_ZONES zones");
+
 // Control timing (ms)
 constexpr uint32_t TEMP_SAMPLE_MS = 200;
 constexpr uint32_t CONTROL_PERIOD_MS = 200;
+// Pipelined: the sensor task wakes the control task as soon as a sample is
+// in (task notification carrying the sample time). Otherwise both tasks run
+// free on their own periods and the control step uses the latest sample.
+constexpr bool CONTROL_PIPELINED = true;
+static_assert(CONTROL_PERIOD_MS % TEMP_SAMPLE_MS == 0, "control runs on every Nth sample");
+// Budget from the start of a sensor sweep to the duty reaching the SSR timer.
+// When no sample arrives within CONTROL_PERIOD_MS + this, the control step
+// runs on the previous one (state and safety checks never stall).
+constexpr uint32_t CONTROL_DEADLINE_US = 20000;
 
 // Time-proportional control window
 constexpr uint32_t WINDOW_MS = 1000;
+// SSR modulator timer tick: one mains half-cycle at 50 Hz (use 8333 for 60 Hz).
+constexpr uint32_t SSR_TICK_US = 10000;
+
+// Network task (network.h): station join timeout before the AP fallback,
+// and how often the join is retried under the fallback AP.
+constexpr uint32_t NETWORK_CONNECT_TIMEOUT_MS = 15000;
+constexpr uint32_t NETWORK_RETRY_MS = 60000;
+constexpr uint32_t NETWORK_STEP_MS = 100;
 
 // AP/mDNS defaults
 constexpr char AP_SSID[] = "esp32-oven";
 constexpr char AP_PASSWORD[] = "esp32-oven";
 constexpr char MDNS_HOST[] = "esp32-oven";
 
+// Run checkpoint (checkpoint.h) in reset-surviving memory, and the boot
+// policy for resuming from it: every zone's distance from the setpoint at
+// the checkpointed time within RESUME_TOLERANCE_C of its distance when the
+// checkpoint was written, and not more than RESUME_MAX_DROP_C below its
+// checkpointed temperature.
+constexpr size_t RETAINED_MEMORY_BYTES = 1024;
+constexpr bool RESUME_ENABLED = true;
+constexpr float RESUME_TOLERANCE_C = 15.0f;
+constexpr float RESUME_MAX_DROP_C = 25.0f;
+// Boot waits this long for the first control tick before deciding.
+constexpr uint32_t RESUME_WAIT_MS = 1000;
+
+// Relay autotune (autotune.h): the setpoint must stay this far below tmax_c,
+// and a zone this far above the setpoint aborts the experiment.
+constexpr float AUTOTUNE_TMAX_MARGIN_C = 20.0f;
+constexpr float AUTOTUNE_MAX_OVERSHOOT_C = 30.0f;
+constexpr uint8_t AUTOTUNE_MAX_CYCLES = 20;
+
+// Temperature filter buffers (filter.h), per zone.
 constexpr uint8_t MAX_SMOOTH_WINDOW = 10;
+constexpr uint8_t MAX_MEDIAN_WINDOW = 7;
+constexpr uint8_t MAX_RATE_WINDOW = 15;
+
+// Telemetry history: one packed record per zone per control tick (8 bytes
+// each); the time covered shrinks with the zone count.
+constexpr uint32_t HISTORY_CAPACITY = 6144; // ~20 min at CONTROL_PERIOD_MS with one zone
+constexpr uint16_t HISTORY_MAX_POINTS = 500;
+constexpr uint16_t HISTORY_DEFAULT_POINTS = 300;
+
+// Run log (LittleFS /runs): records are handed to the writer task in batches.
+constexpr uint16_t RUNLOG_BATCH_RECORDS = 64;  // ~12.8 s of single-zone ticks per flash write
+static_assert(RUNLOG_BATCH_RECORDS >= MAX_ZONES, "a run log batch must hold one tick of every zone");
+constexpr uint8_t RUNLOG_MAX_RUNS = 32;
+constexpr uint32_t RUNLOG_MAX_BYTES = 512 * 1024;
+
+// Zero-heap steady state (env esp32doit-devkit-v1-zeroheap sets
+// OVEN_ZERO_HEAP=1). Task stacks are static; handler JsonDocuments use one
+// arena reset per request; download state, POST bodies and the upload
+// parser take fixed slots, released when the request goes away. Still on
+// the heap per request: ESPAsyncWebServer's request and response objects
+// with their header/parameter Strings, the AsyncResponseStream buffer of
+// /api/metrics and /api/runs, LittleFS File handles (/api/runs, run and
+// asset downloads) and each SSE message. AsyncTCP/lwIP allocate their own.
+#ifndef OVEN_ZERO_HEAP
+#define OVEN_ZERO_HEAP 0
+#endif
+constexpr bool ZERO_HEAP = OVEN_ZERO_HEAP;
+constexpr size_t WEB_JSON_ARENA_BYTES = 8192;
+constexpr uint8_t WEB_STREAM_SLOTS = 2;  // concurrent history/profile downloads
+constexpr uint8_t WEB_BODY_SLOTS = 2;    // concurrent POSTs with a JSON body
+constexpr uint8_t WEB_UPLOAD_SLOTS = 1;  // the store takes one upload at a time
+
+// HTTP: JSON request bodies (run start, log levels, autotune) are buffered
+// whole; a ZERO_HEAP body slot holds the largest.
+constexpr size_t WEB_MAX_BODY_BYTES = ZERO_HEAP ? 2048 : 8192;
+// Profile uploads are parsed as they stream in (profile_parser.h); this only
+// bounds the time spent on one (~36 bytes of JSON per point).
+constexpr size_t PROFILE_UPLOAD_MAX_BYTES = 192 * 1024;
+
+// Profile store (LittleFS /profiles.bin, profile_store.h): RAM holds a 12-byte
+// index entry per profile; points stay in flash, in an append-only log.
+constexpr uint16_t PROFILE_STORE_MAX_PROFILES = 256;
+constexpr uint16_t PROFILE_MAX_POINTS = 4096;
+// A running zone keeps two pages of points in RAM; the next page is read
+// ahead by the store task.
+constexpr uint8_t PROFILE_PAGE_POINTS = 32;
+constexpr uint32_t PROFILE_PREFETCH_MS = 100;
+// An upload session idle this long can be taken over by a new upload.
+constexpr uint32_t PROFILE_WRITE_TIMEOUT_MS = 30000;
+// The store task compacts the profile log once this share of it (and at
+// least PROFILE_COMPACT_MIN_BYTES) is superseded records and tombstones.
+constexpr uint8_t PROFILE_COMPACT_DEAD_PCT = 50;
+constexpr uint32_t PROFILE_COMPACT_MIN_BYTES = 16 * 1024;
+
+// Logger (log.h): records queued per task before the log task drains them.
+constexpr uint32_t LOG_RING_RECORDS = 64;  // power of two
+constexpr uint8_t LOG_DEFAULT_LEVEL = 1;   // LogLevel::INFO for every module
+constexpr uint32_t LOG_DRAIN_MS = 20;
+// Also append log lines to LittleFS /log.txt (rotated to /log.old).
+constexpr bool LOG_TO_FILE = false;
+constexpr uint32_t LOG_FILE_MAX_BYTES = 64 * 1024;
@@ -4,43 +4,77 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include "app_config.h"
+#include "autotune.h"
+#include "controller.h"
+#include "filter.h"
 
 enum class RunState {
   IDLE,
   RUNNING,
   SWITCH_DISABLED,
-  FAULT
+  FAULT,
+  AUTOTUNE  // relay experiment (autotune.h), SSR driven like RUNNING
+};
+
+// How the SSR timer turns a duty value into on/off ticks (src/ssr.cpp).
+enum class SsrMode : uint8_t {
+  TIME_PROPORTIONAL,  // one on-pulse at the start of each window_ms
+  BURST               // sigma-delta: spreads on-ticks evenly, one half-cycle each
 };
 
 struct ControlConfig {
+  ControllerKind controller = ControllerKind::P;  // controller.h
   float kp = 0.03f;
   float bias = 0.0f;
+  float ki = 0.0f;        // PID: duty per C*s
+  float kd = 0.0f;        // PID: duty per C/s of measured rise
+  AntiWindup anti_windup = AntiWindup::CLAMP;
+  float kb = 0.2f;        // BACK_CALCULATION gain, 1/s
+  float ff_gain = 0.0f;   // duty per C/s of profile slope
+  float ff_lead_s = 0.0f; // how far ahead the slope is read (about the dead time)
   float setpoint_c = 100.0f;  // placeholder until profile runner is implemented
   float tmax_c = 300.0f;
   bool ssr_active_high = true;
   bool switch_active_high = false; // pull-up, active LOW by default
+  SsrMode ssr_mode = SsrMode::TIME_PROPORTIONAL;
   uint32_t window_ms = WINDOW_MS;
   uint32_t min_on_ms = 0;
   uint32_t min_off_ms = 0;
-  uint8_t smooth_window = 1; // 1 = no smoothing
+  FilterConfig filter;        // measurement filter, may change while running
 };
 
+// Run state is shared by all zones; per-zone values are parallel arrays
+// indexed by zone, valid below zone_count.
 struct ControlStatus {
-  float t_meas_c = NAN;
-  float t_set_c = NAN;
-  float duty = 0.0f;
-  uint8_t last_fault = 0;
   RunState state = RunState::IDLE;
   bool run_switch_enabled = false;
+  uint8_t last_fault = 0;  // fault code of the first faulted zone
+  uint8_t zone_count = 1;
+  float t_meas_c[MAX_ZONES];   // last valid sample, unfiltered
+  float t_filt_c[MAX_ZONES];   // filter output the control step uses
+  float t_rate_c_s[MAX_ZONES]; // NAN unless the filter's rate stage is on
+  float t_set_c[MAX_ZONES];
+  float duty[MAX_ZONES];
+  uint8_t zone_fault[MAX_ZONES];
+
+  ControlStatus() {
+    for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+      t_meas_c[z] = NAN;
+      t_filt_c[z] = NAN;
+      t_rate_c_s[z] = NAN;
+      t_set_c[z] = NAN;
+      duty[z] = 0.0f;
+      zone_fault[z] = 0;
+    }
+  }
 };
 
 struct ControlData {
   ControlConfig config;
   ControlStatus status;
-  uint32_t window_start_ms = 0;
-  float temp_samples[MAX_SMOOTH_WINDOW] = {};
-  uint8_t sample_index = 0;
-  uint8_t sample_count = 0;
+  TempFilter filters[MAX_ZONES];
+  ControllerState controllers[MAX_ZONES];
+  AutotuneState autotune;  // last experiment, kept after it ends
 };
 
 extern ControlData g_control;
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+// Bump allocator over a caller-owned buffer (8-byte aligned), emptied as a
+// whole by reset(). Each block records its size and its predecessor, so the
+// newest block can be freed or resized in place and an older one is moved
+// on reallocate(); other frees are no-ops until the reset. No locking: one
+// owner task at a time.
+class Arena {
+public:
+  Arena(void *buf, size_t cap) : buf_(static_cast<uint8_t *>(buf)), cap_(cap) {}
+
+  void *allocate(size_t size) {
+    size_t need = sizeof(Block) + roundUp(size);
+    if (need > cap_ - used_) {
+      failures_++;
+      return nullptr;
+    }
+    Block *block = reinterpret_cast<Block *>(buf_ + used_);
+    block->size = static_cast<uint32_t>(roundUp(size));
+    block->prev = last_;
+    last_ = static_cast<uint32_t>(used_);
+    used_ += need;
+    if (used_ > high_water_) {
+      high_water_ = used_;
+    }
+    return block + 1;
+  }
+
+  void deallocate(void *ptr) {
+    if (ptr && isLast(ptr)) {
+      used_ = last_;
+      last_ = blockOf(ptr)->prev;
+    }
+  }
+
+  void *reallocate(void *ptr, size_t size) {
+    if (!ptr) {
+      return allocate(size);
+    }
+    Block *block = blockOf(ptr);
+    if (isLast(ptr)) {
+      size_t need = sizeof(Block) + roundUp(size);
+      if (need > cap_ - last_) {
+        failures_++;
+        return nullptr;
+      }
+      block->size = static_cast<uint32_t>(roundUp(size));
+      used_ = last_ + need;
+      if (used_ > high_water_) {
+        high_water_ = used_;
+      }
+      return ptr;
+    }
+    void *moved = allocate(size);
+    if (moved) {
+      memcpy(moved, ptr, block->size < size ? block->size : size);
+    }
+    return moved;
+  }
+
+  void reset() {
+    used_ = 0;
+    last_ = kNone;
+  }
+
+  size_t used() const { return used_; }
+  size_t highWater() const { return high_water_; }
+  uint32_t failures() const { return failures_; }
+
+private:
+  struct Block {
+    uint32_t size;  // payload bytes, rounded up
+    uint32_t prev;  // offset of the block before, kNone for the first
+  };
+  static_assert(sizeof(Block) == 8, "payloads stay 8-byte aligned");
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  static size_t roundUp(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+  static Block *blockOf(void *ptr) { return static_cast<Block *>(ptr) - 1; }
+  bool isLast(void *ptr) const {
+    return last_ != kNone && reinterpret_cast<uint8_t *>(blockOf(ptr)) == buf_ + last_;
+  }
+
+  uint8_t *buf_;
+  size_t cap_;
+  size_t used_ = 0;
+  uint32_t last_ = kNone;
+  size_t high_water_ = 0;
+  uint32_t failures_ = 0;
+};
+
+// N objects constructed in place on acquire() and destroyed on release(),
+// for state that outlives a handler (downloads, POST bodies, uploads).
+// acquire() returns nullptr while all N are in use. No locking, like Arena.
+template <typename T, uint8_t N>
+class SlotPool {
+public:
+  T *acquire() {
+    for (uint8_t i = 0; i < N; ++i) {
+      if (!used_[i]) {
+        used_[i] = true;
+        return new (storage_[i]) T();
+      }
+    }
+    return nullptr;
+  }
+
+  void release(T *item) {
+    size_t i = (reinterpret_cast<uint8_t *>(item) - storage_[0]) / sizeof(T);
+    item->~T();
+    used_[i] = false;
+  }
+
+private:
+  alignas(T) uint8_t storage_[N][sizeof(T)];
+  bool used_[N] = {};
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include "app_config.h"
+
+struct ControlConfig;
+
+// Relay (bang-bang) identification, stepped by controlComputeControl() while
+// the state is AUTOTUNE. Each zone's duty switches between high_duty and 0
+// around setpoint_c +- hysteresis_c. Every half-cycle of the resulting
+// oscillation updates running sums, so memory is constant; from them:
+//   Ku, Pu  ultimate gain and period (describing function of the relay)
+//   theta   dead time: relay switch to the following extremum
+//   tau, G  FOPDT time constant and gain, solved from each half-cycle's
+//           exponential between its extremes; ambient = temperature at start
+// The first half-cycles (heat-up overshoot) are not counted. The estimate
+// ends in SIMC gains for PID plus profile feedforward, the same rules the
+// simulator's --controller-bench presets use.
+enum class AutotunePhase : uint8_t {
+  IDLE,
+  HEATING,  // relay on, before the first switch
+  RELAY,
+  DONE,
+  FAILED
+};
+
+struct AutotuneConfig {
+  float setpoint_c = 150.0f;
+  float hysteresis_c = 1.0f;
+  float high_duty = 1.0f;
+  uint8_t cycles = 4;       // counted full cycles per zone, up to AUTOTUNE_MAX_CYCLES
+  uint32_t max_s = 1800;    // the whole experiment, heat-up included
+  bool apply = false;       // write the suggested gains into ControlConfig when done
+};
+
+// Per-zone estimate; the gains are what autotuneApply() would set.
+struct AutotuneResult {
+  bool valid = false;
+  float ku = NAN;           // duty per C
+  float pu_s = NAN;
+  float amplitude_c = NAN;  // half the peak-to-peak swing
+  float theta_s = NAN;
+  float tau_s = NAN;
+  float gain_c = NAN;       // rise over ambient at 100% duty
+  float kp = NAN;
+  float ki = NAN;
+  float kd = NAN;
+  float ff_gain = NAN;
+  float ff_lead_s = NAN;
+};
+
+struct AutotuneZone {
+  AutotunePhase phase = AutotunePhase::IDLE;
+  bool relay_on = false;
+  uint32_t switch_ms = 0;
+  float ambient_c = NAN;
+  float ext_c = NAN;          // extremum since the last switch
+  uint32_t ext_ms = 0;
+  float last_ext_c = NAN;     // the previous confirmed extremum
+  uint32_t last_ext_ms = 0;
+  uint8_t extrema = 0;
+  // Running sums over counted half-cycles (up = trough to peak, relay on).
+  uint8_t up_count = 0;
+  uint8_t down_count = 0;
+  float up_s = 0.0f;
+  float up_low_c = 0.0f;
+  float up_high_c = 0.0f;
+  float down_s = 0.0f;
+  float down_log = 0.0f;      // sum of ln((peak - ambient) / (trough - ambient))
+  float swing_c = 0.0f;
+  float delay_s = 0.0f;
+  uint8_t delay_count = 0;
+  AutotuneResult result;
+};
+
+struct AutotuneState {
+  AutotuneConfig config;
+  AutotunePhase phase = AutotunePhase::IDLE;
+  const char *reason = "";  // why it FAILED
+  uint32_t start_ms = 0;
+  uint32_t end_ms = 0;
+  uint8_t zone_count = 0;
+  AutotuneZone zones[MAX_ZONES];
+};
+
+const char *autotunePhaseName(AutotunePhase phase);
+// Setpoint and hysteresis are checked by the caller; the rest is clamped.
+void autotuneStart(AutotuneState &state, const AutotuneConfig &config, const float *temps_c, uint8_t zones,
+                   uint32_t now_ms);
+// One control tick: relay duty per zone into duty_out, returns the phase
+// (DONE or FAILED once, then the caller leaves AUTOTUNE).
+AutotunePhase autotuneStep(AutotuneState &state, const float *temps_c, uint32_t now_ms, float *duty_out);
+void autotuneAbort(AutotuneState &state, const char *reason, uint32_t now_ms);
+// Mean of the valid zones' gains into config (controller = PID); false if
+// there is none.
+bool autotuneApply(const AutotuneState &state, ControlConfig &config);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+#include "app_config.h"
+#include "app_state.h"
+#include "profile.h"
+
+// Run checkpoint in reset-surviving memory (halRetainedMemory()), written by
+// the control step on every RUNNING tick so a brownout mid-profile need not
+// ruin the batch. Two slots alternate and each carries a CRC over the zones
+// in use, so a reset in the middle of a write still leaves the previous
+// tick's checkpoint; garbage after power-on fails the CRC.
+struct CheckpointZone {
+  char profile[kMaxProfileNameLength + 1];  // empty: the zone ran no profile
+  uint32_t elapsed_ms;                      // into the profile
+  float integral;                           // ControllerState::integral
+  float temp_c;                             // filtered temperature
+  float set_c;                              // profile setpoint at elapsed_ms
+};
+
+struct RunCheckpoint {
+  uint32_t sequence = 0;  // ticks written since the run started
+  uint8_t zone_count = 0;
+  ControllerKind controller = ControllerKind::P;
+  CheckpointZone zones[MAX_ZONES];
+};
+
+// Boot-time decision on a found checkpoint (controlResumeRun()).
+struct ResumePolicy {
+  bool enabled = RESUME_ENABLED;
+  float tolerance_c = RESUME_TOLERANCE_C;  // change of T - setpoint since the checkpoint, per zone
+  float max_drop_c = RESUME_MAX_DROP_C;    // cooling since the checkpoint, per zone
+};
+
+enum class ResumeDecision : uint8_t {
+  RESUME,
+  NO_CHECKPOINT,
+  DISABLED,
+  NOT_IDLE,         // switch off or fault at boot
+  ZONES_CHANGED,
+  PROFILE_MISSING,
+  SENSOR,           // a zone without a valid temperature
+  OFF_PROFILE,      // T - setpoint moved more than tolerance_c
+  COOLED            // dropped more than max_drop_c
+};
+
+const char *resumeDecisionName(ResumeDecision decision);
+
+void checkpointSave(RunCheckpoint &checkpoint);  // bumps sequence
+void checkpointClear();
+// The newest slot with a valid CRC.
+bool checkpointLoad(RunCheckpoint &out_checkpoint);
+
+// The policy alone, no side effects. expected_c is each zone's profile
+// setpoint at its checkpointed time, NAN if the profile could not be found;
+// zones that ran no profile are not checked against it. A zone is judged by
+// how far it is from that setpoint compared with how far it was at the
+// checkpoint, so the lag the controller already had does not count.
+ResumeDecision resumeDecide(const ResumePolicy &policy, const RunCheckpoint &checkpoint, RunState state,
+                            uint8_t zone_count, const float *temps_c, const float *expected_c);
@@ -2,14 +2,45 @@
 
 #include <Arduino.h>
 #include "app_state.h"
+#include "checkpoint.h"
 
 void controlInit();
 void controlUpdateTemperature();
 void controlUpdateState();
 void controlComputeControl();
-void controlUpdateSsrOutput(uint32_t now_ms);
+// Hands the current duty (0 unless RUNNING or AUTOTUNE) to the SSR timer (ssr.h).
+void controlUpdateSsrOutput();
 void controlLogStatus(uint32_t now_ms);
 
+// Takes effect on the next sample; each zone's filter restarts then.
+void controlSetFilter(const FilterConfig &config);
+
 bool controlTryStartRun();
+// Enters AUTOTUNE from IDLE. Refused (error set) with the switch off, a
+// fault, a zone already within 2 * hysteresis_c of the setpoint, or a
+// setpoint closer than AUTOTUNE_TMAX_MARGIN_C to tmax_c. The switch, a
+// fault, tmax_c and controlStopRun() abort it like a run.
+bool controlStartAutotune(const AutotuneConfig &config, const char *&error);
+void controlGetAutotune(AutotuneState &out_state);
+// Boot only, once the profile store is loaded and a control tick has run:
+// restarts the run found in the checkpoint (checkpoint.h) if the policy
+// allows, otherwise discards it.
+ResumeDecision controlResumeRun(const ResumePolicy &policy);
 void controlStopRun();
-void controlGetStatus(ControlStatus &out_status);
+// Lock-free copy of the last published status; returns its version.
+uint32_t controlGetStatus(ControlStatus &out_status);
+
+// Sample-to-SSR latency of the control stage (microseconds).
+struct ControlTiming {
+  uint32_t ticks = 0;
+  uint32_t last_latency_us = 0;
+  uint32_t max_latency_us = 0;
+  uint32_t avg_latency_us = 0;     // exponential, 1/16 per tick
+  uint32_t deadline_misses = 0;    // latency above CONTROL_DEADLINE_US
+  uint32_t stale_ticks = 0;        // steps that ran without a new sample
+  uint32_t first_tick_us = 0;      // halMicros() at the end of the first tick (boot to control)
+};
+// Control task, once per tick after controlUpdateSsrOutput(). sample_us is
+// halMicros() at the start of the sweep the step used.
+void controlRecordTiming(uint32_t sample_us, bool fresh_sample);
+void controlGetTiming(ControlTiming &out_timing);
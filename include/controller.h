@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+struct ControlConfig;
+
+// Duty law of one zone, run by controlComputeControl() each control tick.
+//   P    u = kp * e + bias                              (e = setpoint - T)
+//   PID  u = kp * e + I - kd * dT/dt + bias, I += ki * e * dt
+// Derivative acts on the measurement, not the error, so setpoint corners do
+// not kick the output. Either law adds ff_gain times the profile slope
+// ff_lead_s ahead (C/s): the duty a ramp needs before any error builds up.
+enum class ControllerKind : uint8_t {
+  P,
+  PID
+};
+
+// How PID keeps I from winding up while the duty is clamped to [0, 1].
+enum class AntiWindup : uint8_t {
+  CLAMP,            // integrate only when that does not push further into the limit
+  BACK_CALCULATION  // bleed I by kb * (clamped - unclamped) per second
+};
+
+struct ControllerInput {
+  float setpoint_c;
+  float slope_c_s;   // upcoming setpoint slope
+  float meas_c;      // filtered measurement
+  float rate_c_s;    // filter rate estimate, NAN if that stage is off
+  uint32_t now_ms;
+};
+
+// Per-zone state. I is kept in duty units, so gain changes while running
+// are bumpless; a change of kind restarts the state.
+struct ControllerState {
+  ControllerKind applied = ControllerKind::P;
+  bool primed = false;
+  uint32_t last_ms = 0;
+  float last_meas_c = NAN;
+  float rate_c_s = 0.0f;  // own derivative estimate when the filter has none
+  float integral = 0.0f;
+};
+
+const char *controllerName(ControllerKind kind);
+void controllerReset(ControllerState &state, ControllerKind kind);
+// Duty in [0, 1].
+float controllerStep(ControllerState &state, const ControlConfig &config, const ControllerInput &input);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3, reflected, as zlib/Python binascii.crc32). Nibble
+// table keeps it small; pass the previous result as crc to continue a run.
+inline uint32_t crc32Update(uint32_t crc, const void *data, size_t len) {
+  static const uint32_t kTable[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+      0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i) {
+    crc = kTable[(crc ^ bytes[i]) & 0x0F] ^ (crc >> 4);
+    crc = kTable[(crc ^ (bytes[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+inline uint32_t crc32(const void *data, size_t len) {
+  return crc32Update(0, data, len);
+}
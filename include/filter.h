@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include "app_config.h"
+
+// Per-zone temperature filter between controlUpdateTemperature() and the
+// control step. Stages, in order:
+//   median    median of median_window samples; rejects single spikes
+//   smoothing moving average over average_window samples (running sum) or
+//             EMA with ema_alpha
+//   rate      slope of the smoothed value over rate_window samples (C/s)
+// Every stage is O(1) per sample except the median, O(median_window).
+enum class FilterSmoothing : uint8_t {
+  NONE,
+  MOVING_AVERAGE,
+  EMA
+};
+
+struct FilterConfig {
+  uint8_t median_window = 1;   // 1 = off; odd, up to MAX_MEDIAN_WINDOW
+  FilterSmoothing smoothing = FilterSmoothing::NONE;
+  uint8_t average_window = 1;  // up to MAX_SMOOTH_WINDOW
+  float ema_alpha = 1.0f;      // weight of the new sample, (0, 1]
+  uint8_t rate_window = 0;     // 0 = no rate; up to MAX_RATE_WINDOW
+};
+
+// Filter state of one zone. The config it was built for is kept, so a
+// config change (live, from any task holding the control mutex) restarts
+// the filter on the next sample instead of reading stale windows.
+struct TempFilter {
+  FilterConfig applied;
+  bool primed = false;
+  float median_ring[MAX_MEDIAN_WINDOW];
+  float median_sorted[MAX_MEDIAN_WINDOW];
+  uint8_t median_index = 0;
+  uint8_t median_count = 0;
+  float average_ring[MAX_SMOOTH_WINDOW];
+  uint8_t average_index = 0;
+  uint8_t average_count = 0;
+  float average_sum = 0.0f;
+  float rate_value[MAX_RATE_WINDOW + 1];
+  uint32_t rate_ms[MAX_RATE_WINDOW + 1];
+  uint8_t rate_index = 0;
+  uint8_t rate_count = 0;
+  float temp_c = NAN;     // filtered temperature, NAN before the first sample
+  float rate_c_s = NAN;   // NAN when off or before two samples
+};
+
+// Windows clamped to the buffers, median window odd, alpha in (0, 1].
+FilterConfig filterSanitize(const FilterConfig &config);
+void filterReset(TempFilter &filter, const FilterConfig &config);
+// Adds one valid sample taken at now_ms.
+void filterPush(TempFilter &filter, const FilterConfig &config, float temp_c, uint32_t now_ms);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Board access for the control path. The ESP32 build forwards to the Arduino
+// core and reads the MAX31855 over hardware SPI (src/hal_esp32.cpp); the
+// native build backs it with a virtual clock and the oven plant simulator
+// (src/native/).
+
+struct ThermocoupleSample {
+  float temp_c = NAN;
+  float cold_junction_c = NAN;
+  uint8_t fault = 0;  // MAX31855 fault bits; 0xFF = no valid frame
+};
+
+void halInit();
+uint32_t halMillis();
+uint32_t halMicros();
+
+void halPinMode(uint8_t pin, uint8_t mode);
+int halDigitalRead(uint8_t pin);
+void halDigitalWrite(uint8_t pin, uint8_t level);
+
+// Zones wired on this board (ZONE_PINS on the ESP32, set by the simulator).
+uint8_t halZoneCount();
+// One sweep over the shared bus: a single frame per zone, zones 0..count-1.
+void halReadThermocouples(ThermocoupleSample *out_samples, uint8_t count);
+// Drives the SSR pin of zone to level. Safe from the timer callback.
+void halSetSsr(uint8_t zone, uint8_t level);
+
+// RETAINED_MEMORY_BYTES, 4-byte aligned, that keep their contents across a
+// reset but not a power loss (RTC slow memory on the ESP32; a static buffer
+// in the native build that simHalReset() leaves alone). Garbage after power
+// on: callers check their own CRC.
+void *halRetainedMemory();
+
+// Calls callback every period_us from a hardware timer interrupt (ESP32) or
+// from the virtual clock (native). One timer; later calls are ignored.
+void halStartTimer(uint32_t period_us, void (*callback)());
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Appends JSON to a fixed buffer; length() is 0 once anything did not fit.
+// Used for the /api/status body, SSE frames and the streamed API responses.
+class JsonWriter {
+public:
+  JsonWriter(char *buf, size_t cap) : buf_(buf), cap_(cap) {}
+
+  void raw(const char *text) { write(text, strlen(text)); }
+  void field(const char *key, const char *text) {
+    name(key);
+    put('"');
+    // Unescaped runs are copied as they are; printf only for control bytes.
+    const char *run = text;
+    for (const char *c = text;; ++c) {
+      if (*c && *c != '"' && *c != '\\' && static_cast<uint8_t>(*c) >= 0x20) {
+        continue;
+      }
+      write(run, c - run);
+      if (!*c) {
+        break;
+      }
+      if (*c == '"' || *c == '\\') {
+        put('\\');
+        put(*c);
+      } else {
+        append("\\u%04x", *c);
+      }
+      run = c + 1;
+    }
+    put('"');
+  }
+  void field(const char *key, bool value) {
+    name(key);
+    raw(value ? "true" : "false");
+  }
+  void field(const char *key, uint32_t value) {
+    name(key);
+    number(value);
+  }
+  void field(const char *key, float value, int digits) {
+    name(key);
+    if (isnan(value)) {
+      raw("null");
+    } else {
+      fixed(value, digits);
+    }
+  }
+  void beginObject() {
+    if (array_) {
+      raw(sep());
+    }
+    put('{');
+    first_ = true;
+  }
+  void endObject() {
+    put('}');
+    first_ = false;
+  }
+  // Objects written between beginArray/endArray become its elements. Arrays
+  // do not nest.
+  void beginArray(const char *key) {
+    name(key);
+    put('[');
+    first_ = true;
+    array_ = true;
+  }
+  void endArray() {
+    put(']');
+    first_ = false;
+    array_ = false;
+  }
+  size_t length() const { return overflow_ ? 0 : len_; }
+
+private:
+  const char *sep() {
+    const char *out = first_ ? "" : ",";
+    first_ = false;
+    return out;
+  }
+  void name(const char *key) {
+    raw(sep());
+    put('"');
+    raw(key);
+    raw("\":");
+  }
+  void put(char c) { write(&c, 1); }
+  void number(uint32_t value) {
+    char digits[10];
+    size_t n = 0;
+    do {
+      digits[sizeof(digits) - ++n] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value);
+    write(digits + sizeof(digits) - n, n);
+  }
+  // Same text as "%.*f". The scaled float is exact in a double, so ties
+  // round to even like printf; out-of-range values still go through it.
+  void fixed(float value, int digits) {
+    static constexpr uint32_t kScale[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    if (digits < 0 || digits > 6 || !(fabs(value) * kScale[digits] < 4e9)) {
+      append("%.*f", digits, value);
+      return;
+    }
+    uint32_t scale = kScale[digits];
+    double scaled = fabs(static_cast<double>(value)) * scale;
+    double whole = floor(scaled);
+    uint32_t units = static_cast<uint32_t>(whole);
+    if (scaled - whole > 0.5 || (scaled - whole == 0.5 && (units & 1))) {
+      units++;
+    }
+    if (signbit(value)) {
+      put('-');
+    }
+    number(units / scale);
+    if (digits > 0) {
+      put('.');
+      uint32_t frac = units % scale;
+      for (uint32_t div = scale / 10; div > 0; div /= 10) {
+        put(static_cast<char>('0' + frac / div % 10));
+      }
+    }
+  }
+  // Keeps the buffer NUL-terminated, as vsnprintf does.
+  void write(const char *text, size_t n) {
+    if (overflow_) {
+      return;
+    }
+    if (n >= cap_ - len_) {
+      overflow_ = true;
+      return;
+    }
+    memcpy(buf_ + len_, text, n);
+    len_ += n;
+    buf_[len_] = '\0';
+  }
+  void append(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    if (overflow_) {
+      return;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf_ + len_, cap_ - len_, format, args);
+    va_end(args);
+    if (n < 0 || static_cast<size_t>(n) >= cap_ - len_) {
+      overflow_ = true;
+      return;
+    }
+    len_ += n;
+  }
+
+  char *buf_;
+  size_t cap_;
+  size_t len_ = 0;
+  bool first_ = true;
+  bool array_ = false;
+  bool overflow_ = false;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Structured logger. Callers (any task) enqueue a binary record into a
+// lock-free ring and return; formatting and the blocking Serial/file write
+// happen in logProcess() on a low-priority task. A full ring drops the
+// record and counts it against its module.
+//
+//   logInfo(LogModule::CONTROL, "z%u t=%.2f", zone, temp_c);
+//
+// format must be a string literal (only the pointer is stored). Up to
+// kLogMaxArgs integer, float or string arguments; strings are copied into
+// the record (kLogTextBytes shared, truncated beyond).
+
+enum class LogLevel : uint8_t { DEBUG, INFO, WARN, ERROR, OFF };
+enum class LogModule : uint8_t { SYSTEM, CONTROL, SENSOR, PROFILE, STORAGE, RUNLOG, WEB, COUNT };
+
+constexpr uint8_t kLogMaxArgs = 6;
+constexpr uint8_t kLogTextBytes = 40;
+
+enum class LogArgType : uint8_t { I32, U32, F32, TEXT };
+
+struct LogRecord {
+  uint32_t t_ms;
+  const char *format;
+  union {
+    int32_t i;
+    uint32_t u;
+    float f;
+  } args[kLogMaxArgs];
+  LogArgType types[kLogMaxArgs];
+  uint8_t argc;
+  LogModule module;
+  LogLevel level;
+  uint8_t text_len;
+  char text[kLogTextBytes];  // TEXT args: u = offset, NUL-terminated
+};
+
+// Writes one formatted line (with trailing newline) somewhere.
+typedef void (*LogSink)(const char *line, size_t len);
+
+void logSetSink(LogSink sink);
+void logSetLevel(LogModule module, LogLevel level);
+LogLevel logGetLevel(LogModule module);
+bool logEnabled(LogModule module, LogLevel level);
+uint32_t logDropped(LogModule module);
+const char *logModuleName(LogModule module);
+const char *logLevelName(LogLevel level);
+// Parses a module or level name; false if unknown.
+bool logParseModule(const char *name, LogModule &out_module);
+bool logParseLevel(const char *name, LogLevel &out_level);
+
+// Non-blocking; false if the record was dropped.
+bool logSubmit(const LogRecord &record);
+// Drains the ring to the sink; returns the number of records written.
+uint32_t logProcess();
+
+namespace log_detail {
+// Fundamental types only: int32_t/uint32_t are int or long depending on the
+// toolchain.
+inline void encodeI(LogRecord &r, uint8_t i, int32_t v) { r.types[i] = LogArgType::I32; r.args[i].i = v; }
+inline void encodeU(LogRecord &r, uint8_t i, uint32_t v) { r.types[i] = LogArgType::U32; r.args[i].u = v; }
+inline void encode(LogRecord &r, uint8_t i, int v) { encodeI(r, i, v); }
+inline void encode(LogRecord &r, uint8_t i, long v) { encodeI(r, i, v); }
+inline void encode(LogRecord &r, uint8_t i, unsigned v) { encodeU(r, i, v); }
+inline void encode(LogRecord &r, uint8_t i, unsigned long v) { encodeU(r, i, v); }
+inline void encode(LogRecord &r, uint8_t i, unsigned char v) { encodeU(r, i, v); }
+inline void encode(LogRecord &r, uint8_t i, unsigned short v) { encodeU(r, i, v); }
+inline void encode(LogRecord &r, uint8_t i, bool v) { encodeU(r, i, v); }
+inline void encode(LogRecord &r, uint8_t i, float v) { r.types[i] = LogArgType::F32; r.args[i].f = v; }
+inline void encode(LogRecord &r, uint8_t i, double v) { encode(r, i, static_cast<float>(v)); }
+void encode(LogRecord &r, uint8_t i, const char *v);
+inline void encode(LogRecord &r, uint8_t i, const String &v) { encode(r, i, v.c_str()); }
+
+inline void encodeAll(LogRecord &, uint8_t) {}
+template <typename T, typename... Rest>
+void encodeAll(LogRecord &r, uint8_t i, const T &first, const Rest &...rest) {
+  encode(r, i, first);
+  encodeAll(r, i + 1, rest...);
+}
+
+template <typename... Args>
+void write(LogModule module, LogLevel level, const char *format, const Args &...args) {
+  static_assert(sizeof...(Args) <= kLogMaxArgs, "too many log arguments");
+  if (!logEnabled(module, level)) {
+    return;
+  }
+  LogRecord record;
+  record.format = format;
+  record.argc = sizeof...(Args);
+  record.module = module;
+  record.level = level;
+  record.text_len = 0;
+  encodeAll(record, 0, args...);
+  logSubmit(record);
+}
+} // namespace log_detail
+
+template <typename... Args>
+void logDebug(LogModule module, const char *format, const Args &...args) {
+  log_detail::write(module, LogLevel::DEBUG, format, args...);
+}
+template <typename... Args>
+void logInfo(LogModule module, const char *format, const Args &...args) {
+  log_detail::write(module, LogLevel::INFO, format, args...);
+}
+template <typename... Args>
+void logWarn(LogModule module, const char *format, const Args &...args) {
+  log_detail::write(module, LogLevel::WARN, format, args...);
+}
+template <typename... Args>
+void logError(LogModule module, const char *format, const Args &...args) {
+  log_detail::write(module, LogLevel::ERROR, format, args...);
+}
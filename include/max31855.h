@@ -0,0 +1,33 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// MAX31855 32-bit frame (MSB first):
+//   [31:18] thermocouple, signed, 0.25 C   [16] any fault
+//   [15:4]  cold junction, signed, 0.0625 C
+//   [2] short to VCC  [1] short to GND  [0] open circuit
+constexpr uint32_t kMax31855FaultAny = 1u << 16;
+constexpr uint8_t kMax31855FaultMask = 0x07;
+
+struct Max31855Reading {
+  float temp_c = NAN;
+  float cold_junction_c = NAN;
+  uint8_t fault = 0;  // kMax31855FaultMask bits; 0xFF if only bit 16 is set
+};
+
+inline Max31855Reading max31855Decode(uint32_t frame) {
+  Max31855Reading out;
+  out.fault = frame & kMax31855FaultMask;
+  if (out.fault == 0 && (frame & kMax31855FaultAny)) {
+    out.fault = 0xFF;
+  }
+  // Arithmetic shifts of the sign-extended fields.
+  int32_t cold = static_cast<int32_t>(frame << 16) >> 20;
+  out.cold_junction_c = cold * 0.0625f;
+  if (out.fault == 0) {
+    int32_t hot = static_cast<int32_t>(frame) >> 18;
+    out.temp_c = hot * 0.25f;
+  }
+  return out;
+}
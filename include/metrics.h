@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "hal.h"
+
+// Runtime instrumentation: fixed-bucket latency histograms updated with
+// relaxed atomics, so any task (or the AsyncTCP task) can record without
+// locking. Exposed in Prometheus text format at /api/metrics.
+
+enum class Metric : uint8_t {
+  TASK_SENSOR,
+  TASK_CONTROL,
+  TASK_WEB,
+  TASK_RUNLOG,
+  CONTROL_LATENCY,
+  LOCK_CONTROL,
+  LOCK_PROFILE,
+  LOCK_EVENTS,
+  LOCK_STORE,
+  HTTP_STATUS,
+  HTTP_HISTORY,
+  HTTP_PROFILES,
+  HTTP_PROFILE_ITEM,
+  HTTP_RUNS,
+  HTTP_RUN_DOWNLOAD,
+  HTTP_RUN,
+  HTTP_STOP,
+  HTTP_METRICS,
+  HTTP_LOG,
+  HTTP_AUTOTUNE,
+  HTTP_ASSET,
+  HTTP_NOT_FOUND,
+  COUNT
+};
+
+// Upper bucket bounds in microseconds; a last +Inf bucket follows.
+constexpr uint32_t kMetricBucketsUs[] = {10,    50,    100,    500,    1000,   5000,
+                                         10000, 50000, 100000, 200000, 500000, 1000000};
+constexpr uint8_t kMetricBuckets = sizeof(kMetricBucketsUs) / sizeof(kMetricBucketsUs[0]) + 1;
+
+struct MetricSnapshot {
+  uint32_t buckets[kMetricBuckets];  // per bucket, not cumulative
+  uint32_t count;
+  uint64_t sum_us;
+};
+
+void metricsObserve(Metric metric, uint32_t us);
+void metricsRead(Metric metric, MetricSnapshot &out_snapshot);
+// Prometheus family and label, e.g. "oven_lock_wait_seconds", "lock=\"control\"".
+const char *metricFamily(Metric metric);
+const char *metricLabels(Metric metric);
+
+// xSemaphoreTake(lock, portMAX_DELAY), recording the wait.
+inline void metricsTake(SemaphoreHandle_t lock, Metric metric) {
+  uint32_t start_us = halMicros();
+  xSemaphoreTake(lock, portMAX_DELAY);
+  metricsObserve(metric, halMicros() - start_us);
+}
+
+// Times a scope (task iteration, handler) into metric.
+class MetricTimer {
+public:
+  explicit MetricTimer(Metric metric) : metric_(metric), start_us_(halMicros()) {}
+  ~MetricTimer() { metricsObserve(metric_, halMicros() - start_us_); }
+  MetricTimer(const MetricTimer &) = delete;
+  MetricTimer &operator=(const MetricTimer &) = delete;
+
+private:
+  Metric metric_;
+  uint32_t start_us_;
+};
+
+// ESP32 only (src/metrics_export.cpp).
+class Print;
+// Tasks whose stack high-water mark is reported; handle is a TaskHandle_t.
+void metricsRegisterTask(const char *name, void *task_handle);
+void metricsWritePrometheus(Print &out);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Wi-Fi bring-up as a state machine stepped by the network task, so boot
+// and the control tasks never wait for the radio.
+//   STA_CONNECTING  station join in progress, up to NETWORK_CONNECT_TIMEOUT_MS
+//   STA_CONNECTED   mDNS up; losing the link goes back to STA_CONNECTING
+//   AP_FALLBACK     soft AP (AP_SSID) up after a failed join; the join is
+//                   retried every NETWORK_RETRY_MS and the AP dropped once
+//                   it succeeds
+//   AP_ONLY         no credentials in secrets.h
+enum class NetworkState : uint8_t {
+  OFF,
+  STA_CONNECTING,
+  STA_CONNECTED,
+  AP_FALLBACK,
+  AP_ONLY
+};
+
+struct NetworkStatus {
+  NetworkState state = NetworkState::OFF;
+  bool ap_up = false;
+  uint32_t ip = 0;          // station address (or AP address without one), 0 if none
+  uint32_t since_ms = 0;    // when the current state was entered
+  uint32_t reconnects = 0;  // joins started after the first one
+};
+
+const char *networkStateName(NetworkState state);
+// Brings up the TCP/IP stack and starts the first join; returns at once.
+// Network task only, like networkStep().
+void networkBegin();
+void networkStep(uint32_t now_ms);
+// Lock-free copy, any task.
+void networkGetStatus(NetworkStatus &out_status);
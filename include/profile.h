@@ -1,22 +1,41 @@
 #pragma once
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include "app_config.h"
 
+constexpr uint16_t kMaxProfilePoints = PROFILE_MAX_POINTS;
+constexpr uint8_t kMaxProfileNameLength = 31;
+// Capacity of the in-RAM Profile below (built-in and imported profiles);
+// larger ones are streamed into the store (profile_store.h).
+constexpr uint8_t kProfileInlinePoints = 32;
+
+// Also the on-flash point format: 8 bytes, little-endian, no padding.
 struct ProfilePoint {
   uint32_t t_sec = 0;
   float temp_c = 0.0f;
 };
+static_assert(sizeof(ProfilePoint) == 8, "ProfilePoint is stored as is");
 
-enum class EndBehavior {
+enum class EndBehavior : uint8_t {
   HOLD_LAST,
   STOP
 };
 
 struct Profile {
-  String name;
+  char name[kMaxProfileNameLength + 1] = "";
   EndBehavior end_behavior = EndBehavior::HOLD_LAST;
   uint8_t count = 0;
-  ProfilePoint points[32];
+  ProfilePoint points[kProfileInlinePoints];
+};
+
+// A stored profile's header; offset/generation locate its points in the store.
+struct ProfileInfo {
+  char name[kMaxProfileNameLength + 1];
+  EndBehavior end_behavior;
+  uint16_t count;
+  uint32_t offset;
+  uint32_t generation;
 };
 
 struct ProfileSetpoint {
@@ -24,17 +43,40 @@ struct ProfileSetpoint {
   bool completed = false;
   EndBehavior end_behavior = EndBehavior::HOLD_LAST;
   float setpoint_c = NAN;
+  float slope_c_s = 0.0f;  // of the segment lookahead_ms ahead (feedforward)
+  uint32_t elapsed_ms = 0; // into the profile (run checkpoint)
 };
 
 void profileInit();
-void profileSetTempLimits(float min_c, float max_c);
 
-bool profileAddOrUpdate(const Profile &profile, String &error);
-bool profileDelete(const String &name);
-bool profileGet(const String &name, Profile &out_profile);
-void profileList(String &json_out);
+// Removes the profile from the store and stops zones running it.
+bool profileDelete(const char *name);
+
+const char *profileEndBehaviorName(EndBehavior value);
+// JSON form of the legacy /profiles.json: {name, end_behavior, points:[{t_sec, temp_c}]}.
+// Points beyond kProfileInlinePoints are dropped; validation happens on add.
+void profileFromJson(JsonObjectConst in, Profile &out_profile);
 
-bool profileStartRun(const String &name);
+// Starts zone on the named profile. The zone pins the stored record, so
+// later edits to the profile do not affect the run; points are paged in
+// PROFILE_PAGE_POINTS at a time. elapsed_ms starts it part way through
+// (resume from a run checkpoint).
+bool profileStartRun(uint8_t zone, const char *name, uint32_t elapsed_ms = 0);
+// Clears every zone.
 void profileClearActive();
-ProfileSetpoint profileGetSetpoint(uint32_t now_ms);
-String profileGetActiveName();
+// Setpoints of zones 0..zone_count-1 under one lock. Constant time per zone
+// for monotonically increasing now_ms, unless a page has to be read because
+// profilePrefetch() fell behind. The lookahead slope only uses pages already
+// in RAM, so it can trail by a prefetch period on long profiles.
+void profileGetSetpoints(uint32_t now_ms, uint32_t lookahead_ms, ProfileSetpoint *out_setpoints,
+                         uint8_t zone_count);
+// Reads the page each running zone will need next. Store task, every
+// PROFILE_PREFETCH_MS; flash reads happen outside the profile lock.
+void profilePrefetch();
+// Pages the control step had to read itself.
+uint32_t profilePageMisses();
+// Copy of a zone's active name ("" if none); returns the version it
+// corresponds to.
+uint32_t profileCopyActiveName(uint8_t zone, char *out, size_t cap);
+// Changes whenever the active name does; lock-free, for cache checks.
+uint32_t profileActiveNameVersion();
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+#include "profile.h"
+
+// Incremental parser for one uploaded profile:
+//   {"name": "...", "end_behavior": "hold_last"|"stop",
+//    "points": [{"t_sec": 0, "temp_c": 25.0}, ...]}
+// Bytes can arrive in any split. Each point is handed to a profile store
+// write session (profile_store.h) as soon as it closes, so memory is
+// sizeof(ProfileParser) whatever the input. Unknown keys are skipped. Input
+// that does not fit (more than kMaxProfilePoints points, a longer name) or
+// that the store rejects is an error, not truncated; an error aborts the
+// session.
+//
+// Trivially destructible, so it can live in malloc'd request storage.
+class ProfileParser {
+public:
+  // Opens the store session; error() is "upload_busy" if another upload holds it.
+  void begin();
+  // Returns false once an error has occurred (sticky); further input is ignored.
+  bool feed(const char *data, size_t len);
+  // Checks that a complete document was read and commits it to the store.
+  bool finish();
+  // Error code ("syntax", "too_many_points", ...) or nullptr.
+  const char *error() const { return error_; }
+  // Byte offset of the error (or bytes consumed).
+  size_t position() const { return position_; }
+  uint32_t session() const { return session_; }
+
+private:
+  static constexpr uint8_t kMaxDepth = 8;
+  static constexpr uint8_t kTokenBytes = kMaxProfileNameLength + 1;
+
+  enum class State : uint8_t {
+    VALUE,          // a value is expected
+    VALUE_OR_END,   // just after '['
+    KEY_OR_END,     // just after '{'
+    KEY,            // after ',' in an object
+    COLON,
+    COMMA_OR_END,   // after a value inside a container
+    STRING,
+    STRING_ESCAPE,
+    STRING_UNICODE,
+    NUMBER,
+    LITERAL,
+    DONE
+  };
+  // What the value being read means, from the key path.
+  enum class Field : uint8_t { OTHER, NAME, END_BEHAVIOR, POINTS, POINT, T_SEC, TEMP_C };
+
+  bool fail(const char *code);
+  bool step(char c);
+  bool beginValue(char c);
+  bool endValue();
+  bool openContainer(char kind);
+  bool closeContainer(char kind);
+  bool appendToken(char c);
+  bool finishString();
+  bool finishNumber();
+  Field currentField() const;
+
+  State state_ = State::VALUE;
+  char stack_[kMaxDepth];      // 'o' or 'a' per open container
+  uint8_t depth_ = 0;
+  Field keys_[kMaxDepth];      // last key per object level
+  bool string_is_key_ = false;
+  bool token_overflow_ = false;
+  uint8_t token_len_ = 0;
+  char token_[kTokenBytes];
+  uint8_t unicode_digits_ = 0;
+  uint16_t unicode_ = 0;
+  bool points_open_ = false;   // inside the points array (depth 2)
+  bool have_points_ = false;
+  uint8_t point_fields_ = 0;   // bit 0 t_sec, bit 1 temp_c of the current point
+  size_t position_ = 0;
+  const char *error_ = nullptr;
+
+  uint32_t session_ = 0;
+  char name_[kMaxProfileNameLength + 1];
+  EndBehavior end_behavior_ = EndBehavior::HOLD_LAST;
+  ProfilePoint point_;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include "profile.h"
+
+// Flash-backed, log-structured profile store. /profiles.bin (storage.h) is
+// an append-only log of records:
+//
+//   file:   StoreFileHeader, then records back to back
+//   record: StoreRecordHeader (PUT or DELETE, name, end behavior, point
+//           count), count ProfilePoint, StoreRecordTrailer (CRC-32 of
+//           header and points, commit magic)
+//
+// Saving or deleting a profile appends one record and syncs it; the trailer
+// goes last, so a record interrupted by a reset fails its CRC and is
+// dropped on replay. Boot replays the log in order to rebuild the index.
+// Superseded records are reclaimed by profileStoreCompact(), which copies
+// the live ones to a new file and swaps it in with a rename.
+//
+// RAM holds only an index sorted by name hash (hash, record offset, point
+// count), so lookups are a binary search plus one header read to confirm
+// the name. Point data is read on demand.
+//
+// All functions take the store lock and may be called from any task.
+
+// Replays /profiles.bin into the index; a new or unreadable file starts
+// empty. A torn last record is dropped and the log compacted right away.
+bool profileStoreLoad();
+// Rewrites the log with only the live (and pinned) records when
+// PROFILE_COMPACT_DEAD_PCT of it is dead, or always with force. The copy
+// takes the lock per chunk; appends made meanwhile are carried over.
+// Store task.
+bool profileStoreCompact(bool force);
+
+struct ProfileStoreStats {
+  uint32_t file_bytes;
+  uint32_t live_bytes;     // file header plus the indexed records
+  uint32_t compactions;
+  uint32_t bytes_written;  // to every store file since boot
+};
+void profileStoreGetStats(ProfileStoreStats &out_stats);
+
+uint16_t profileStoreCount();
+// Index order (by name hash).
+bool profileStoreInfoAt(uint16_t index, ProfileInfo &out_info);
+bool profileStoreFind(const char *name, ProfileInfo &out_info);
+// Points [first, first + n) of the record out of profileStoreFind/InfoAt.
+// False if the store was compacted or reloaded since, or on a read error.
+bool profileStoreReadPoints(const ProfileInfo &info, uint16_t first, ProfilePoint *out, uint16_t n);
+
+// Points are range-checked against these on write.
+void profileSetTempLimits(float min_c, float max_c);
+
+// Streaming write of one profile: points go to a staging file as they
+// arrive and become a record on commit. One session at a time; Begin
+// returns 0 while another is active, unless it has been idle for
+// PROFILE_WRITE_TIMEOUT_MS. Errors are API codes ("temp_out_of_range",
+// "points_not_monotonic", "too_many_points", "profiles_full", ...); a failed
+// Point or Commit ends the session.
+uint32_t profileStoreWriteBegin();
+bool profileStoreWritePoint(uint32_t session, const ProfilePoint &point, const char *&error);
+bool profileStoreWriteCommit(uint32_t session, const char *name, EndBehavior end_behavior, const char *&error);
+void profileStoreWriteAbort(uint32_t session);
+// Whole in-RAM profile through a session.
+bool profileStoreAdd(const Profile &profile, const char *&error);
+bool profileStoreDelete(const char *name);
+
+// Running zones pin their record: compaction keeps it (even if replaced)
+// and moves the pin with it, so reads by slot stay valid for the whole run.
+bool profileStorePin(uint8_t slot, const char *name, ProfileInfo &out_info);
+void profileStoreUnpin(uint8_t slot);
+bool profileStoreReadPinned(uint8_t slot, uint16_t first, ProfilePoint *out, uint16_t n);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "profile.h"
+#include "telemetry.h"
+
+// Append-only binary log of every run on LittleFS (/runs/<id>.bin).
+//
+// File layout (little endian):
+//   RunlogFileHeader
+//   frames: RunlogFrameHeader, TickRecord[count], uint32 crc32(header + records)
+// Each tick is zone_count consecutive records (zone 0 first); a frame holds
+// whole ticks. Tick n of a run was taken at start_ms + n * period_ms. A frame
+// with a bad CRC (e.g. power lost mid-write) ends the readable part of the
+// file. Version 1 files have a single zone; versions 1 and 2 start with the
+// shorter RunlogFileHeaderV2.
+
+constexpr uint32_t kRunlogMagic = 0x4C52564F; // "OVRL"
+constexpr uint16_t kRunlogVersion = 3;
+constexpr uint16_t kRunlogFrameMagic = 0xB10C;
+
+struct RunlogFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t run_id;
+  uint32_t start_ms;
+  uint16_t period_ms;
+  uint16_t zone_count;
+  char profile[kMaxProfileNameLength + 1];  // zone 0
+  uint32_t crc;  // over the preceding fields
+};
+static_assert(sizeof(RunlogFileHeader) == 56, "RunlogFileHeader layout");
+
+// Header of version 1 and 2 files: the profile name cut to 23 characters.
+struct RunlogFileHeaderV2 {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t run_id;
+  uint32_t start_ms;
+  uint16_t period_ms;
+  uint16_t zone_count;  // 0 in version 1
+  char profile[24];
+  uint32_t crc;
+};
+static_assert(sizeof(RunlogFileHeaderV2) == 48, "RunlogFileHeaderV2 layout");
+
+struct RunlogFrameHeader {
+  uint16_t magic;
+  uint16_t count;       // records, not ticks
+  uint32_t first_tick;
+};
+static_assert(sizeof(RunlogFrameHeader) == 8, "RunlogFrameHeader layout");
+
+// Scans /runs for the next run id and creates the hand-off queue.
+void runlogInit();
+// Control task, once per tick after telemetryPublish(). Never touches flash.
+void runlogOnTick();
+// Writer task body: blocks until the control task hands over work, then
+// performs the flash I/O.
+void runlogProcess();
+
+// Fills out_doc with {"runs":[{id, bytes, profile, start_ms, zones}], "dropped"}.
+void runlogList(JsonDocument &out_doc);
+// "/runs/<id>.bin"; cap of at least kRunlogPathSize.
+constexpr size_t kRunlogPathSize = 24;
+void runlogPath(uint32_t run_id, char *out, size_t cap);
+uint32_t runlogDroppedRecords();
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Single-writer sequence lock. The writer bumps the sequence to odd, stores
+// the payload, then bumps it back to even; readers retry until they observe
+// the same even sequence on both sides of their copy, so they never see a
+// half-written value. Writers must be serialized by the caller (e.g. by
+// holding the mutex that guards the source data).
+//
+// A reader that preempts the writer on the writer's own core would spin on
+// the odd sequence forever, as the writer cannot run to finish: the network
+// and web tasks write snapshots on core 0, where the higher-priority AsyncTCP
+// task reads them. So after kReadSpins odd or changed sequences a reader
+// sleeps a tick, which lets any writer run; readers must be tasks, not ISRs.
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+
+public:
+  void write(const T &value) {
+    uint32_t words[kWords] = {};
+    memcpy(words, &value, sizeof(T));
+
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i) {
+      data_[i].store(words[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // Returns the (even) sequence number of the copied snapshot.
+  uint32_t read(T &out) const {
+    uint32_t words[kWords];
+    for (uint32_t tries = 1;; ++tries) {
+      uint32_t before = seq_.load(std::memory_order_acquire);
+      if (!(before & 1u)) {
+        for (size_t i = 0; i < kWords; ++i) {
+          words[i] = data_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == before) {
+          memcpy(&out, words, sizeof(T));
+          return before;
+        }
+      }
+      if (tries % kReadSpins == 0) {
+        vTaskDelay(1);
+      }
+    }
+  }
+
+  uint32_t sequence() const { return seq_.load(std::memory_order_acquire); }
+
+private:
+  // A write takes a few microseconds; a reader on the other core rarely
+  // retries more than once or twice.
+  static constexpr uint32_t kReadSpins = 64;
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> data_[kWords] = {};
+};
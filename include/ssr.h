@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Arduino.h>
+#include "app_state.h"
+
+// SSR outputs driven from a periodic hardware timer (SSR_TICK_US). The control
+// task only hands over a duty value per zone; the timer callback decides each
+// tick whether each SSR conducts, per ControlConfig::ssr_mode, and enforces
+// min_on_ms / min_off_ms.
+
+// Switches the zone SSRs off and starts the timer. Safe to call again.
+void ssrInit(const ControlConfig &config, uint8_t zone_count);
+// Mode/window/min times; picked up by the timer on its next tick.
+void ssrConfigure(const ControlConfig &config);
+// duty in 0..1. A zero duty switches off on the next tick, ignoring min_on_ms.
+void ssrSetDuty(uint8_t zone, float duty);
+// Drives all outputs off now and resets the modulator state.
+void ssrStop();
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "app_state.h"
+#include "control.h"
+#include "profile.h"
+
+// Run state as the API names it.
+const char *runStateName(RunState state);
+
+// Writes the /api/status body for one snapshot; profiles[z] is zone z's
+// active profile. Returns its length, 0 if it does not fit in cap.
+size_t statusRenderJson(char *buf, size_t cap, uint32_t seq, const ControlStatus &status,
+                        const ControlTiming &timing, const char (*profiles)[kMaxProfileNameLength + 1]);
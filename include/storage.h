@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Arduino.h>
+
+// LittleFS mount and one-time import of the old /profiles.json.
+bool storageInit();
+bool storageLoadProfiles();
+// Log sink (log.h): appends to /log.txt, rotating it to /log.old at
+// LOG_FILE_MAX_BYTES. Log task only.
+void storageAppendLog(const char *line, size_t len);
+
+// Files behind the profile store (profile_store.cpp), kept open. Writes
+// always append. Callers serialise access to each file. The native build
+// keeps them in RAM (src/native/storage_native.cpp).
+enum class StoreFile : uint8_t {
+  PROFILES,  // /profiles.bin: the record log
+  STAGING,   // /profiles.stage: points of the upload in progress
+  REWRITE,   // /profiles.new: the compacted log while it is being written
+  COUNT
+};
+uint32_t storageFileSize(StoreFile file);
+bool storageFileRead(StoreFile file, uint32_t offset, void *out, size_t len);
+bool storageFileAppend(StoreFile file, const void *data, size_t len);
+// Pushes appended data to flash.
+bool storageFileSync(StoreFile file);
+// Bytes appended to any store file since boot (write amplification).
+uint32_t storageFileBytesWritten();
+// Truncates to empty.
+bool storageFileReset(StoreFile file);
+// Atomically replaces PROFILES with REWRITE; REWRITE is left empty.
+bool storageFileCommitRewrite();
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include "app_state.h"
+
+// One record per control tick, published by the control task.
+struct TelemetryFrame {
+  uint32_t seq = 0;   // tick counter, 0 = nothing published yet
+  uint32_t t_ms = 0;
+  ControlStatus status;
+};
+
+// Temperatures in history records/buckets are fixed point, 1/16 C per LSB.
+constexpr float kHistoryTempScale = 16.0f;
+constexpr int16_t kHistoryTempInvalid = INT16_MIN;
+
+// Packed per-tick, per-zone record used by the history ring and the run log.
+struct TickRecord {
+  int16_t t_meas;
+  int16_t t_set;
+  uint8_t duty;      // 0..255
+  uint8_t state;     // RunState
+  uint8_t fault;     // the zone's sensor fault
+  uint8_t reserved;
+};
+static_assert(sizeof(TickRecord) == 8, "TickRecord must stay packed");
+
+// Downsampled view of the history over one time bucket.
+struct HistoryBucket {
+  int16_t t_meas_min = kHistoryTempInvalid;
+  int16_t t_meas_max = kHistoryTempInvalid;
+  int16_t t_set = kHistoryTempInvalid;  // last value in the bucket
+  uint8_t duty = 0;                     // mean, 0..255
+  uint8_t state = 0;                    // RunState of the last tick
+  uint8_t fault = 0;                    // OR of all fault codes
+};
+
+struct HistoryRange {
+  uint32_t t0_ms = 0;      // start of the first bucket
+  uint32_t bucket_ms = 0;  // bucket width
+  uint32_t ticks = 0;      // records covered
+};
+
+void telemetryPublish(uint32_t now_ms);
+void telemetryEncodeRecord(const TelemetryFrame &frame, uint8_t zone, TickRecord &out_record);
+// Lock-free; returns false until the first tick has been published.
+bool telemetryLatest(TelemetryFrame &out_frame);
+
+// Min/max downsamples zone's records between from_ms and to_ms (uptime, both
+// inclusive) into at most max_points buckets. Lock-free against the control
+// task; returns the number of buckets written.
+uint16_t telemetryHistoryQuery(uint8_t zone, uint32_t from_ms, uint32_t to_ms, uint16_t max_points,
+                               HistoryBucket *out_buckets, HistoryRange &out_range);
+
+inline float historyTempToC(int16_t value) {
+  return value == kHistoryTempInvalid ? NAN : static_cast<float>(value) / kHistoryTempScale;
+}
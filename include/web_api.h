@@ -2,5 +2,20 @@
 
 #include <Arduino.h>
 
-bool webSetup();
-void webHandleClient();
+// Starts the server; call once the TCP/IP stack is up (networkBegin()).
+void webSetup();
+// Requests are served by the AsyncTCP task; the web task only fans out
+// telemetry to event-stream clients.
+void webPumpEvents();
+// Free heap when the last profile upload began and the lowest value seen
+// while it was parsed and stored (0 before the first upload).
+void webProfileUploadHeap(uint32_t &out_before, uint32_t &out_min_free);
+
+// ZERO_HEAP request memory (all 0 in other builds). AsyncTCP task, like
+// the handlers that update it.
+struct WebArenaStats {
+  uint32_t json_high_water = 0;  // most arena bytes one request used
+  uint32_t json_failures = 0;    // allocations the arena refused
+  uint32_t slot_busy = 0;        // requests refused for want of a slot
+};
+void webArenaStats(WebArenaStats &out_stats);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Dashboard assets prepared by tools/build_assets.py: gzip bodies under /w/
+// on LittleFS, described by /manifest.json which is read once at boot.
+struct WebAsset {
+  char path[32];   // request path, e.g. "/app.js"
+  char file[24];   // LittleFS path of the gzip body
+  char etag[20];   // quoted content hash
+  char type[32];
+};
+
+bool webAssetsLoad();
+// Lookup in the in-memory manifest; never touches the filesystem.
+const WebAsset *webAssetFind(const char *path);
@@ -0,0 +1,42 @@
+#pragma once
+
+// Host stand-in for the small part of the Arduino core that the portable
+// firmware modules (control, profile, app_state) use. Board access goes
+// through hal.h; this header only supplies types, String and Serial.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "WString.h"
+#include "HardwareSerial.h"
+
+using std::isnan;
+using std::max;
+using std::min;
+
+constexpr uint8_t LOW = 0x0;
+constexpr uint8_t HIGH = 0x1;
+
+constexpr uint8_t INPUT = 0x01;
+constexpr uint8_t OUTPUT = 0x03;
+constexpr uint8_t INPUT_PULLUP = 0x05;
+
+// Provided by the native HAL (virtual clock).
+uint32_t millis();
+void delay(uint32_t ms);
+
+// newlib provides strlcpy on the ESP32; older glibc does not.
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size > 0) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
@@ -0,0 +1,26 @@
+#include "HardwareSerial.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+HardwareSerial Serial;
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+size_t HardwareSerial::print(const char *text) {
+  return fputs(text, stdout) < 0 ? 0 : strlen(text);
+}
+
+size_t HardwareSerial::print(char c) {
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vprintf(format, args);
+  va_end(args);
+  return n < 0 ? 0 : static_cast<size_t>(n);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include "WString.h"
+
+constexpr int DEC = 10;
+constexpr int HEX = 16;
+
+// Serial writes to stdout on the host.
+class HardwareSerial {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void flush();
+
+  size_t print(const char *text);
+  size_t print(const String &text) { return print(text.c_str()); }
+  size_t print(char c);
+  size_t print(int value, int base = DEC) { return print(String(value, static_cast<unsigned char>(base))); }
+  size_t print(unsigned int value, int base = DEC) { return print(String(value, static_cast<unsigned char>(base))); }
+  size_t print(long value, int base = DEC) { return print(String(value, static_cast<unsigned char>(base))); }
+  size_t print(unsigned long value, int base = DEC) { return print(String(value, static_cast<unsigned char>(base))); }
+  size_t print(double value, int digits = 2) { return print(String(value, static_cast<unsigned int>(digits))); }
+
+  size_t println() { return print("\n"); }
+  template <typename T>
+  size_t println(const T &value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(const T &value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
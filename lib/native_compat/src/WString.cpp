@@ -0,0 +1,96 @@
+#include "WString.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+std::string formatInteger(unsigned long long magnitude, bool negative, unsigned char base) {
+  if (base < 2 || base > 36) {
+    base = 10;
+  }
+  char buf[72];
+  size_t pos = sizeof(buf);
+  buf[--pos] = '\0';
+  do {
+    unsigned digit = static_cast<unsigned>(magnitude % base);
+    buf[--pos] = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    magnitude /= base;
+  } while (magnitude > 0 && pos > 1);
+  if (negative) {
+    buf[--pos] = '-';
+  }
+  return std::string(&buf[pos]);
+}
+
+std::string formatSigned(long long value, unsigned char base) {
+  if (base == 10 && value < 0) {
+    return formatInteger(static_cast<unsigned long long>(-(value + 1)) + 1, true, base);
+  }
+  return formatInteger(static_cast<unsigned long long>(value), false, base);
+}
+
+std::string formatFloat(double value, unsigned int decimal_places) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", static_cast<int>(decimal_places), value);
+  return std::string(buf);
+}
+} // namespace
+
+String::String(int value, unsigned char base) : str_(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : str_(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : str_(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : str_(formatInteger(value, false, base)) {}
+String::String(float value, unsigned int decimal_places) : str_(formatFloat(value, decimal_places)) {}
+String::String(double value, unsigned int decimal_places) : str_(formatFloat(value, decimal_places)) {}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t pos = str_.find(c, from);
+  return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const String &needle, unsigned int from) const {
+  size_t pos = str_.find(needle.str_, from);
+  return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    unsigned int tmp = from;
+    from = to;
+    to = tmp;
+  }
+  if (from >= str_.size()) {
+    return String();
+  }
+  if (to > str_.size()) {
+    to = static_cast<unsigned int>(str_.size());
+  }
+  String out;
+  out.str_ = str_.substr(from, to - from);
+  return out;
+}
+
+long String::toInt() const {
+  return strtol(str_.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+  return strtof(str_.c_str(), nullptr);
+}
+
+StringSumHelper operator+(const String &lhs, const String &rhs) {
+  StringSumHelper out(lhs);
+  out.concat(rhs);
+  return out;
+}
+
+StringSumHelper operator+(const String &lhs, const char *rhs) {
+  StringSumHelper out(lhs);
+  out.concat(rhs);
+  return out;
+}
+
+StringSumHelper operator+(const char *lhs, const String &rhs) {
+  StringSumHelper out{String(lhs)};
+  out.concat(rhs);
+  return out;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// std::string backed subset of the Arduino String API.
+class String {
+public:
+  String() = default;
+  String(const char *cstr) { *this = cstr; }
+  String(const String &) = default;
+  String(String &&) = default;
+  explicit String(char c) : str_(1, c) {}
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned int decimal_places = 2);
+  explicit String(double value, unsigned int decimal_places = 2);
+
+  String &operator=(const String &) = default;
+  String &operator=(String &&) = default;
+  String &operator=(const char *cstr) {
+    if (cstr) {
+      str_ = cstr;
+    } else {
+      str_.clear();
+    }
+    return *this;
+  }
+
+  const char *c_str() const { return str_.c_str(); }
+  unsigned int length() const { return static_cast<unsigned int>(str_.size()); }
+  bool isEmpty() const { return str_.empty(); }
+  bool reserve(unsigned int size) {
+    str_.reserve(size);
+    return true;
+  }
+
+  bool concat(const String &other) {
+    str_ += other.str_;
+    return true;
+  }
+  bool concat(const char *cstr) {
+    if (cstr) {
+      str_ += cstr;
+    }
+    return true;
+  }
+  bool concat(const char *cstr, unsigned int len) {
+    if (cstr) {
+      str_.append(cstr, len);
+    }
+    return true;
+  }
+  bool concat(char c) {
+    str_ += c;
+    return true;
+  }
+
+  String &operator+=(const String &other) { concat(other); return *this; }
+  String &operator+=(const char *cstr) { concat(cstr); return *this; }
+  String &operator+=(char c) { concat(c); return *this; }
+
+  bool operator==(const String &other) const { return str_ == other.str_; }
+  bool operator==(const char *cstr) const { return cstr ? str_ == cstr : str_.empty(); }
+  bool operator!=(const String &other) const { return !(*this == other); }
+  bool operator!=(const char *cstr) const { return !(*this == cstr); }
+  bool operator<(const String &other) const { return str_ < other.str_; }
+
+  char operator[](unsigned int index) const { return index < str_.size() ? str_[index] : '\0'; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+
+  bool startsWith(const String &prefix) const { return str_.compare(0, prefix.str_.size(), prefix.str_) == 0; }
+  bool endsWith(const String &suffix) const {
+    return str_.size() >= suffix.str_.size() &&
+           str_.compare(str_.size() - suffix.str_.size(), suffix.str_.size(), suffix.str_) == 0;
+  }
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const String &needle, unsigned int from = 0) const;
+  String substring(unsigned int from) const { return substring(from, length()); }
+  String substring(unsigned int from, unsigned int to) const;
+
+  long toInt() const;
+  float toFloat() const;
+
+private:
+  std::string str_;
+};
+
+// Arduino's operator+ returns a StringSumHelper; keep the name available for
+// libraries that specialise on it.
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String &s) : String(s) {}
+};
+
+StringSumHelper operator+(const String &lhs, const String &rhs);
+StringSumHelper operator+(const String &lhs, const char *rhs);
+StringSumHelper operator+(const char *lhs, const String &rhs);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// Host stand-in for the FreeRTOS types used by the portable modules. One tick
+// is one millisecond of the native HAL clock.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+constexpr BaseType_t pdFALSE = 0;
+constexpr BaseType_t pdTRUE = 1;
+constexpr BaseType_t pdPASS = pdTRUE;
+constexpr BaseType_t pdFAIL = pdFALSE;
+
+constexpr TickType_t portMAX_DELAY = 0xFFFFFFFFu;
+constexpr TickType_t portTICK_PERIOD_MS = 1;
+
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
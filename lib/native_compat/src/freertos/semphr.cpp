@@ -0,0 +1,37 @@
+#include "semphr.h"
+#include <chrono>
+#include <mutex>
+
+struct NativeSemaphore {
+  std::timed_mutex mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new NativeSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+  if (!semaphore) {
+    return pdFALSE;
+  }
+  if (ticks_to_wait == portMAX_DELAY) {
+    semaphore->mutex.lock();
+    return pdTRUE;
+  }
+  if (ticks_to_wait == 0) {
+    return semaphore->mutex.try_lock() ? pdTRUE : pdFALSE;
+  }
+  return semaphore->mutex.try_lock_for(std::chrono::milliseconds(ticks_to_wait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  if (!semaphore) {
+    return pdFALSE;
+  }
+  semaphore->mutex.unlock();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  delete semaphore;
+}
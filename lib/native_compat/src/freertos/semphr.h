@@ -0,0 +1,14 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Mutex semaphores backed by std::timed_mutex. Timeouts are wall-clock
+// milliseconds, not virtual HAL time.
+
+struct NativeSemaphore;
+typedef NativeSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
@@ -0,0 +1,7 @@
+#include "task.h"
+#include <chrono>
+#include <thread>
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Sleeps the calling thread for ticks wall-clock milliseconds (not virtual
+// HAL time, like the semaphore timeouts).
+void vTaskDelay(TickType_t ticks);
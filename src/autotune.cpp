@@ -0,0 +1,237 @@
+#include "autotune.h"
+#include "app_state.h"
+#include <math.h>
+
+namespace {
+// Confirmed extrema, in order: 1 the start (heat-up trough), 2 the heat-up
+// overshoot peak, then the relay cycle. Delays count from the first peak,
+// half-cycles from the one after it.
+constexpr uint8_t kFirstDelayExtremum = 2;
+constexpr uint8_t kFirstSegmentExtremum = 4;
+constexpr float kPi = 3.14159265f;
+
+bool finiteAbove(float value, float floor) {
+  return !isnan(value) && !isinf(value) && value > floor;
+}
+
+void estimate(const AutotuneConfig &config, AutotuneZone &zone) {
+  AutotuneResult &result = zone.result;
+  result = AutotuneResult{};
+  if (zone.up_count == 0 || zone.down_count == 0 || zone.delay_count == 0) {
+    return;
+  }
+  result.amplitude_c = zone.swing_c / (zone.up_count + zone.down_count) / 2.0f;
+  result.pu_s = zone.up_s / zone.up_count + zone.down_s / zone.down_count;
+  // Relay of amplitude d = high_duty / 2 with hysteresis eps:
+  //   Ku = 4d / (pi * sqrt(a^2 - eps^2))
+  float a = result.amplitude_c;
+  float eps = config.hysteresis_c;
+  float effective = a > eps * 1.05f ? sqrtf(a * a - eps * eps) : a;
+  result.ku = 2.0f * config.high_duty / (kPi * effective);
+  // The loop sees at least one control period of delay.
+  result.theta_s = max(zone.delay_s / zone.delay_count, CONTROL_PERIOD_MS / 1000.0f);
+
+  // Relay off, peak to trough: T - amb decays as exp(-t / tau).
+  if (zone.down_log > 0.0f) {
+    result.tau_s = zone.down_s / zone.down_log;
+  }
+  // Relay on, trough to peak: T rises towards T_inf with the same tau.
+  if (finiteAbove(result.tau_s, 0.0f)) {
+    float rise_s = zone.up_s / zone.up_count;
+    float low_c = zone.up_low_c / zone.up_count;
+    float high_c = zone.up_high_c / zone.up_count;
+    float r = expf(rise_s / result.tau_s);
+    float t_inf = (r * high_c - low_c) / (r - 1.0f);
+    if (t_inf > high_c) {
+      result.gain_c = (t_inf - zone.ambient_c) / config.high_duty;
+    }
+  }
+
+  if (finiteAbove(result.tau_s, 0.0f) && finiteAbove(result.gain_c, 0.0f)) {
+    // SIMC: kc = tau / (G * 2 theta), Ti = min(tau, 8 theta), Td = theta / 3.
+    float kc = result.tau_s / (result.gain_c * 2.0f * result.theta_s);
+    float ti = min(result.tau_s, 8.0f * result.theta_s);
+    result.kp = kc;
+    result.ki = kc / ti;
+    result.kd = kc * result.theta_s / 3.0f;
+    result.ff_gain = result.tau_s / result.gain_c;
+    result.ff_lead_s = result.theta_s;
+    result.valid = true;
+  } else if (finiteAbove(result.ku, 0.0f) && finiteAbove(result.pu_s, 0.0f)) {
+    // No usable FOPDT fit: Ziegler-Nichols "no overshoot" from Ku, Pu.
+    result.kp = 0.2f * result.ku;
+    result.ki = result.kp / (result.pu_s / 2.0f);
+    result.kd = result.kp * result.pu_s / 3.0f;
+    result.ff_gain = 0.0f;
+    result.ff_lead_s = 0.0f;
+    result.valid = true;
+  }
+}
+
+// The extremum tracked since the last switch is final once the relay
+// switches again.
+void confirmExtremum(const AutotuneConfig &config, AutotuneZone &zone, bool trough) {
+  zone.extrema++;
+  if (zone.extrema >= kFirstDelayExtremum) {
+    zone.delay_s += (zone.ext_ms - zone.switch_ms) / 1000.0f;
+    zone.delay_count++;
+  }
+  if (zone.extrema >= kFirstSegmentExtremum) {
+    float span_s = (zone.ext_ms - zone.last_ext_ms) / 1000.0f;
+    if (trough) {
+      float above_peak = zone.last_ext_c - zone.ambient_c;
+      float above_trough = zone.ext_c - zone.ambient_c;
+      if (above_trough > 0.0f && above_peak > above_trough) {
+        zone.down_s += span_s;
+        zone.down_log += logf(above_peak / above_trough);
+        zone.swing_c += zone.last_ext_c - zone.ext_c;
+        zone.down_count++;
+      }
+    } else if (zone.ext_c > zone.last_ext_c) {
+      zone.up_s += span_s;
+      zone.up_low_c += zone.last_ext_c;
+      zone.up_high_c += zone.ext_c;
+      zone.swing_c += zone.ext_c - zone.last_ext_c;
+      zone.up_count++;
+    }
+  }
+  zone.last_ext_c = zone.ext_c;
+  zone.last_ext_ms = zone.ext_ms;
+  if (zone.up_count >= config.cycles && zone.down_count >= config.cycles) {
+    estimate(config, zone);
+    zone.phase = zone.result.valid ? AutotunePhase::DONE : AutotunePhase::FAILED;
+  }
+}
+
+float stepZone(const AutotuneConfig &config, AutotuneZone &zone, float temp_c, uint32_t now_ms) {
+  if (zone.phase != AutotunePhase::HEATING && zone.phase != AutotunePhase::RELAY) {
+    return 0.0f;
+  }
+  if (temp_c > config.setpoint_c + AUTOTUNE_MAX_OVERSHOOT_C) {
+    zone.phase = AutotunePhase::FAILED;
+    return 0.0f;
+  }
+  if (zone.relay_on ? temp_c < zone.ext_c : temp_c > zone.ext_c) {
+    zone.ext_c = temp_c;
+    zone.ext_ms = now_ms;
+  }
+  bool switch_off = zone.relay_on && temp_c > config.setpoint_c + config.hysteresis_c;
+  bool switch_on = !zone.relay_on && temp_c < config.setpoint_c - config.hysteresis_c;
+  if (switch_off || switch_on) {
+    confirmExtremum(config, zone, zone.relay_on);
+    if (zone.phase == AutotunePhase::DONE || zone.phase == AutotunePhase::FAILED) {
+      return 0.0f;
+    }
+    zone.phase = AutotunePhase::RELAY;
+    zone.relay_on = switch_on;
+    zone.switch_ms = now_ms;
+    zone.ext_c = temp_c;
+    zone.ext_ms = now_ms;
+  }
+  return zone.relay_on ? config.high_duty : 0.0f;
+}
+} // namespace
+
+const char *autotunePhaseName(AutotunePhase phase) {
+  switch (phase) {
+    case AutotunePhase::IDLE: return "idle";
+    case AutotunePhase::HEATING: return "heating";
+    case AutotunePhase::RELAY: return "relay";
+    case AutotunePhase::DONE: return "done";
+    case AutotunePhase::FAILED: return "failed";
+    default: return "unknown";
+  }
+}
+
+void autotuneStart(AutotuneState &state, const AutotuneConfig &config, const float *temps_c, uint8_t zones,
+                   uint32_t now_ms) {
+  state = AutotuneState{};
+  state.config = config;
+  state.config.high_duty = max(0.1f, min(config.high_duty, 1.0f));
+  state.config.cycles = max<uint8_t>(1, min(config.cycles, AUTOTUNE_MAX_CYCLES));
+  state.phase = AutotunePhase::HEATING;
+  state.start_ms = now_ms;
+  state.zone_count = zones;
+  for (uint8_t z = 0; z < zones; ++z) {
+    AutotuneZone &zone = state.zones[z];
+    zone.phase = AutotunePhase::HEATING;
+    zone.relay_on = true;
+    zone.switch_ms = now_ms;
+    zone.ambient_c = temps_c[z];
+    zone.ext_c = temps_c[z];
+    zone.ext_ms = now_ms;
+  }
+}
+
+AutotunePhase autotuneStep(AutotuneState &state, const float *temps_c, uint32_t now_ms, float *duty_out) {
+  for (uint8_t z = 0; z < state.zone_count; ++z) {
+    duty_out[z] = 0.0f;
+  }
+  if (state.phase != AutotunePhase::HEATING && state.phase != AutotunePhase::RELAY) {
+    return state.phase;
+  }
+  if (now_ms - state.start_ms > state.config.max_s * 1000) {
+    autotuneAbort(state, "TIMEOUT", now_ms);
+    return state.phase;
+  }
+  bool all_done = true;
+  bool relaying = false;
+  for (uint8_t z = 0; z < state.zone_count; ++z) {
+    AutotuneZone &zone = state.zones[z];
+    duty_out[z] = stepZone(state.config, zone, temps_c[z], now_ms);
+    if (zone.phase == AutotunePhase::FAILED) {
+      bool estimated = zone.up_count >= state.config.cycles && zone.down_count >= state.config.cycles;
+      autotuneAbort(state, estimated ? "NO_ESTIMATE" : "OVERSHOOT", now_ms);
+      for (uint8_t i = 0; i < state.zone_count; ++i) {
+        duty_out[i] = 0.0f;
+      }
+      return state.phase;
+    }
+    all_done = all_done && zone.phase == AutotunePhase::DONE;
+    relaying = relaying || zone.phase == AutotunePhase::RELAY;
+  }
+  if (all_done) {
+    state.phase = AutotunePhase::DONE;
+    state.end_ms = now_ms;
+  } else if (relaying) {
+    state.phase = AutotunePhase::RELAY;
+  }
+  return state.phase;
+}
+
+void autotuneAbort(AutotuneState &state, const char *reason, uint32_t now_ms) {
+  if (state.phase != AutotunePhase::HEATING && state.phase != AutotunePhase::RELAY) {
+    return;
+  }
+  state.phase = AutotunePhase::FAILED;
+  state.reason = reason;
+  state.end_ms = now_ms;
+}
+
+bool autotuneApply(const AutotuneState &state, ControlConfig &config) {
+  AutotuneResult sum;
+  sum.kp = sum.ki = sum.kd = sum.ff_gain = sum.ff_lead_s = 0.0f;
+  uint8_t count = 0;
+  for (uint8_t z = 0; z < state.zone_count; ++z) {
+    const AutotuneResult &result = state.zones[z].result;
+    if (!result.valid) {
+      continue;
+    }
+    sum.kp += result.kp;
+    sum.ki += result.ki;
+    sum.kd += result.kd;
+    sum.ff_gain += result.ff_gain;
+    sum.ff_lead_s += result.ff_lead_s;
+    count++;
+  }
+  if (count == 0) {
+    return false;
+  }
+  config.controller = ControllerKind::PID;
+  config.kp = sum.kp / count;
+  config.ki = sum.ki / count;
+  config.kd = sum.kd / count;
+  config.ff_gain = sum.ff_gain / count;
+  config.ff_lead_s = sum.ff_lead_s / count;
+  return true;
+}
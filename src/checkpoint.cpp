@@ -0,0 +1,116 @@
+#include "checkpoint.h"
+#include "crc32.h"
+#include "hal.h"
+#include <stddef.h>
+
+namespace {
+constexpr uint32_t kSlotMagic = 0x32435052;  // "RPC2": CheckpointZone with set_c
+
+struct Slot {
+  uint32_t magic;
+  uint32_t crc;
+  RunCheckpoint data;
+};
+static_assert(2 * sizeof(Slot) <= RETAINED_MEMORY_BYTES, "two checkpoint slots must fit the retained memory");
+
+Slot *slots() {
+  return static_cast<Slot *>(halRetainedMemory());
+}
+
+// Only the zones in use are copied and checked.
+size_t usedBytes(uint8_t zone_count) {
+  return offsetof(RunCheckpoint, zones) + zone_count * sizeof(CheckpointZone);
+}
+
+bool slotValid(const Slot &slot) {
+  return slot.magic == kSlotMagic && slot.data.zone_count <= MAX_ZONES &&
+         slot.crc == crc32(&slot.data, usedBytes(slot.data.zone_count));
+}
+} // namespace
+
+const char *resumeDecisionName(ResumeDecision decision) {
+  switch (decision) {
+    case ResumeDecision::RESUME: return "RESUME";
+    case ResumeDecision::NO_CHECKPOINT: return "NO_CHECKPOINT";
+    case ResumeDecision::DISABLED: return "DISABLED";
+    case ResumeDecision::NOT_IDLE: return "NOT_IDLE";
+    case ResumeDecision::ZONES_CHANGED: return "ZONES_CHANGED";
+    case ResumeDecision::PROFILE_MISSING: return "PROFILE_MISSING";
+    case ResumeDecision::SENSOR: return "SENSOR";
+    case ResumeDecision::OFF_PROFILE: return "OFF_PROFILE";
+    case ResumeDecision::COOLED: return "COOLED";
+    default: return "UNKNOWN";
+  }
+}
+
+void checkpointSave(RunCheckpoint &checkpoint) {
+  checkpoint.sequence++;
+  uint8_t zones = min(checkpoint.zone_count, MAX_ZONES);
+  // The slot not holding the previous tick: a reset mid-write leaves that
+  // one intact.
+  Slot &slot = slots()[checkpoint.sequence & 1];
+  slot.magic = 0;
+  memcpy(&slot.data, &checkpoint, usedBytes(zones));
+  slot.data.zone_count = zones;
+  slot.crc = crc32(&slot.data, usedBytes(zones));
+  slot.magic = kSlotMagic;
+}
+
+void checkpointClear() {
+  slots()[0].magic = 0;
+  slots()[1].magic = 0;
+}
+
+bool checkpointLoad(RunCheckpoint &out_checkpoint) {
+  const Slot *newest = nullptr;
+  for (uint8_t i = 0; i < 2; ++i) {
+    const Slot &slot = slots()[i];
+    if (slotValid(slot) && (!newest || slot.data.sequence > newest->data.sequence)) {
+      newest = &slot;
+    }
+  }
+  if (!newest) {
+    return false;
+  }
+  out_checkpoint = RunCheckpoint{};
+  memcpy(&out_checkpoint, &newest->data, usedBytes(newest->data.zone_count));
+  return true;
+}
+
+ResumeDecision resumeDecide(const ResumePolicy &policy, const RunCheckpoint &checkpoint, RunState state,
+                            uint8_t zone_count, const float *temps_c, const float *expected_c) {
+  if (!policy.enabled) {
+    return ResumeDecision::DISABLED;
+  }
+  if (state != RunState::IDLE) {
+    return ResumeDecision::NOT_IDLE;
+  }
+  if (checkpoint.zone_count != zone_count) {
+    return ResumeDecision::ZONES_CHANGED;
+  }
+  // Every zone is checked for each reason in turn, so the reported one is
+  // the most basic that applies.
+  for (uint8_t z = 0; z < zone_count; ++z) {
+    if (checkpoint.zones[z].profile[0] != '\0' && isnan(expected_c[z])) {
+      return ResumeDecision::PROFILE_MISSING;
+    }
+  }
+  for (uint8_t z = 0; z < zone_count; ++z) {
+    if (isnan(temps_c[z])) {
+      return ResumeDecision::SENSOR;
+    }
+  }
+  for (uint8_t z = 0; z < zone_count; ++z) {
+    if (checkpoint.zones[z].temp_c - temps_c[z] > policy.max_drop_c) {
+      return ResumeDecision::COOLED;
+    }
+  }
+  for (uint8_t z = 0; z < zone_count; ++z) {
+    const CheckpointZone &zone = checkpoint.zones[z];
+    float gap_c = temps_c[z] - expected_c[z];
+    if (zone.profile[0] != '\0' && fabsf(gap_c - (zone.temp_c - zone.set_c)) > policy.tolerance_c) {
+      return ResumeDecision::OFF_PROFILE;
+    }
+  }
+  return ResumeDecision::RESUME;
+}
@@ -1,45 +1,83 @@
 #include "control.h"
 #include "app_config.h"
+#include "autotune.h"
+#include "checkpoint.h"
+#include "controller.h"
+#include "hal.h"
+#include "log.h"
+#include "metrics.h"
 #include "profile.h"
-#include <Adafruit_MAX31855.h>
+#include "profile_store.h"
+#include "seqlock.h"
+#include "ssr.h"
 
 namespace {
-Adafruit_MAX31855 g_thermocouple(PIN_MAX31855_SCK, PIN_MAX31855_CS, PIN_MAX31855_MISO);
+Seqlock<ControlStatus> g_status_snapshot;
+// Written by the control task only.
+Seqlock<ControlTiming> g_timing_snapshot;
+ControlTiming g_timing;
+// Control task only: the run checkpoint refreshed every RUNNING tick.
+RunCheckpoint g_checkpoint;
+uint32_t g_checkpoint_names_version = 0;
+bool g_checkpoint_live = false;
+
+// Call with g_control_mutex held after changing g_control.status; the mutex
+// keeps seqlock writers (sensor, control and web tasks) serialized.
+void publishStatusAndUnlock() {
+  g_status_snapshot.write(g_control.status);
+  xSemaphoreGive(g_control_mutex);
+}
 
 bool isRunSwitchEnabled() {
-  int level = digitalRead(PIN_RUN_SWITCH);
+  int level = halDigitalRead(PIN_RUN_SWITCH);
   bool active_high = g_control.config.switch_active_high;
   return active_high ? (level == HIGH) : (level == LOW);
 }
 
-void setSsrOutput(bool on) {
-  bool active_high = g_control.config.ssr_active_high;
-  int level = on ? (active_high ? HIGH : LOW) : (active_high ? LOW : HIGH);
-  digitalWrite(PIN_SSR, level);
+void clearDuties() {
+  for (uint8_t z = 0; z < g_control.status.zone_count; ++z) {
+    g_control.status.duty[z] = 0.0f;
+  }
 }
 
-void pushSample(float temp_c) {
-  if (g_control.config.smooth_window == 0) {
+// Profile names change only when runs start or stop; copied before the
+// control mutex is taken (lock order).
+void refreshCheckpointNames(uint8_t zones) {
+  uint32_t version = profileActiveNameVersion();
+  if (version == g_checkpoint_names_version) {
     return;
   }
-  uint8_t window = min(g_control.config.smooth_window, MAX_SMOOTH_WINDOW);
-  g_control.temp_samples[g_control.sample_index] = temp_c;
-  g_control.sample_index = (g_control.sample_index + 1) % window;
-  if (g_control.sample_count < window) {
-    g_control.sample_count++;
+  for (uint8_t z = 0; z < zones; ++z) {
+    version = profileCopyActiveName(z, g_checkpoint.zones[z].profile, sizeof(g_checkpoint.zones[z].profile));
   }
+  g_checkpoint_names_version = version;
+}
+
+// With g_control_mutex held, once the experiment is DONE or FAILED.
+// Returns whether gains were applied.
+bool finishAutotune() {
+  g_control.status.state = RunState::IDLE;
+  clearDuties();
+  const AutotuneState &autotune = g_control.autotune;
+  return autotune.phase == AutotunePhase::DONE && autotune.config.apply &&
+         autotuneApply(autotune, g_control.config);
 }
 
-float getSmoothedTemp() {
-  uint8_t window = min(g_control.config.smooth_window, MAX_SMOOTH_WINDOW);
-  if (window <= 1 || g_control.sample_count == 0) {
-    return g_control.status.t_meas_c;
+void logAutotune(const AutotuneState &autotune, bool applied) {
+  if (autotune.phase == AutotunePhase::FAILED) {
+    logWarn(LogModule::CONTROL, "autotune failed: %s", autotune.reason);
+    return;
+  }
+  for (uint8_t z = 0; z < autotune.zone_count; ++z) {
+    const AutotuneResult &result = autotune.zones[z].result;
+    logInfo(LogModule::CONTROL, "autotune z%u ku=%.4f pu=%.1fs theta=%.1fs tau=%.0fs gain=%.0fC", z, result.ku,
+            result.pu_s, result.theta_s, result.tau_s, result.gain_c);
+    logInfo(LogModule::CONTROL, "autotune z%u kp=%.4f ki=%.5f kd=%.3f ff=%.3f@%.1fs", z, result.kp, result.ki,
+            result.kd, result.ff_gain, result.ff_lead_s);
   }
-  float sum = 0.0f;
-  for (uint8_t i = 0; i < g_control.sample_count; ++i) {
-    sum += g_control.temp_samples[i];
+  if (applied) {
+    logInfo(LogModule::CONTROL, "autotune gains applied");
   }
-  return sum / static_cast<float>(g_control.sample_count);
 }
 } // namespace
 
@@ -48,46 +86,67 @@ void controlInit() {
     g_control_mutex = xSemaphoreCreateMutex();
   }
 
-  pinMode(PIN_SSR, OUTPUT);
-  setSsrOutput(false);
-  pinMode(PIN_RUN_SWITCH, INPUT_PULLUP);
+  halInit();
+  uint8_t zones = min(halZoneCount(), MAX_ZONES);
+  ssrInit(g_control.config, zones);
+  halPinMode(PIN_RUN_SWITCH, INPUT_PULLUP);
 
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
-  g_control.window_start_ms = millis();
-  xSemaphoreGive(g_control_mutex);
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  g_control.status.zone_count = zones;
+  publishStatusAndUnlock();
+  // A checkpoint found at boot is controlResumeRun()'s to take or discard.
+  g_checkpoint = RunCheckpoint{};
+  g_checkpoint_names_version = 0;
+  g_checkpoint_live = false;
 
   profileInit();
   profileSetTempLimits(-100.0f, g_control.config.tmax_c);
 }
 
 void controlUpdateTemperature() {
-  float temp_c = g_thermocouple.readCelsius();
-  uint8_t fault = g_thermocouple.readError();
+  // zone_count is fixed after controlInit().
+  uint8_t zones = g_control.status.zone_count;
+  ThermocoupleSample samples[MAX_ZONES];
+  halReadThermocouples(samples, zones);
+  uint32_t now_ms = halMillis();
 
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
-  if (!isnan(temp_c) && fault == 0) {
-    g_control.status.t_meas_c = temp_c;
-    g_control.status.last_fault = 0;
-    pushSample(temp_c);
-  } else {
-    g_control.status.last_fault = fault == 0 ? 0xFF : fault;
-    g_control.status.state = RunState::FAULT;
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  g_control.status.last_fault = 0;
+  for (uint8_t z = 0; z < zones; ++z) {
+    const ThermocoupleSample &sample = samples[z];
+    if (!isnan(sample.temp_c) && sample.fault == 0) {
+      g_control.status.t_meas_c[z] = sample.temp_c;
+      g_control.status.zone_fault[z] = 0;
+      TempFilter &filter = g_control.filters[z];
+      filterPush(filter, g_control.config.filter, sample.temp_c, now_ms);
+      g_control.status.t_filt_c[z] = filter.temp_c;
+      g_control.status.t_rate_c_s[z] = filter.rate_c_s;
+    } else {
+      g_control.status.zone_fault[z] = sample.fault == 0 ? 0xFF : sample.fault;
+      if (g_control.status.last_fault == 0) {
+        g_control.status.last_fault = g_control.status.zone_fault[z];
+      }
+      // Any zone losing its sensor stops the whole oven.
+      g_control.status.state = RunState::FAULT;
+      autotuneAbort(g_control.autotune, "FAULT", now_ms);
+    }
   }
-  xSemaphoreGive(g_control_mutex);
+  publishStatusAndUnlock();
 }
 
 void controlUpdateState() {
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
   g_control.status.run_switch_enabled = isRunSwitchEnabled();
 
   if (!g_control.status.run_switch_enabled) {
     g_control.status.state = RunState::SWITCH_DISABLED;
-    xSemaphoreGive(g_control_mutex);
+    autotuneAbort(g_control.autotune, "SWITCH_DISABLED", halMillis());
+    publishStatusAndUnlock();
     return;
   }
 
   if (g_control.status.state == RunState::FAULT) {
-    xSemaphoreGive(g_control_mutex);
+    publishStatusAndUnlock();
     return;
   }
 
@@ -96,79 +155,123 @@ void controlUpdateState() {
     g_control.status.state = RunState::IDLE;
   }
 
-  xSemaphoreGive(g_control_mutex);
+  publishStatusAndUnlock();
 }
 
 void controlComputeControl() {
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
-  if (g_control.status.state != RunState::RUNNING) {
-    g_control.status.duty = 0.0f;
-    xSemaphoreGive(g_control_mutex);
-    return;
-  }
+  uint8_t zones = g_control.status.zone_count;
+  ProfileSetpoint setpoints[MAX_ZONES];
+  uint32_t now_ms = halMillis();
+  // The profile lock is never taken inside the control mutex, so the lead
+  // is read without it (one aligned 32-bit load).
+  uint32_t lookahead_ms = static_cast<uint32_t>(g_control.config.ff_lead_s * 1000.0f);
+  profileGetSetpoints(now_ms, lookahead_ms, setpoints, zones);
+  refreshCheckpointNames(zones);
 
-  float t_meas = getSmoothedTemp();
-  if (isnan(t_meas)) {
-    g_control.status.state = RunState::FAULT;
-    g_control.status.duty = 0.0f;
-    xSemaphoreGive(g_control_mutex);
-    return;
-  }
-
-  if (t_meas >= g_control.config.tmax_c) {
-    g_control.status.state = RunState::FAULT;
-    g_control.status.duty = 0.0f;
-    xSemaphoreGive(g_control_mutex);
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  bool autotune = g_control.status.state == RunState::AUTOTUNE;
+  if (g_control.status.state != RunState::RUNNING && !autotune) {
+    clearDuties();
+    publishStatusAndUnlock();
+    if (g_checkpoint_live) {
+      checkpointClear();
+      g_checkpoint_live = false;
+    }
     return;
   }
 
-  ProfileSetpoint setpoint = profileGetSetpoint(millis());
-  if (setpoint.active) {
-    g_control.status.t_set_c = setpoint.setpoint_c;
-    if (setpoint.completed && setpoint.end_behavior == EndBehavior::STOP) {
-      g_control.status.state = RunState::IDLE;
-      g_control.status.duty = 0.0f;
-      xSemaphoreGive(g_control_mutex);
+  // Safety first: one bad or overheated zone faults the whole oven.
+  float t_meas[MAX_ZONES];
+  for (uint8_t z = 0; z < zones; ++z) {
+    t_meas[z] = g_control.status.t_filt_c[z];
+    if (isnan(t_meas[z]) || t_meas[z] >= g_control.config.tmax_c) {
+      g_control.status.state = RunState::FAULT;
+      autotuneAbort(g_control.autotune, "FAULT", now_ms);
+      clearDuties();
+      publishStatusAndUnlock();
       return;
     }
-  } else {
-    g_control.status.t_set_c = g_control.config.setpoint_c;
   }
-  float error = g_control.status.t_set_c - t_meas;
-  float u = g_control.config.kp * error + g_control.config.bias;
-  if (u < 0.0f) u = 0.0f;
-  if (u > 1.0f) u = 1.0f;
-  g_control.status.duty = u;
-  xSemaphoreGive(g_control_mutex);
-}
 
-void controlUpdateSsrOutput(uint32_t now_ms) {
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
-  if (g_control.status.state != RunState::RUNNING) {
-    xSemaphoreGive(g_control_mutex);
-    setSsrOutput(false);
+  if (autotune) {
+    AutotunePhase phase = autotuneStep(g_control.autotune, t_meas, now_ms, g_control.status.duty);
+    for (uint8_t z = 0; z < zones; ++z) {
+      g_control.status.t_set_c[z] = g_control.autotune.config.setpoint_c;
+    }
+    bool finished = phase == AutotunePhase::DONE || phase == AutotunePhase::FAILED;
+    bool applied = finished && finishAutotune();
+    AutotuneState result;
+    if (finished) {
+      result = g_control.autotune;
+    }
+    publishStatusAndUnlock();
+    if (finished) {
+      logAutotune(result, applied);
+    }
     return;
   }
 
-  if (now_ms - g_control.window_start_ms >= g_control.config.window_ms) {
-    g_control.window_start_ms = now_ms;
+  // The run ends once every zone has a profile that finished with STOP;
+  // a zone that finishes early idles while the others continue.
+  bool all_stopped = true;
+  for (uint8_t z = 0; z < zones; ++z) {
+    const ProfileSetpoint &setpoint = setpoints[z];
+    if (!setpoint.active) {
+      g_control.status.t_set_c[z] = g_control.config.setpoint_c;
+      all_stopped = false;
+    } else {
+      g_control.status.t_set_c[z] = setpoint.setpoint_c;
+      if (setpoint.completed && setpoint.end_behavior == EndBehavior::STOP) {
+        g_control.status.duty[z] = 0.0f;
+        continue;
+      }
+      all_stopped = false;
+    }
+    ControllerInput input;
+    input.setpoint_c = g_control.status.t_set_c[z];
+    input.slope_c_s = setpoint.active ? setpoint.slope_c_s : 0.0f;
+    input.meas_c = t_meas[z];
+    input.rate_c_s = g_control.status.t_rate_c_s[z];
+    input.now_ms = now_ms;
+    g_control.status.duty[z] = controllerStep(g_control.controllers[z], g_control.config, input);
   }
-
-  uint32_t on_time_ms = static_cast<uint32_t>(g_control.status.duty * g_control.config.window_ms);
-  if (on_time_ms > 0 && g_control.config.min_on_ms > 0 && on_time_ms < g_control.config.min_on_ms) {
-    on_time_ms = g_control.config.min_on_ms;
+  if (all_stopped) {
+    g_control.status.state = RunState::IDLE;
+    clearDuties();
+  } else {
+    g_checkpoint.zone_count = zones;
+    g_checkpoint.controller = g_control.config.controller;
+    for (uint8_t z = 0; z < zones; ++z) {
+      CheckpointZone &zone = g_checkpoint.zones[z];
+      zone.elapsed_ms = setpoints[z].elapsed_ms;
+      zone.integral = g_control.controllers[z].integral;
+      zone.temp_c = t_meas[z];
+      zone.set_c = g_control.status.t_set_c[z];
+    }
   }
-  if (on_time_ms < g_control.config.window_ms && g_control.config.min_off_ms > 0) {
-    uint32_t off_time_ms = g_control.config.window_ms - on_time_ms;
-    if (off_time_ms < g_control.config.min_off_ms) {
-      on_time_ms = g_control.config.window_ms - g_control.config.min_off_ms;
+  publishStatusAndUnlock();
+  if (!all_stopped) {
+    // Slots of an earlier run may hold higher sequence numbers.
+    if (!g_checkpoint_live) {
+      checkpointClear();
+      g_checkpoint_live = true;
     }
+    checkpointSave(g_checkpoint);
   }
+}
 
-  uint32_t elapsed_ms = now_ms - g_control.window_start_ms;
-  bool ssr_on = elapsed_ms < on_time_ms;
+void controlUpdateSsrOutput() {
+  float duty[MAX_ZONES];
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  bool running = g_control.status.state == RunState::RUNNING || g_control.status.state == RunState::AUTOTUNE;
+  uint8_t zones = g_control.status.zone_count;
+  for (uint8_t z = 0; z < zones; ++z) {
+    duty[z] = running ? g_control.status.duty[z] : 0.0f;
+  }
   xSemaphoreGive(g_control_mutex);
-  setSsrOutput(ssr_on);
+  for (uint8_t z = 0; z < zones; ++z) {
+    ssrSetDuty(z, duty[z]);
+  }
 }
 
 void controlLogStatus(uint32_t now_ms) {
@@ -178,55 +281,174 @@ void controlLogStatus(uint32_t now_ms) {
   }
   last_log_ms = now_ms;
 
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
-  Serial.print("state=");
-  Serial.print(static_cast<int>(g_control.status.state));
-  Serial.print(" t=");
-  Serial.print(g_control.status.t_meas_c, 2);
-  Serial.print(" set=");
-  Serial.print(g_control.status.t_set_c, 2);
-  Serial.print(" duty=");
-  Serial.print(g_control.status.duty, 3);
-  Serial.print(" delta=");
-  Serial.print(g_control.status.t_set_c - g_control.status.t_meas_c, 2);
-  Serial.print(" switch=");
-  Serial.print(g_control.status.run_switch_enabled ? "EN" : "DIS");
-  Serial.print(" fault=");
-  Serial.println(g_control.status.last_fault, HEX);
+  ControlStatus status;
+  g_status_snapshot.read(status);
+  ControlTiming timing;
+  g_timing_snapshot.read(timing);
+  logInfo(LogModule::CONTROL, "state=%d switch=%s fault=%x lat_us=%u miss=%u", static_cast<int>(status.state),
+          status.run_switch_enabled ? "EN" : "DIS", status.last_fault, timing.last_latency_us,
+          timing.deadline_misses);
+  for (uint8_t z = 0; z < status.zone_count; ++z) {
+    logInfo(LogModule::CONTROL, "z%u t=%.2f set=%.2f duty=%.3f", z, status.t_meas_c[z], status.t_set_c[z],
+            status.duty[z]);
+  }
+}
+
+void controlSetFilter(const FilterConfig &config) {
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  g_control.config.filter = filterSanitize(config);
   xSemaphoreGive(g_control_mutex);
 }
 
 bool controlTryStartRun() {
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
   if (!g_control.status.run_switch_enabled) {
     g_control.status.state = RunState::SWITCH_DISABLED;
-    xSemaphoreGive(g_control_mutex);
+    publishStatusAndUnlock();
     return false;
   }
   if (g_control.status.state == RunState::FAULT) {
-    xSemaphoreGive(g_control_mutex);
+    publishStatusAndUnlock();
     return false;
   }
   g_control.status.state = RunState::RUNNING;
-  xSemaphoreGive(g_control_mutex);
+  for (ControllerState &controller : g_control.controllers) {
+    controllerReset(controller, g_control.config.controller);
+  }
+  publishStatusAndUnlock();
+  return true;
+}
+
+bool controlStartAutotune(const AutotuneConfig &config, const char *&error) {
+  error = nullptr;
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  uint8_t zones = g_control.status.zone_count;
+  if (!g_control.status.run_switch_enabled) {
+    error = "SWITCH_DISABLED";
+  } else if (g_control.status.state != RunState::IDLE) {
+    error = "BUSY";
+  } else if (!(config.hysteresis_c > 0.0f) ||
+             !(config.setpoint_c <= g_control.config.tmax_c - AUTOTUNE_TMAX_MARGIN_C)) {
+    error = "BAD_SETPOINT";
+  }
+  for (uint8_t z = 0; !error && z < zones; ++z) {
+    // The relay starts on; the temperature at start stands in for ambient.
+    float temp_c = g_control.status.t_filt_c[z];
+    if (isnan(temp_c) || temp_c > config.setpoint_c - 2.0f * config.hysteresis_c) {
+      error = "TOO_HOT";
+    }
+  }
+  if (error) {
+    xSemaphoreGive(g_control_mutex);
+    return false;
+  }
+  autotuneStart(g_control.autotune, config, g_control.status.t_filt_c, zones, halMillis());
+  g_control.status.state = RunState::AUTOTUNE;
+  publishStatusAndUnlock();
+  logInfo(LogModule::CONTROL, "autotune start set=%.1f hyst=%.2f cycles=%u", config.setpoint_c,
+          config.hysteresis_c, config.cycles);
   return true;
 }
 
+void controlGetAutotune(AutotuneState &out_state) {
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  out_state = g_control.autotune;
+  xSemaphoreGive(g_control_mutex);
+}
+
+ResumeDecision controlResumeRun(const ResumePolicy &policy) {
+  RunCheckpoint checkpoint;
+  if (!checkpointLoad(checkpoint)) {
+    return ResumeDecision::NO_CHECKPOINT;
+  }
+  ControlStatus status;
+  controlGetStatus(status);
+  uint8_t zones = status.zone_count;
+  // Each zone's profile restarts at its checkpointed time; the setpoint
+  // there is what the temperature is judged against.
+  bool start = policy.enabled && checkpoint.zone_count == zones;
+  for (uint8_t z = 0; start && z < zones; ++z) {
+    const CheckpointZone &zone = checkpoint.zones[z];
+    if (zone.profile[0] != '\0') {
+      profileStartRun(z, zone.profile, zone.elapsed_ms);
+    }
+  }
+  ProfileSetpoint setpoints[MAX_ZONES];
+  profileGetSetpoints(halMillis(), 0, setpoints, zones);
+  float expected[MAX_ZONES];
+  for (uint8_t z = 0; z < zones; ++z) {
+    expected[z] = setpoints[z].active ? setpoints[z].setpoint_c : NAN;
+  }
+  ResumeDecision decision = resumeDecide(policy, checkpoint, status.state, zones, status.t_filt_c, expected);
+
+  if (decision == ResumeDecision::RESUME) {
+    metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+    if (g_control.status.state == RunState::IDLE) {
+      g_control.status.state = RunState::RUNNING;
+      for (uint8_t z = 0; z < zones; ++z) {
+        ControllerState &controller = g_control.controllers[z];
+        controllerReset(controller, g_control.config.controller);
+        if (checkpoint.controller == g_control.config.controller) {
+          controller.integral = checkpoint.zones[z].integral;
+        }
+      }
+    } else {
+      decision = ResumeDecision::NOT_IDLE;
+    }
+    publishStatusAndUnlock();
+  }
+  if (decision == ResumeDecision::RESUME) {
+    logInfo(LogModule::CONTROL, "resumed %s at %.1fs (checkpoint %lu)", checkpoint.zones[0].profile,
+            checkpoint.zones[0].elapsed_ms / 1000.0f, static_cast<unsigned long>(checkpoint.sequence));
+  } else {
+    profileClearActive();
+    checkpointClear();
+    logWarn(LogModule::CONTROL, "run checkpoint not resumed: %s", resumeDecisionName(decision));
+  }
+  return decision;
+}
+
 void controlStopRun() {
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
+  metricsTake(g_control_mutex, Metric::LOCK_CONTROL);
+  autotuneAbort(g_control.autotune, "STOPPED", halMillis());
   g_control.status.state = g_control.status.run_switch_enabled ? RunState::IDLE
                                                                : RunState::SWITCH_DISABLED;
-  g_control.status.duty = 0.0f;
+  clearDuties();
   if (g_control.status.state != RunState::FAULT) {
     g_control.status.last_fault = 0;
   }
-  xSemaphoreGive(g_control_mutex);
-  setSsrOutput(false);
+  publishStatusAndUnlock();
+  ssrStop();
   profileClearActive();
 }
 
-void controlGetStatus(ControlStatus &out_status) {
-  xSemaphoreTake(g_control_mutex, portMAX_DELAY);
-  out_status = g_control.status;
-  xSemaphoreGive(g_control_mutex);
+uint32_t controlGetStatus(ControlStatus &out_status) {
+  return g_status_snapshot.read(out_status);
+}
+
+void controlRecordTiming(uint32_t sample_us, bool fresh_sample) {
+  uint32_t latency_us = halMicros() - sample_us;
+  g_timing.ticks++;
+  if (g_timing.ticks == 1) {
+    g_timing.first_tick_us = halMicros();
+  }
+  g_timing.last_latency_us = latency_us;
+  metricsObserve(Metric::CONTROL_LATENCY, latency_us);
+  if (latency_us > g_timing.max_latency_us) {
+    g_timing.max_latency_us = latency_us;
+  }
+  g_timing.avg_latency_us = g_timing.ticks == 1
+                                ? latency_us
+                                : g_timing.avg_latency_us + (static_cast<int32_t>(latency_us - g_timing.avg_latency_us) >> 4);
+  if (latency_us > CONTROL_DEADLINE_US) {
+    g_timing.deadline_misses++;
+  }
+  if (!fresh_sample) {
+    g_timing.stale_ticks++;
+  }
+  g_timing_snapshot.write(g_timing);
+}
+
+void controlGetTiming(ControlTiming &out_timing) {
+  g_timing_snapshot.read(out_timing);
 }
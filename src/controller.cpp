@@ -0,0 +1,76 @@
+#include "controller.h"
+#include "app_state.h"
+
+namespace {
+// Smoothing of the controller's own dT/dt (first difference of the
+// measurement) when the filter's rate stage is off.
+constexpr float kRateAlpha = 0.25f;
+
+float clampDuty(float u) {
+  if (u < 0.0f) return 0.0f;
+  if (u > 1.0f) return 1.0f;
+  return u;
+}
+
+float measurementRate(ControllerState &state, const ControllerInput &input, float dt_s) {
+  if (!isnan(input.rate_c_s)) {
+    return input.rate_c_s;
+  }
+  if (!isnan(state.last_meas_c) && dt_s > 0.0f) {
+    float raw = (input.meas_c - state.last_meas_c) / dt_s;
+    state.rate_c_s += kRateAlpha * (raw - state.rate_c_s);
+  }
+  return state.rate_c_s;
+}
+
+float stepPid(ControllerState &state, const ControlConfig &config, float error, float feedforward, float rate,
+              float dt_s) {
+  float base = config.kp * error - config.kd * rate + feedforward + config.bias;
+  float u = base + state.integral;
+  float clamped = clampDuty(u);
+  if (config.anti_windup == AntiWindup::BACK_CALCULATION) {
+    state.integral += (config.ki * error + config.kb * (clamped - u)) * dt_s;
+  } else if (u == clamped || (u > 1.0f && error < 0.0f) || (u < 0.0f && error > 0.0f)) {
+    state.integral += config.ki * error * dt_s;
+  }
+  // I alone never needs to hold more than the full duty range.
+  state.integral = max(-1.0f, min(state.integral, 1.0f));
+  return clampDuty(base + state.integral);
+}
+} // namespace
+
+const char *controllerName(ControllerKind kind) {
+  switch (kind) {
+    case ControllerKind::P: return "p";
+    case ControllerKind::PID: return "pid";
+    default: return "unknown";
+  }
+}
+
+void controllerReset(ControllerState &state, ControllerKind kind) {
+  state = ControllerState{};
+  state.applied = kind;
+}
+
+float controllerStep(ControllerState &state, const ControlConfig &config, const ControllerInput &input) {
+  if (state.applied != config.controller) {
+    controllerReset(state, config.controller);
+  }
+  // The first step after a (re)start has no interval to integrate over.
+  float dt_s = state.primed ? (input.now_ms - state.last_ms) / 1000.0f : 0.0f;
+  float error = input.setpoint_c - input.meas_c;
+  float feedforward = config.ff_gain * input.slope_c_s;
+  float u = 0.0f;
+  switch (state.applied) {
+    case ControllerKind::PID:
+      u = stepPid(state, config, error, feedforward, measurementRate(state, input, dt_s), dt_s);
+      break;
+    default:
+      u = clampDuty(config.kp * error + feedforward + config.bias);
+      break;
+  }
+  state.primed = true;
+  state.last_ms = input.now_ms;
+  state.last_meas_c = input.meas_c;
+  return u;
+}
@@ -0,0 +1,120 @@
+#include "filter.h"
+
+namespace {
+bool sameConfig(const FilterConfig &a, const FilterConfig &b) {
+  return a.median_window == b.median_window && a.smoothing == b.smoothing &&
+         a.average_window == b.average_window && a.ema_alpha == b.ema_alpha && a.rate_window == b.rate_window;
+}
+
+float medianStage(TempFilter &filter, float temp_c) {
+  uint8_t window = filter.applied.median_window;
+  if (window <= 1) {
+    return temp_c;
+  }
+  // The sorted copy drops the sample leaving the window and takes the new
+  // one by insertion, so no full sort per sample.
+  uint8_t count = filter.median_count;
+  if (count == window) {
+    float oldest = filter.median_ring[filter.median_index];
+    uint8_t i = 0;
+    while (i + 1 < count && filter.median_sorted[i] != oldest) {
+      ++i;
+    }
+    for (; i + 1 < count; ++i) {
+      filter.median_sorted[i] = filter.median_sorted[i + 1];
+    }
+    count--;
+  }
+  uint8_t i = count;
+  while (i > 0 && filter.median_sorted[i - 1] > temp_c) {
+    filter.median_sorted[i] = filter.median_sorted[i - 1];
+    --i;
+  }
+  filter.median_sorted[i] = temp_c;
+  filter.median_count = count + 1;
+  filter.median_ring[filter.median_index] = temp_c;
+  filter.median_index = (filter.median_index + 1) % window;
+  return filter.median_sorted[filter.median_count / 2];
+}
+
+float averageStage(TempFilter &filter, float temp_c) {
+  uint8_t window = filter.applied.average_window;
+  if (window <= 1) {
+    return temp_c;
+  }
+  if (filter.average_count == window) {
+    filter.average_sum -= filter.average_ring[filter.average_index];
+  } else {
+    filter.average_count++;
+  }
+  filter.average_ring[filter.average_index] = temp_c;
+  filter.average_sum += temp_c;
+  filter.average_index = (filter.average_index + 1) % window;
+  if (filter.average_index == 0) {
+    // Re-sum once per window so float rounding cannot accumulate.
+    filter.average_sum = 0.0f;
+    for (uint8_t i = 0; i < filter.average_count; ++i) {
+      filter.average_sum += filter.average_ring[i];
+    }
+  }
+  return filter.average_sum / filter.average_count;
+}
+
+float smoothingStage(TempFilter &filter, float temp_c) {
+  switch (filter.applied.smoothing) {
+    case FilterSmoothing::MOVING_AVERAGE:
+      return averageStage(filter, temp_c);
+    case FilterSmoothing::EMA:
+      return filter.primed ? filter.temp_c + filter.applied.ema_alpha * (temp_c - filter.temp_c) : temp_c;
+    default:
+      return temp_c;
+  }
+}
+
+void rateStage(TempFilter &filter, float temp_c, uint32_t now_ms) {
+  uint8_t window = filter.applied.rate_window;
+  if (window == 0) {
+    return;
+  }
+  // rate_window + 1 slots: the slope spans rate_window sample intervals.
+  uint8_t slots = window + 1;
+  filter.rate_value[filter.rate_index] = temp_c;
+  filter.rate_ms[filter.rate_index] = now_ms;
+  filter.rate_index = (filter.rate_index + 1) % slots;
+  if (filter.rate_count < slots) {
+    filter.rate_count++;
+  }
+  uint8_t oldest = filter.rate_count < slots ? 0 : filter.rate_index;
+  uint32_t span_ms = now_ms - filter.rate_ms[oldest];
+  filter.rate_c_s = span_ms > 0 ? (temp_c - filter.rate_value[oldest]) * 1000.0f / span_ms : NAN;
+}
+} // namespace
+
+FilterConfig filterSanitize(const FilterConfig &config) {
+  FilterConfig out = config;
+  out.median_window = max<uint8_t>(1, min(out.median_window, MAX_MEDIAN_WINDOW));
+  if (out.median_window % 2 == 0) {
+    out.median_window--;
+  }
+  out.average_window = max<uint8_t>(1, min(out.average_window, MAX_SMOOTH_WINDOW));
+  if (!(out.ema_alpha > 0.0f) || out.ema_alpha > 1.0f) {
+    out.ema_alpha = 1.0f;
+  }
+  out.rate_window = min(out.rate_window, MAX_RATE_WINDOW);
+  return out;
+}
+
+void filterReset(TempFilter &filter, const FilterConfig &config) {
+  filter = TempFilter{};
+  filter.applied = filterSanitize(config);
+}
+
+void filterPush(TempFilter &filter, const FilterConfig &config, float temp_c, uint32_t now_ms) {
+  if (!sameConfig(filter.applied, filterSanitize(config))) {
+    filterReset(filter, config);
+  }
+  float value = smoothingStage(filter, medianStage(filter, temp_c));
+  filter.temp_c = value;
+  filter.primed = true;
+  rateStage(filter, value, now_ms);
+}
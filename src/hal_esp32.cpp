@@ -0,0 +1,130 @@
+#include "hal.h"
+#include "app_config.h"
+#include "log.h"
+#include "max31855.h"
+#include <driver/spi_master.h>
+
+namespace {
+// MAX31855 chips on the VSPI peripheral, one per zone on a shared bus. Chip
+// selects are plain GPIOs (the peripheral has only three hardware CS lines);
+// one 32-bit transaction per chip carries temperature, cold junction and
+// fault bits.
+constexpr spi_host_device_t kThermocoupleHost = SPI3_HOST;
+constexpr int kThermocoupleClockHz = 4000000;  // MAX31855 max 5 MHz
+
+spi_device_handle_t g_thermocouple = nullptr;
+hw_timer_t *g_timer = nullptr;
+// Not touched by the startup code, so it outlives brownout and watchdog resets.
+RTC_NOINIT_ATTR uint32_t g_retained[RETAINED_MEMORY_BYTES / 4];
+
+bool initThermocoupleSpi() {
+  spi_bus_config_t bus{};
+  bus.mosi_io_num = -1;
+  bus.miso_io_num = PIN_MAX31855_MISO;
+  bus.sclk_io_num = PIN_MAX31855_SCK;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = 4;
+  if (spi_bus_initialize(kThermocoupleHost, &bus, MAX31855_SPI_DMA ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED) != ESP_OK) {
+    return false;
+  }
+
+  spi_device_interface_config_t device{};
+  device.mode = 0;
+  device.clock_speed_hz = kThermocoupleClockHz;
+  device.spics_io_num = -1;
+  device.queue_size = 1;
+  return spi_bus_add_device(kThermocoupleHost, &device, &g_thermocouple) == ESP_OK;
+}
+
+ThermocoupleSample readFrame(int cs_pin) {
+  ThermocoupleSample sample;
+  spi_transaction_t transaction{};
+  transaction.flags = SPI_TRANS_USE_RXDATA;
+  transaction.length = 32;
+  digitalWrite(cs_pin, LOW);
+  esp_err_t err = spi_device_polling_transmit(g_thermocouple, &transaction);
+  digitalWrite(cs_pin, HIGH);
+  if (err != ESP_OK) {
+    sample.fault = 0xFF;
+    return sample;
+  }
+  const uint8_t *rx = transaction.rx_data;
+  uint32_t frame = (static_cast<uint32_t>(rx[0]) << 24) | (static_cast<uint32_t>(rx[1]) << 16) |
+                   (static_cast<uint32_t>(rx[2]) << 8) | rx[3];
+  Max31855Reading reading = max31855Decode(frame);
+  sample.temp_c = reading.temp_c;
+  sample.cold_junction_c = reading.cold_junction_c;
+  sample.fault = reading.fault;
+  return sample;
+}
+} // namespace
+
+void halInit() {
+  for (const ZonePins &zone : ZONE_PINS) {
+    pinMode(zone.cs, OUTPUT);
+    digitalWrite(zone.cs, HIGH);
+    pinMode(zone.ssr, OUTPUT);
+  }
+  if (!g_thermocouple && !initThermocoupleSpi()) {
+    logError(LogModule::SENSOR, "MAX31855 SPI init failed");
+  }
+}
+
+uint32_t halMillis() {
+  return millis();
+}
+
+uint32_t halMicros() {
+  return micros();
+}
+
+void halPinMode(uint8_t pin, uint8_t mode) {
+  pinMode(pin, mode);
+}
+
+int halDigitalRead(uint8_t pin) {
+  return digitalRead(pin);
+}
+
+void halDigitalWrite(uint8_t pin, uint8_t level) {
+  digitalWrite(pin, level);
+}
+
+uint8_t halZoneCount() {
+  return ZONE_COUNT;
+}
+
+void halReadThermocouples(ThermocoupleSample *out_samples, uint8_t count) {
+  count = min(count, ZONE_COUNT);
+  if (!g_thermocouple || spi_device_acquire_bus(g_thermocouple, portMAX_DELAY) != ESP_OK) {
+    for (uint8_t z = 0; z < count; ++z) {
+      out_samples[z] = ThermocoupleSample{};
+      out_samples[z].fault = 0xFF;
+    }
+    return;
+  }
+  for (uint8_t z = 0; z < count; ++z) {
+    out_samples[z] = readFrame(ZONE_PINS[z].cs);
+  }
+  spi_device_release_bus(g_thermocouple);
+}
+
+void halSetSsr(uint8_t zone, uint8_t level) {
+  if (zone < ZONE_COUNT) {
+    digitalWrite(ZONE_PINS[zone].ssr, level);
+  }
+}
+
+void *halRetainedMemory() {
+  return g_retained;
+}
+
+void halStartTimer(uint32_t period_us, void (*callback)()) {
+  if (g_timer) {
+    return;
+  }
+  g_timer = timerBegin(1000000);
+  timerAttachInterrupt(g_timer, callback);
+  timerAlarm(g_timer, period_us, true, 0);
+}
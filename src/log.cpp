@@ -0,0 +1,228 @@
+#include "log.h"
+#include "app_config.h"
+#include "hal.h"
+#include <atomic>
+
+namespace {
+constexpr uint8_t kModuleCount = static_cast<uint8_t>(LogModule::COUNT);
+static_assert((LOG_RING_RECORDS & (LOG_RING_RECORDS - 1)) == 0, "LOG_RING_RECORDS must be a power of two");
+constexpr uint32_t kRingMask = LOG_RING_RECORDS - 1;
+
+// Bounded multi-producer ring (Vyukov): a slot is free for the producer
+// holding ticket pos when seq == pos, and readable when seq == pos + 1. The
+// single consumer (logProcess) hands it back with seq = pos + size.
+struct Slot {
+  std::atomic<uint32_t> seq;
+  LogRecord record;
+};
+
+struct Ring {
+  Slot slots[LOG_RING_RECORDS];
+  std::atomic<uint32_t> head{0};
+  uint32_t tail = 0;  // consumer only
+
+  Ring() {
+    for (uint32_t i = 0; i < LOG_RING_RECORDS; ++i) {
+      slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+};
+Ring g_ring;
+
+struct Levels {
+  std::atomic<uint8_t> level[kModuleCount];
+
+  Levels() {
+    for (uint8_t i = 0; i < kModuleCount; ++i) {
+      level[i].store(static_cast<uint8_t>(LOG_DEFAULT_LEVEL), std::memory_order_relaxed);
+    }
+  }
+};
+Levels g_levels;
+std::atomic<uint32_t> g_dropped[kModuleCount];
+
+const char *const kModuleNames[kModuleCount] = {"system", "control", "sensor", "profile",
+                                                "storage", "runlog", "web"};
+const char *const kLevelNames[] = {"debug", "info", "warn", "error", "off"};
+
+void serialSink(const char *line, size_t len) {
+  (void)len;
+  Serial.print(line);
+}
+
+LogSink g_sink = serialSink;
+
+// printf over the record's typed arguments: each conversion is formatted on
+// its own with the spec copied from the format (length modifiers dropped).
+size_t formatRecord(const LogRecord &record, char *out, size_t cap) {
+  size_t len = 0;
+  uint8_t arg = 0;
+  auto put = [&](int n) {
+    if (n > 0) {
+      len = min(len + static_cast<size_t>(n), cap - 1);
+    }
+  };
+  for (const char *p = record.format; *p && len + 1 < cap; ++p) {
+    if (*p != '%') {
+      out[len++] = *p;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[len++] = '%';
+      ++p;
+      continue;
+    }
+    char spec[16];
+    uint8_t spec_len = 0;
+    spec[spec_len++] = *p++;
+    while (*p && !strchr("diuxXfgecsp", *p)) {
+      if (!strchr("lhzjt", *p) && spec_len < sizeof(spec) - 2) {
+        spec[spec_len++] = *p;
+      }
+      ++p;
+    }
+    if (!*p) {
+      break;
+    }
+    char conv = *p;
+    spec[spec_len++] = conv;
+    spec[spec_len] = '\0';
+    if (arg >= record.argc) {
+      put(snprintf(out + len, cap - len, "?"));
+      continue;
+    }
+    LogArgType type = record.types[arg];
+    const auto &value = record.args[arg++];
+    char *dst = out + len;
+    size_t room = cap - len;
+    if (type == LogArgType::TEXT) {
+      put(snprintf(dst, room, conv == 's' ? spec : "%s", record.text + value.u));
+    } else if (conv == 'f' || conv == 'g' || conv == 'e') {
+      double v = type == LogArgType::F32 ? value.f : type == LogArgType::I32 ? value.i : value.u;
+      put(snprintf(dst, room, spec, v));
+    } else if (type == LogArgType::F32) {
+      put(snprintf(dst, room, "%g", value.f));
+    } else if (conv == 'd' || conv == 'i' || conv == 'c') {
+      put(snprintf(dst, room, spec, static_cast<int>(value.i)));
+    } else {
+      put(snprintf(dst, room, spec, static_cast<unsigned>(value.u)));
+    }
+  }
+  out[len] = '\0';
+  return len;
+}
+} // namespace
+
+namespace log_detail {
+void encode(LogRecord &r, uint8_t i, const char *v) {
+  r.types[i] = LogArgType::TEXT;
+  r.args[i].u = r.text_len;
+  if (r.text_len >= kLogTextBytes) {
+    r.args[i].u = kLogTextBytes - 1;  // the terminating NUL: empty
+    return;
+  }
+  size_t room = kLogTextBytes - r.text_len;
+  size_t n = strnlen(v ? v : "", room - 1);
+  memcpy(r.text + r.text_len, v ? v : "", n);
+  r.text[r.text_len + n] = '\0';
+  r.text_len += n + 1;
+}
+} // namespace log_detail
+
+void logSetSink(LogSink sink) {
+  g_sink = sink ? sink : serialSink;
+}
+
+void logSetLevel(LogModule module, LogLevel level) {
+  if (module < LogModule::COUNT) {
+    g_levels.level[static_cast<uint8_t>(module)].store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+  }
+}
+
+LogLevel logGetLevel(LogModule module) {
+  return static_cast<LogLevel>(g_levels.level[static_cast<uint8_t>(module)].load(std::memory_order_relaxed));
+}
+
+bool logEnabled(LogModule module, LogLevel level) {
+  return level != LogLevel::OFF && level >= logGetLevel(module);
+}
+
+uint32_t logDropped(LogModule module) {
+  return g_dropped[static_cast<uint8_t>(module)].load(std::memory_order_relaxed);
+}
+
+const char *logModuleName(LogModule module) {
+  return module < LogModule::COUNT ? kModuleNames[static_cast<uint8_t>(module)] : "?";
+}
+
+const char *logLevelName(LogLevel level) {
+  return level <= LogLevel::OFF ? kLevelNames[static_cast<uint8_t>(level)] : "?";
+}
+
+bool logParseModule(const char *name, LogModule &out_module) {
+  for (uint8_t i = 0; i < kModuleCount; ++i) {
+    if (strcmp(name, kModuleNames[i]) == 0) {
+      out_module = static_cast<LogModule>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool logParseLevel(const char *name, LogLevel &out_level) {
+  for (uint8_t i = 0; i <= static_cast<uint8_t>(LogLevel::OFF); ++i) {
+    if (strcmp(name, kLevelNames[i]) == 0) {
+      out_level = static_cast<LogLevel>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool logSubmit(const LogRecord &record) {
+  uint32_t pos = g_ring.head.load(std::memory_order_relaxed);
+  Slot *slot;
+  for (;;) {
+    slot = &g_ring.slots[pos & kRingMask];
+    uint32_t seq = slot->seq.load(std::memory_order_acquire);
+    int32_t diff = static_cast<int32_t>(seq - pos);
+    if (diff == 0) {
+      if (g_ring.head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      g_dropped[static_cast<uint8_t>(record.module)].fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = g_ring.head.load(std::memory_order_relaxed);
+    }
+  }
+  slot->record = record;
+  slot->record.t_ms = halMillis();
+  slot->seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+uint32_t logProcess() {
+  uint32_t written = 0;
+  char line[160];
+  for (;;) {
+    Slot &slot = g_ring.slots[g_ring.tail & kRingMask];
+    if (slot.seq.load(std::memory_order_acquire) != g_ring.tail + 1) {
+      break;
+    }
+    LogRecord record = slot.record;
+    slot.seq.store(g_ring.tail + LOG_RING_RECORDS, std::memory_order_release);
+    g_ring.tail++;
+
+    int n = snprintf(line, sizeof(line), "%lu %s %s: ", static_cast<unsigned long>(record.t_ms),
+                     logLevelName(record.level), logModuleName(record.module));
+    size_t len = n > 0 ? static_cast<size_t>(n) : 0;
+    len += formatRecord(record, line + len, sizeof(line) - len - 1);
+    line[len++] = '\n';
+    line[len] = '\0';
+    g_sink(line, len);
+    written++;
+  }
+  return written;
+}
@@ -1,49 +1,187 @@
 #include <Arduino.h>
 #include "app_config.h"
 #include "control.h"
+#include "hal.h"
+#include "log.h"
+#include "metrics.h"
+#include "network.h"
+#include "profile.h"
+#include "profile_store.h"
+#include "runlog.h"
+#include "storage.h"
+#include "telemetry.h"
 #include "web_api.h"
 
 namespace {
+TaskHandle_t g_control_task = nullptr;
+uint32_t g_setup_us = 0;
+
+// Every CONTROL_PERIOD_MS / TEMP_SAMPLE_MS samples the sweep's start time is
+// posted to the control task. The notification value is a one-slot mailbox:
+// an unread sample is overwritten by the newer one.
 void sensorTask(void *param) {
   (void)param;
+  constexpr uint32_t kSamplesPerControl = CONTROL_PERIOD_MS / TEMP_SAMPLE_MS;
+  uint32_t samples = 0;
   TickType_t last_wake = xTaskGetTickCount();
   for (;;) {
+    uint32_t sample_us = halMicros();
     controlUpdateTemperature();
+    if (++samples % kSamplesPerControl == 0) {
+      xTaskNotify(g_control_task, sample_us, eSetValueWithOverwrite);
+    }
+    metricsObserve(Metric::TASK_SENSOR, halMicros() - sample_us);
     vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TEMP_SAMPLE_MS));
   }
 }
 
 void controlTask(void *param) {
   (void)param;
+  const TickType_t wait_limit = pdMS_TO_TICKS(CONTROL_PERIOD_MS + CONTROL_DEADLINE_US / 1000);
   TickType_t last_wake = xTaskGetTickCount();
+  uint32_t sample_us = halMicros();
+  bool first_tick = true;
   for (;;) {
+    // Pipelined: block until the sensor posts. Free-running: pick up the
+    // latest sample, if any, without waiting.
+    uint32_t posted = 0;
+    bool fresh = xTaskNotifyWait(0, 0, &posted, CONTROL_PIPELINED ? wait_limit : 0) == pdTRUE;
+    if (fresh) {
+      sample_us = posted;
+    }
+    uint32_t start_us = halMicros();
     controlUpdateState();
     controlComputeControl();
-    uint32_t now_ms = millis();
-    controlUpdateSsrOutput(now_ms);
+    controlUpdateSsrOutput();
+    controlRecordTiming(sample_us, fresh);
+    if (first_tick) {
+      first_tick = false;
+      uint32_t now_us = halMicros();
+      logInfo(LogModule::SYSTEM, "first control tick %lu ms after boot, %lu ms after setup() began",
+              static_cast<unsigned long>(now_us / 1000), static_cast<unsigned long>((now_us - g_setup_us) / 1000));
+    }
+    uint32_t now_ms = halMillis();
+    telemetryPublish(now_ms);
+    runlogOnTick();
     controlLogStatus(now_ms);
-    vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+    metricsObserve(Metric::TASK_CONTROL, halMicros() - start_us);
+    if (!CONTROL_PIPELINED) {
+      vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+    }
+  }
+}
+
+void runlogTask(void *param) {
+  (void)param;
+  for (;;) {
+    runlogProcess();
+  }
+}
+
+// Reads ahead the profile pages running zones will need, off the control path.
+void storeTask(void *param) {
+  (void)param;
+  for (;;) {
+    profilePrefetch();
+    profileStoreCompact(false);
+    vTaskDelay(pdMS_TO_TICKS(PROFILE_PREFETCH_MS));
+  }
+}
+
+void logTask(void *param) {
+  (void)param;
+  for (;;) {
+    logProcess();
+    vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+  }
+}
+
+// Serial first, then the file, from the log task.
+void serialAndFileSink(const char *line, size_t len) {
+  Serial.print(line);
+  storageAppendLog(line, len);
+}
+
+// Wi-Fi join, AP fallback, mDNS and reconnection; the server starts once
+// the TCP/IP stack is up, whether or not a link is.
+void networkTask(void *param) {
+  (void)param;
+  networkBegin();
+  webSetup();
+  for (;;) {
+    networkStep(halMillis());
+    vTaskDelay(pdMS_TO_TICKS(NETWORK_STEP_MS));
   }
 }
 
 void webTask(void *param) {
   (void)param;
   for (;;) {
-    webHandleClient();
+    {
+      MetricTimer timer(Metric::TASK_WEB);
+      webPumpEvents();
+    }
     vTaskDelay(pdMS_TO_TICKS(10));
   }
 }
+
+// ZERO_HEAP builds give each task a static stack and TCB (one instantiation
+// per entry point); others take both from the heap.
+template <TaskFunction_t Fn, uint32_t kStackBytes>
+TaskHandle_t startTask(const char *name, UBaseType_t priority, BaseType_t core) {
+  if constexpr (ZERO_HEAP) {
+    static StackType_t stack[kStackBytes / sizeof(StackType_t)];
+    static StaticTask_t tcb;
+    return xTaskCreateStaticPinnedToCore(Fn, name, kStackBytes, nullptr, priority, stack, &tcb, core);
+  } else {
+    TaskHandle_t handle = nullptr;
+    xTaskCreatePinnedToCore(Fn, name, kStackBytes, nullptr, priority, &handle, core);
+    return handle;
+  }
+}
 } // namespace
 
 void setup() {
+  g_setup_us = halMicros();
   Serial.begin(115200);
+  // Started first so boot messages drain while setup() continues.
+  TaskHandle_t log = startTask<logTask, 3072>("log", 1, 0);
 
+  // Temperature monitoring and fault detection come up before anything
+  // slow (flash mount, profile load, Wi-Fi). Until the web server is up
+  // nothing can start a run, so the control path never waits on storage.
+  // The control task must exist before the sensor task posts to it.
   controlInit();
-  webSetup();
+  g_control_task = startTask<controlTask, 4096>("control", 3, 1);
+  TaskHandle_t sensor = startTask<sensorTask, 4096>("sensor", 2, 1);
+
+  if (storageInit() && LOG_TO_FILE) {
+    logSetSink(serialAndFileSink);
+  }
+  storageLoadProfiles();
+  runlogInit();
+  // A reset mid-run may have left a checkpoint; decide on it before the web
+  // server can start anything, once a tick has read the switch and sensors.
+  ControlTiming timing;
+  for (controlGetTiming(timing); timing.ticks == 0 && halMicros() - g_setup_us < RESUME_WAIT_MS * 1000;
+       controlGetTiming(timing)) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  controlResumeRun(ResumePolicy{});
 
-  xTaskCreatePinnedToCore(sensorTask, "sensor", 4096, nullptr, 2, nullptr, 1);
-  xTaskCreatePinnedToCore(controlTask, "control", 4096, nullptr, 3, nullptr, 1);
-  xTaskCreatePinnedToCore(webTask, "web", 4096, nullptr, 1, nullptr, 0);
+  TaskHandle_t web = startTask<webTask, 4096>("web", 1, 0);
+  TaskHandle_t runlog = startTask<runlogTask, 4096>("runlog", 1, 0);
+  TaskHandle_t store = startTask<storeTask, 3072>("store", 1, 0);
+  TaskHandle_t network = startTask<networkTask, 4096>("network", 1, 0);
+  metricsRegisterTask("control", g_control_task);
+  metricsRegisterTask("sensor", sensor);
+  metricsRegisterTask("web", web);
+  metricsRegisterTask("runlog", runlog);
+  metricsRegisterTask("store", store);
+  metricsRegisterTask("log", log);
+  metricsRegisterTask("network", network);
+  logInfo(LogModule::SYSTEM, "setup() done in %lu ms",
+          static_cast<unsigned long>((halMicros() - g_setup_us) / 1000));
 }
 
 void loop() {
@@ -0,0 +1,82 @@
+#include "metrics.h"
+#include <atomic>
+
+namespace {
+constexpr uint8_t kMetricCount = static_cast<uint8_t>(Metric::COUNT);
+
+struct Histogram {
+  std::atomic<uint32_t> buckets[kMetricBuckets];
+  std::atomic<uint32_t> count;
+  // 64-bit sum from two words: 64-bit atomics are not lock-free on the
+  // ESP32. A reader can see the low word wrap before the carry lands; that
+  // glitch is accepted for a scrape.
+  std::atomic<uint32_t> sum_lo;
+  std::atomic<uint32_t> sum_hi;
+};
+Histogram g_histograms[kMetricCount];
+
+struct MetricInfo {
+  const char *family;
+  const char *labels;
+};
+const MetricInfo kMetricInfo[kMetricCount] = {
+    {"oven_task_iteration_seconds", "task=\"sensor\""},
+    {"oven_task_iteration_seconds", "task=\"control\""},
+    {"oven_task_iteration_seconds", "task=\"web\""},
+    {"oven_task_iteration_seconds", "task=\"runlog\""},
+    {"oven_control_latency_seconds", ""},
+    {"oven_lock_wait_seconds", "lock=\"control\""},
+    {"oven_lock_wait_seconds", "lock=\"profile\""},
+    {"oven_lock_wait_seconds", "lock=\"events\""},
+    {"oven_lock_wait_seconds", "lock=\"store\""},
+    {"oven_http_handler_seconds", "handler=\"status\""},
+    {"oven_http_handler_seconds", "handler=\"history\""},
+    {"oven_http_handler_seconds", "handler=\"profiles\""},
+    {"oven_http_handler_seconds", "handler=\"profile_item\""},
+    {"oven_http_handler_seconds", "handler=\"runs\""},
+    {"oven_http_handler_seconds", "handler=\"run_download\""},
+    {"oven_http_handler_seconds", "handler=\"run\""},
+    {"oven_http_handler_seconds", "handler=\"stop\""},
+    {"oven_http_handler_seconds", "handler=\"metrics\""},
+    {"oven_http_handler_seconds", "handler=\"log\""},
+    {"oven_http_handler_seconds", "handler=\"autotune\""},
+    {"oven_http_handler_seconds", "handler=\"asset\""},
+    {"oven_http_handler_seconds", "handler=\"not_found\""},
+};
+} // namespace
+
+void metricsObserve(Metric metric, uint32_t us) {
+  uint8_t index = static_cast<uint8_t>(metric);
+  if (index >= kMetricCount) {
+    return;
+  }
+  uint8_t bucket = 0;
+  while (bucket < kMetricBuckets - 1 && us > kMetricBucketsUs[bucket]) {
+    bucket++;
+  }
+  Histogram &h = g_histograms[index];
+  h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  h.count.fetch_add(1, std::memory_order_relaxed);
+  uint32_t prev = h.sum_lo.fetch_add(us, std::memory_order_relaxed);
+  if (prev + us < prev) {
+    h.sum_hi.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void metricsRead(Metric metric, MetricSnapshot &out_snapshot) {
+  const Histogram &h = g_histograms[static_cast<uint8_t>(metric)];
+  for (uint8_t i = 0; i < kMetricBuckets; ++i) {
+    out_snapshot.buckets[i] = h.buckets[i].load(std::memory_order_relaxed);
+  }
+  out_snapshot.count = h.count.load(std::memory_order_relaxed);
+  out_snapshot.sum_us = (static_cast<uint64_t>(h.sum_hi.load(std::memory_order_relaxed)) << 32) |
+                        h.sum_lo.load(std::memory_order_relaxed);
+}
+
+const char *metricFamily(Metric metric) {
+  return kMetricInfo[static_cast<uint8_t>(metric)].family;
+}
+
+const char *metricLabels(Metric metric) {
+  return kMetricInfo[static_cast<uint8_t>(metric)].labels;
+}
@@ -0,0 +1,140 @@
+#include "metrics.h"
+#include "control.h"
+#include "log.h"
+#include "network.h"
+#include "profile.h"
+#include "profile_store.h"
+#include "runlog.h"
+#include "web_api.h"
+#include <esp_heap_caps.h>
+#include <freertos/task.h>
+
+namespace {
+constexpr uint8_t kMaxTasks = 8;
+
+struct TaskEntry {
+  const char *name;
+  TaskHandle_t handle;
+};
+TaskEntry g_tasks[kMaxTasks];
+uint8_t g_task_count = 0;
+
+void writeHistograms(Print &out) {
+  const char *last_family = "";
+  for (uint8_t i = 0; i < static_cast<uint8_t>(Metric::COUNT); ++i) {
+    Metric metric = static_cast<Metric>(i);
+    const char *family = metricFamily(metric);
+    const char *labels = metricLabels(metric);
+    const char *sep = labels[0] ? "," : "";
+    if (strcmp(family, last_family) != 0) {
+      out.printf("# TYPE %s histogram\n", family);
+      last_family = family;
+    }
+    MetricSnapshot snap;
+    metricsRead(metric, snap);
+    // Cumulate here so the +Inf bucket always equals _count.
+    uint32_t cumulative = 0;
+    for (uint8_t b = 0; b < kMetricBuckets; ++b) {
+      cumulative += snap.buckets[b];
+      if (b + 1 < kMetricBuckets) {
+        out.printf("%s_bucket{%s%sle=\"%g\"} %lu\n", family, labels, sep, kMetricBucketsUs[b] / 1e6,
+                   static_cast<unsigned long>(cumulative));
+      } else {
+        out.printf("%s_bucket{%s%sle=\"+Inf\"} %lu\n", family, labels, sep, static_cast<unsigned long>(cumulative));
+      }
+    }
+    out.printf("%s_sum{%s} %.6f\n", family, labels, snap.sum_us / 1e6);
+    out.printf("%s_count{%s} %lu\n", family, labels, static_cast<unsigned long>(cumulative));
+  }
+}
+
+void writeStack(Print &out, const char *name, TaskHandle_t handle) {
+  // ESP-IDF reports the high-water mark in bytes.
+  out.printf("oven_task_stack_free_min_bytes{task=\"%s\"} %lu\n", name,
+             static_cast<unsigned long>(uxTaskGetStackHighWaterMark(handle)));
+}
+} // namespace
+
+void metricsRegisterTask(const char *name, void *task_handle) {
+  if (g_task_count < kMaxTasks && task_handle) {
+    g_tasks[g_task_count++] = TaskEntry{name, static_cast<TaskHandle_t>(task_handle)};
+  }
+}
+
+void metricsWritePrometheus(Print &out) {
+  writeHistograms(out);
+
+  ControlTiming timing;
+  controlGetTiming(timing);
+  out.printf("# TYPE oven_control_deadline_misses_total counter\n");
+  out.printf("oven_control_deadline_misses_total %lu\n", static_cast<unsigned long>(timing.deadline_misses));
+  out.printf("# TYPE oven_control_stale_ticks_total counter\n");
+  out.printf("oven_control_stale_ticks_total %lu\n", static_cast<unsigned long>(timing.stale_ticks));
+  out.printf("# TYPE oven_boot_first_control_tick_seconds gauge\noven_boot_first_control_tick_seconds %.3f\n",
+             timing.first_tick_us / 1e6);
+  NetworkStatus network;
+  networkGetStatus(network);
+  out.printf("# TYPE oven_network_state gauge\noven_network_state{state=\"%s\"} 1\n",
+             networkStateName(network.state));
+  out.printf("# TYPE oven_network_reconnects_total counter\noven_network_reconnects_total %lu\n",
+             static_cast<unsigned long>(network.reconnects));
+  out.printf("# TYPE oven_log_dropped_records_total counter\n");
+  for (uint8_t i = 0; i < static_cast<uint8_t>(LogModule::COUNT); ++i) {
+    LogModule module = static_cast<LogModule>(i);
+    out.printf("oven_log_dropped_records_total{module=\"%s\"} %lu\n", logModuleName(module),
+               static_cast<unsigned long>(logDropped(module)));
+  }
+  out.printf("# TYPE oven_profile_page_misses_total counter\n");
+  out.printf("oven_profile_page_misses_total %lu\n", static_cast<unsigned long>(profilePageMisses()));
+  ProfileStoreStats store;
+  profileStoreGetStats(store);
+  out.printf("# TYPE oven_profile_store_file_bytes gauge\noven_profile_store_file_bytes %lu\n",
+             static_cast<unsigned long>(store.file_bytes));
+  out.printf("# TYPE oven_profile_store_live_bytes gauge\noven_profile_store_live_bytes %lu\n",
+             static_cast<unsigned long>(store.live_bytes));
+  out.printf("# TYPE oven_profile_store_compactions_total counter\noven_profile_store_compactions_total %lu\n",
+             static_cast<unsigned long>(store.compactions));
+  out.printf("# TYPE oven_profile_store_written_bytes_total counter\noven_profile_store_written_bytes_total %lu\n",
+             static_cast<unsigned long>(store.bytes_written));
+  out.printf("# TYPE oven_runlog_dropped_records_total counter\n");
+  out.printf("oven_runlog_dropped_records_total %lu\n", static_cast<unsigned long>(runlogDroppedRecords()));
+
+  size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  out.printf("# TYPE oven_heap_free_bytes gauge\noven_heap_free_bytes %u\n", static_cast<unsigned>(free_bytes));
+  out.printf("# TYPE oven_heap_free_min_bytes gauge\noven_heap_free_min_bytes %u\n",
+             static_cast<unsigned>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT)));
+  out.printf("# TYPE oven_heap_largest_free_block_bytes gauge\noven_heap_largest_free_block_bytes %u\n",
+             static_cast<unsigned>(largest));
+  // 0 = one contiguous free block, towards 1 = free memory in small pieces.
+  out.printf("# TYPE oven_heap_fragmentation_ratio gauge\noven_heap_fragmentation_ratio %.3f\n",
+             free_bytes ? 1.0 - static_cast<double>(largest) / free_bytes : 0.0);
+
+  uint32_t upload_before = 0;
+  uint32_t upload_min = 0;
+  webProfileUploadHeap(upload_before, upload_min);
+  out.printf("# TYPE oven_profile_upload_heap_free_before_bytes gauge\n"
+             "oven_profile_upload_heap_free_before_bytes %lu\n",
+             static_cast<unsigned long>(upload_before));
+  out.printf("# TYPE oven_profile_upload_heap_free_min_bytes gauge\n"
+             "oven_profile_upload_heap_free_min_bytes %lu\n",
+             static_cast<unsigned long>(upload_min));
+
+  WebArenaStats arena;
+  webArenaStats(arena);
+  out.printf("# TYPE oven_web_json_arena_high_water_bytes gauge\noven_web_json_arena_high_water_bytes %lu\n",
+             static_cast<unsigned long>(arena.json_high_water));
+  out.printf("# TYPE oven_web_json_arena_failures_total counter\noven_web_json_arena_failures_total %lu\n",
+             static_cast<unsigned long>(arena.json_failures));
+  out.printf("# TYPE oven_web_slot_busy_total counter\noven_web_slot_busy_total %lu\n",
+             static_cast<unsigned long>(arena.slot_busy));
+
+  out.printf("# TYPE oven_task_stack_free_min_bytes gauge\n");
+  for (uint8_t i = 0; i < g_task_count; ++i) {
+    writeStack(out, g_tasks[i].name, g_tasks[i].handle);
+  }
+  TaskHandle_t async_tcp = xTaskGetHandle("async_tcp");
+  if (async_tcp) {
+    writeStack(out, "async_tcp", async_tcp);
+  }
+}
@@ -0,0 +1,184 @@
+#include "filter_eval.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+// Delays are searched up to this many samples (12 s at TEMP_SAMPLE_MS).
+constexpr int kMaxLag = 60;
+
+struct Trace {
+  std::vector<uint32_t> t_ms;
+  std::vector<float> raw;
+  std::vector<float> ref;
+  bool has_truth = false;
+};
+
+int columnIndex(char *header, const char *name) {
+  int index = 0;
+  for (char *field = strtok(header, ",\r\n"); field; field = strtok(nullptr, ",\r\n"), ++index) {
+    if (strcmp(field, name) == 0) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+bool loadTrace(const char *path, Trace &trace) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  char line[256];
+  char header[256] = "";
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] != '#') {
+      strcpy(header, line);
+      break;
+    }
+  }
+  char scratch[256];
+  int col_t = columnIndex(strcpy(scratch, header), "t_s");
+  int col_zone = columnIndex(strcpy(scratch, header), "zone");
+  int col_meas = columnIndex(strcpy(scratch, header), "t_meas");
+  int col_plant = columnIndex(strcpy(scratch, header), "t_plant");
+  trace.has_truth = col_plant >= 0;
+  while (col_t >= 0 && col_meas >= 0 && fgets(line, sizeof(line), file)) {
+    // Split by hand: strtok would merge the empty field of an invalid sample.
+    const char *fields[16] = {};
+    int count = 0;
+    for (char *p = line; p && count < 16; ++count) {
+      fields[count] = p;
+      p = strchr(p, ',');
+      if (p) *p++ = '\0';
+    }
+    auto field = [&](int col) { return col >= 0 && col < count ? fields[col] : ""; };
+    if (col_zone >= 0 && atoi(field(col_zone)) != 0) {
+      continue;
+    }
+    char *end = nullptr;
+    float meas = strtof(field(col_meas), &end);
+    if (end == field(col_meas)) {
+      continue;
+    }
+    trace.t_ms.push_back(static_cast<uint32_t>(lroundf(strtof(field(col_t), nullptr) * 1000.0f)));
+    trace.raw.push_back(meas);
+    trace.ref.push_back(trace.has_truth ? strtof(field(col_plant), nullptr) : meas);
+  }
+  fclose(file);
+  return trace.raw.size() > 2 * kMaxLag;
+}
+
+void describe(const FilterConfig &config, char *out, size_t len) {
+  int n = snprintf(out, len, "median=%u", config.median_window);
+  switch (config.smoothing) {
+    case FilterSmoothing::MOVING_AVERAGE:
+      n += snprintf(out + n, len - n, " ma=%u", config.average_window);
+      break;
+    case FilterSmoothing::EMA:
+      n += snprintf(out + n, len - n, " ema=%.2f", config.ema_alpha);
+      break;
+    default:
+      break;
+  }
+  if (config.rate_window) {
+    snprintf(out + n, len - n, " rate=%u", config.rate_window);
+  }
+}
+
+void evaluate(const Trace &trace, const FilterConfig &config, const char *label) {
+  size_t n = trace.raw.size();
+  std::vector<float> out(n);
+  std::vector<float> rate(n);
+  TempFilter filter;
+  filterReset(filter, config);
+  for (size_t i = 0; i < n; ++i) {
+    filterPush(filter, config, trace.raw[i], trace.t_ms[i]);
+    out[i] = filter.temp_c;
+    rate[i] = filter.rate_c_s;
+  }
+
+  // Group delay: the shift of the reference that best matches the output.
+  double cost[kMaxLag + 1];
+  int best = 0;
+  for (int lag = 0; lag <= kMaxLag; ++lag) {
+    double sum = 0.0;
+    for (size_t i = kMaxLag; i < n; ++i) {
+      double d = out[i] - trace.ref[i - lag];
+      sum += d * d;
+    }
+    cost[lag] = sum / (n - kMaxLag);
+    if (cost[lag] < cost[best]) {
+      best = lag;
+    }
+  }
+  // Parabola through the neighbours for a sub-sample estimate.
+  double frac = 0.0;
+  if (best > 0 && best < kMaxLag) {
+    double denom = cost[best - 1] - 2.0 * cost[best] + cost[best + 1];
+    frac = denom > 0.0 ? 0.5 * (cost[best - 1] - cost[best + 1]) / denom : 0.0;
+  }
+  double period_ms = static_cast<double>(trace.t_ms[n - 1] - trace.t_ms[0]) / (n - 1);
+
+  double max_dev = 0.0;
+  double rate_sq = 0.0;
+  size_t rate_samples = 0;
+  for (size_t i = kMaxLag; i < n; ++i) {
+    max_dev = fmax(max_dev, fabs(out[i] - trace.ref[i - best]));
+    size_t c = i - best;
+    if (!std::isnan(rate[i]) && c >= 2 && i + 2 < n) {
+      // Reference slope, central difference over +-2 samples at the same lag.
+      double slope = (trace.ref[c + 2] - trace.ref[c - 2]) * 1000.0 / (trace.t_ms[c + 2] - trace.t_ms[c - 2]);
+      rate_sq += (rate[i] - slope) * (rate[i] - slope);
+      rate_samples++;
+    }
+  }
+  char rate_text[32] = "-";
+  if (rate_samples) {
+    snprintf(rate_text, sizeof(rate_text), "%.3fC/s", sqrt(rate_sq / rate_samples));
+  }
+  printf("%-34s delay=%6.0fms resid=%.3fC max_dev=%6.2fC rate_rms=%s\n", label,
+         (best + frac) * period_ms, sqrt(cost[best]), max_dev, rate_text);
+}
+} // namespace
+
+bool filterEvalRun(const char *path, const FilterConfig *custom) {
+  Trace trace;
+  if (!loadTrace(path, trace)) {
+    fprintf(stderr, "filter eval: cannot read a trace of more than %d samples from %s\n", 2 * kMaxLag, path);
+    return false;
+  }
+  printf("filter eval: %s, %u samples, reference=%s\n", path, static_cast<unsigned>(trace.raw.size()),
+         trace.has_truth ? "t_plant" : "t_meas");
+
+  FilterConfig configs[8];
+  configs[1].smoothing = FilterSmoothing::MOVING_AVERAGE;
+  configs[1].average_window = 4;
+  configs[2].smoothing = FilterSmoothing::MOVING_AVERAGE;
+  configs[2].average_window = 8;
+  configs[3].smoothing = FilterSmoothing::EMA;
+  configs[3].ema_alpha = 0.3f;
+  configs[4].smoothing = FilterSmoothing::EMA;
+  configs[4].ema_alpha = 0.1f;
+  configs[5].median_window = 5;
+  configs[6].median_window = 5;
+  configs[6].smoothing = FilterSmoothing::MOVING_AVERAGE;
+  configs[6].average_window = 4;
+  configs[7].median_window = 5;
+  configs[7].smoothing = FilterSmoothing::EMA;
+  configs[7].ema_alpha = 0.3f;
+  configs[7].rate_window = 5;
+  for (const FilterConfig &config : configs) {
+    char label[48];
+    describe(config, label, sizeof(label));
+    evaluate(trace, config, label);
+  }
+  if (custom) {
+    char label[48] = "custom: ";
+    describe(filterSanitize(*custom), label + strlen(label), sizeof(label) - strlen(label));
+    evaluate(trace, *custom, label);
+  }
+  return true;
+}
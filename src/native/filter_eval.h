@@ -0,0 +1,11 @@
+#pragma once
+
+#include "filter.h"
+
+// Replays a recorded temperature trace (sim --csv output, or
+// tools/runlog_decode.py output; zone 0) through a set of filter configs,
+// plus custom when given, and prints each one's group delay, residual noise,
+// worst excursion and rate error. With a t_plant column (sim traces) that is
+// the reference; otherwise the raw t_meas is. Returns false if the trace is
+// unreadable.
+bool filterEvalRun(const char *path, const FilterConfig *custom);
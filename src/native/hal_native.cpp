@@ -0,0 +1,136 @@
+#include "hal.h"
+#include "app_config.h"
+#include "sim_hal.h"
+
+namespace {
+uint32_t g_now_ms = 0;
+uint8_t g_pin_mode[kSimPinCount] = {};
+uint8_t g_pin_level[kSimPinCount] = {};
+uint8_t g_zone_count = 1;
+ThermocoupleSample g_thermocouples[MAX_ZONES];
+uint8_t g_ssr_level[MAX_ZONES] = {};
+void (*g_timer_callback)() = nullptr;
+uint32_t g_timer_period_ms = 0;
+uint32_t g_timer_next_ms = 0;
+uint32_t g_retained[RETAINED_MEMORY_BYTES / 4];
+} // namespace
+
+void simHalReset() {
+  g_now_ms = 0;
+  for (uint8_t i = 0; i < kSimPinCount; ++i) {
+    g_pin_mode[i] = 0;
+    g_pin_level[i] = LOW;
+  }
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    g_thermocouples[z] = ThermocoupleSample{};
+    g_ssr_level[z] = LOW;
+  }
+  g_timer_callback = nullptr;
+}
+
+void simHalSetMillis(uint32_t now_ms) {
+  // Fire every timer period crossed on the way, with the clock at that tick.
+  while (g_timer_callback && static_cast<int32_t>(now_ms - g_timer_next_ms) >= 0) {
+    g_now_ms = g_timer_next_ms;
+    g_timer_next_ms += g_timer_period_ms;
+    g_timer_callback();
+  }
+  g_now_ms = now_ms;
+}
+
+void simHalAdvanceMillis(uint32_t delta_ms) {
+  simHalSetMillis(g_now_ms + delta_ms);
+}
+
+int simHalPinLevel(uint8_t pin) {
+  return pin < kSimPinCount ? g_pin_level[pin] : LOW;
+}
+
+void simHalSetPinLevel(uint8_t pin, uint8_t level) {
+  if (pin < kSimPinCount) {
+    g_pin_level[pin] = level;
+  }
+}
+
+void simHalSetZoneCount(uint8_t count) {
+  g_zone_count = count < 1 ? 1 : (count > MAX_ZONES ? MAX_ZONES : count);
+}
+
+void simHalSetThermocouple(uint8_t zone, float temp_c, uint8_t fault) {
+  if (zone < MAX_ZONES) {
+    g_thermocouples[zone].temp_c = fault == 0 ? temp_c : NAN;
+    g_thermocouples[zone].fault = fault;
+  }
+}
+
+int simHalSsrLevel(uint8_t zone) {
+  return zone < MAX_ZONES ? g_ssr_level[zone] : LOW;
+}
+
+void halInit() {}
+
+uint32_t halMillis() {
+  return g_now_ms;
+}
+
+uint32_t halMicros() {
+  return g_now_ms * 1000u;
+}
+
+void halPinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= kSimPinCount) {
+    return;
+  }
+  g_pin_mode[pin] = mode;
+  if (mode == INPUT_PULLUP) {
+    g_pin_level[pin] = HIGH;
+  }
+}
+
+int halDigitalRead(uint8_t pin) {
+  return simHalPinLevel(pin);
+}
+
+void halDigitalWrite(uint8_t pin, uint8_t level) {
+  if (pin < kSimPinCount && g_pin_mode[pin] == OUTPUT) {
+    g_pin_level[pin] = level;
+  }
+}
+
+uint8_t halZoneCount() {
+  return g_zone_count;
+}
+
+void halReadThermocouples(ThermocoupleSample *out_samples, uint8_t count) {
+  for (uint8_t z = 0; z < count && z < MAX_ZONES; ++z) {
+    out_samples[z] = g_thermocouples[z];
+  }
+}
+
+void halSetSsr(uint8_t zone, uint8_t level) {
+  if (zone < MAX_ZONES) {
+    g_ssr_level[zone] = level;
+  }
+}
+
+void *halRetainedMemory() {
+  return g_retained;
+}
+
+// The virtual clock has 1 ms resolution.
+void halStartTimer(uint32_t period_us, void (*callback)()) {
+  if (g_timer_callback) {
+    return;
+  }
+  g_timer_period_ms = max<uint32_t>(1, (period_us + 500) / 1000);
+  g_timer_next_ms = g_now_ms + g_timer_period_ms;
+  g_timer_callback = callback;
+}
+
+uint32_t millis() {
+  return g_now_ms;
+}
+
+void delay(uint32_t ms) {
+  simHalAdvanceMillis(ms);
+}
@@ -0,0 +1,53 @@
+#include "plant_model.h"
+#include <cmath>
+
+namespace {
+float nextUniform(PlantModel &plant) {
+  // xorshift32, deterministic per seed so runs are reproducible.
+  uint32_t x = plant.rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  plant.rng_state = x;
+  return (static_cast<float>(x) + 1.0f) / 4294967296.0f;
+}
+
+float nextGaussian(PlantModel &plant) {
+  float u1 = nextUniform(plant);
+  float u2 = nextUniform(plant);
+  return std::sqrt(-2.0f * std::log(u1)) * std::cos(6.2831853f * u2);
+}
+} // namespace
+
+void plantInit(PlantModel &plant, const PlantParams &params, uint32_t step_ms) {
+  plant.params = params;
+  plant.step_ms = step_ms == 0 ? 1 : step_ms;
+  plant.temp_c = params.ambient_c;
+  uint32_t slots = static_cast<uint32_t>(params.dead_time_s * 1000.0f / plant.step_ms);
+  plant.delay_line.assign(slots + 1, 0.0f);
+  plant.delay_index = 0;
+  plant.rng_state = params.seed == 0 ? 1 : params.seed;
+}
+
+void plantStep(PlantModel &plant, float heater) {
+  plant.delay_line[plant.delay_index] = heater;
+  plant.delay_index = (plant.delay_index + 1) % plant.delay_line.size();
+  float delayed = plant.delay_line[plant.delay_index];
+
+  float target = plant.params.ambient_c + plant.params.gain_c * delayed;
+  float alpha = 1.0f - std::exp(-static_cast<float>(plant.step_ms) /
+                                (plant.params.time_constant_s * 1000.0f));
+  plant.temp_c += (target - plant.temp_c) * alpha;
+}
+
+float plantSensorTemp(PlantModel &plant) {
+  float temp = plant.temp_c;
+  if (plant.params.noise_c > 0.0f) {
+    temp += plant.params.noise_c * nextGaussian(plant);
+  }
+  if (plant.params.spike_rate > 0.0f && nextUniform(plant) < plant.params.spike_rate) {
+    temp += nextUniform(plant) < 0.5f ? plant.params.spike_c : -plant.params.spike_c;
+  }
+  // MAX31855 resolution is 0.25 C.
+  return std::round(temp * 4.0f) / 4.0f;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// First-order-plus-dead-time oven model:
+//   tau * dT/dt = ambient + gain * u(t - dead_time) - T
+// where u is the heater drive (0 = SSR off, 1 = SSR on).
+
+struct PlantParams {
+  float ambient_c = 25.0f;
+  float gain_c = 300.0f;          // steady-state rise over ambient at 100% drive
+  float time_constant_s = 160.0f;
+  float dead_time_s = 8.0f;
+  float noise_c = 0.0f;           // sensor noise standard deviation
+  float spike_rate = 0.0f;        // chance per reading of a +-spike_c outlier
+  float spike_c = 25.0f;
+  uint32_t seed = 1;
+};
+
+struct PlantModel {
+  PlantParams params;
+  float temp_c = 0.0f;
+  std::vector<float> delay_line;   // heater history, one slot per step
+  uint32_t delay_index = 0;
+  uint32_t step_ms = 0;
+  uint32_t rng_state = 1;
+};
+
+void plantInit(PlantModel &plant, const PlantParams &params, uint32_t step_ms);
+void plantStep(PlantModel &plant, float heater);
+float plantSensorTemp(PlantModel &plant);
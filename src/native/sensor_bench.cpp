@@ -0,0 +1,202 @@
+#include "sensor_bench.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "max31855.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+constexpr uint8_t kPinSck = 18;
+constexpr uint8_t kPinMiso = 19;
+constexpr uint8_t kPinCs = 5;
+constexpr uint32_t kBusClockHz = 4000000;  // hal_esp32.cpp kThermocoupleClockHz
+
+#if defined(__x86_64__) || defined(__i386__)
+constexpr const char *kUnit = "cycles";
+uint64_t now() {
+  return __rdtsc();
+}
+#else
+constexpr const char *kUnit = "ns";
+uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+// The chip as seen from its pins: CS low latches a conversion, MISO shows
+// the current bit (MSB first) and SCK's falling edge moves to the next.
+struct Chip {
+  uint32_t frame = 0;
+  uint8_t cs = 1;
+  uint8_t sck = 0;
+  int8_t bit = -1;
+  uint32_t gpio_calls = 0;
+};
+
+Chip g_chip;
+
+// Out of line, as the Arduino core's digitalWrite/digitalRead are.
+__attribute__((noinline)) void gpioWrite(uint8_t pin, uint8_t level) {
+  g_chip.gpio_calls++;
+  if (pin == kPinCs) {
+    if (g_chip.cs && !level) {
+      g_chip.bit = 31;
+    }
+    g_chip.cs = level;
+  } else if (pin == kPinSck) {
+    if (g_chip.sck && !level && !g_chip.cs && g_chip.bit >= 0) {
+      g_chip.bit--;
+    }
+    g_chip.sck = level;
+  }
+}
+
+__attribute__((noinline)) int gpioRead(uint8_t pin) {
+  g_chip.gpio_calls++;
+  if (pin != kPinMiso || g_chip.cs || g_chip.bit < 0) {
+    return 1;
+  }
+  return (g_chip.frame >> g_chip.bit) & 1u;
+}
+
+// Adafruit_SPIDevice::read() on software SPI, mode 0, no MOSI: CS low, per
+// bit SCK high, sample MISO, SCK low, then CS high.
+uint32_t softSpiRead32() {
+  uint8_t buf[4];
+  gpioWrite(kPinCs, 0);
+  for (uint8_t &byte : buf) {
+    byte = 0;
+    for (uint8_t mask = 0x80; mask; mask >>= 1) {
+      gpioWrite(kPinSck, 1);
+      if (gpioRead(kPinMiso)) {
+        byte |= mask;
+      }
+      gpioWrite(kPinSck, 0);
+    }
+  }
+  gpioWrite(kPinCs, 1);
+  uint32_t d = buf[0];
+  d = (d << 8) | buf[1];
+  d = (d << 8) | buf[2];
+  d = (d << 8) | buf[3];
+  return d;
+}
+
+// Adafruit_MAX31855::readCelsius() and readError().
+double oldReadCelsius() {
+  int32_t v = static_cast<int32_t>(softSpiRead32());
+  if (v & 0x7) {
+    return NAN;
+  }
+  if (v & 0x80000000) {
+    v = 0xFFFFC000 | ((v >> 18) & 0x00003FFF);
+  } else {
+    v >>= 18;
+  }
+  return v * 0.25;
+}
+
+uint8_t oldReadError() {
+  return softSpiRead32() & 0x7;
+}
+
+// spi_device_polling_transmit(): the peripheral clocks the frame into
+// rx_data without the CPU touching SCK or MISO.
+__attribute__((noinline)) void spiPollingTransmit(uint8_t *rx_data) {
+  g_chip.bit = 31;
+  for (uint8_t i = 0; i < 4; ++i) {
+    rx_data[i] = static_cast<uint8_t>(g_chip.frame >> (24 - 8 * i));
+  }
+  g_chip.bit = -1;
+}
+
+// hal_esp32.cpp readFrame().
+Max31855Reading newReadFrame() {
+  uint8_t rx[4];
+  gpioWrite(kPinCs, 0);
+  spiPollingTransmit(rx);
+  gpioWrite(kPinCs, 1);
+  uint32_t frame = (static_cast<uint32_t>(rx[0]) << 24) | (static_cast<uint32_t>(rx[1]) << 16) |
+                   (static_cast<uint32_t>(rx[2]) << 8) | rx[3];
+  return max31855Decode(frame);
+}
+
+uint32_t nextRandom(uint32_t &state) {
+  // xorshift32
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// Frames the chip can send: bit 16 set exactly when a fault bit is, and a
+// fault reading still carries a cold junction.
+uint32_t randomFrame(uint32_t &rng) {
+  int32_t hot = static_cast<int32_t>(nextRandom(rng) % 6200) - 800;  // -200..1350 C in 0.25 C
+  int32_t cold = static_cast<int32_t>(nextRandom(rng) % 2640) - 640;  // -40..125 C in 0.0625 C
+  uint32_t frame = (static_cast<uint32_t>(hot) << 18) | ((static_cast<uint32_t>(cold) & 0xFFF) << 4);
+  if (nextRandom(rng) % 8 == 0) {
+    frame |= kMax31855FaultAny | (1u + nextRandom(rng) % kMax31855FaultMask);
+  }
+  return frame;
+}
+
+struct OldSample {
+  double temp_c;
+  uint8_t fault;
+};
+} // namespace
+
+bool sensorBenchRun(uint32_t samples, uint32_t seed) {
+  uint32_t rng = seed ? seed : 1;
+  std::vector<uint32_t> frames(samples);
+  for (uint32_t &frame : frames) {
+    frame = randomFrame(rng);
+  }
+  std::vector<OldSample> old_samples(samples);
+  std::vector<Max31855Reading> new_samples(samples);
+
+  g_chip = Chip{};
+  uint64_t t0 = now();
+  for (uint32_t i = 0; i < samples; ++i) {
+    g_chip.frame = frames[i];
+    old_samples[i].temp_c = oldReadCelsius();
+    old_samples[i].fault = oldReadError();
+  }
+  uint64_t old_time = now() - t0;
+  uint32_t old_gpio = g_chip.gpio_calls;
+
+  g_chip = Chip{};
+  t0 = now();
+  for (uint32_t i = 0; i < samples; ++i) {
+    g_chip.frame = frames[i];
+    new_samples[i] = newReadFrame();
+  }
+  uint64_t new_time = now() - t0;
+  uint32_t new_gpio = g_chip.gpio_calls;
+
+  uint32_t mismatches = 0;
+  for (uint32_t i = 0; i < samples; ++i) {
+    const OldSample &a = old_samples[i];
+    const Max31855Reading &b = new_samples[i];
+    bool same = a.fault == b.fault && (std::isnan(a.temp_c) ? std::isnan(b.temp_c) : a.temp_c == b.temp_c);
+    if (!same && mismatches++ == 0) {
+      fprintf(stderr, "sensor bench: frame %08x old temp=%.2f fault=%u new temp=%.2f fault=%u\n", frames[i],
+              a.temp_c, a.fault, b.temp_c, b.fault);
+    }
+  }
+
+  double n = samples ? samples : 1;
+  printf("sensor bench: %u MAX31855 samples, emulated chip, host %s\n", samples, kUnit);
+  printf("  two soft-SPI frames  %8.1f %s/sample  %5.1f gpio calls/sample  64 clocks driven by the CPU\n",
+         old_time / n, kUnit, old_gpio / n);
+  printf("  one SPI transaction  %8.1f %s/sample  %5.1f gpio calls/sample  32 clocks by the peripheral "
+         "(%.1f us at %u MHz)\n",
+         new_time / n, kUnit, new_gpio / n, 32e6 / kBusClockHz, kBusClockHz / 1000000);
+  printf("%s\n", mismatches == 0 ? "ok" : "MISMATCH");
+  return mismatches == 0;
+}
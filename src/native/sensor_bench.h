@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// MAX31855 read benchmark (sim --sensor-bench N): reads N random frames from
+// an emulated chip through the path before hal_esp32.cpp moved to hardware
+// SPI (Adafruit software SPI: readCelsius() then readError(), two 32-clock
+// frames bit-banged with digitalWrite/digitalRead) and through the current
+// one (a single polled 32-bit transaction, then max31855Decode()). Prints
+// host cycles and GPIO calls per sample for both and returns false if they
+// ever decode a frame differently. The transaction is emulated as a copy:
+// the device's wait for the peripheral (32 clocks plus driver setup) is
+// printed as bus time, not counted in the cycles.
+bool sensorBenchRun(uint32_t samples, uint32_t seed);
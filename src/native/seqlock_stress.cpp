@@ -0,0 +1,140 @@
+#include "seqlock_stress.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "app_state.h"
+#include "seqlock.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Shorter than CONTROL_PERIOD_MS so a run takes seconds, not hours.
+constexpr auto kPeriod = std::chrono::microseconds(1000);
+constexpr uint8_t kReaders = 4;
+// Ticks are stored in a float field, exact up to 2^24.
+constexpr uint32_t kMaxTicks = 1u << 24;
+
+struct WriterStats {
+  std::vector<double> late_us;   // wake-up after the tick's deadline
+  std::vector<double> write_us;  // Seqlock::write() alone
+};
+
+void fillStatus(uint32_t tick, ControlStatus &status) {
+  status.state = static_cast<RunState>(tick % 5);
+  status.run_switch_enabled = tick & 1u;
+  status.last_fault = static_cast<uint8_t>(tick);
+  status.zone_count = MAX_ZONES;
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    status.t_meas_c[z] = static_cast<float>(tick) + z;
+    status.t_filt_c[z] = static_cast<float>(tick) + z + 0.5f;
+    status.t_rate_c_s[z] = static_cast<float>(tick) * 0.25f;
+    status.t_set_c[z] = static_cast<float>(tick) - z;
+    status.duty[z] = static_cast<float>(tick % 1000) / 1000.0f;
+    status.zone_fault[z] = static_cast<uint8_t>(tick + z);
+  }
+}
+
+// The snapshot's tick is in t_meas_c[0]; everything else must match it.
+bool consistent(const ControlStatus &status) {
+  ControlStatus expected;
+  fillStatus(static_cast<uint32_t>(status.t_meas_c[0]), expected);
+  // Field by field: padding is not part of the snapshot.
+  bool same = status.state == expected.state && status.run_switch_enabled == expected.run_switch_enabled &&
+              status.last_fault == expected.last_fault && status.zone_count == expected.zone_count;
+  for (uint8_t z = 0; same && z < MAX_ZONES; ++z) {
+    same = status.t_meas_c[z] == expected.t_meas_c[z] && status.t_filt_c[z] == expected.t_filt_c[z] &&
+           status.t_rate_c_s[z] == expected.t_rate_c_s[z] && status.t_set_c[z] == expected.t_set_c[z] &&
+           status.duty[z] == expected.duty[z] && status.zone_fault[z] == expected.zone_fault[z];
+  }
+  return same;
+}
+
+void runWriter(Seqlock<ControlStatus> &lock, uint32_t ticks, WriterStats &stats) {
+  ControlStatus status;
+  stats.late_us.reserve(ticks);
+  stats.write_us.reserve(ticks);
+  Clock::time_point deadline = Clock::now();
+  for (uint32_t tick = 1; tick <= ticks; ++tick) {
+    deadline += kPeriod;
+    std::this_thread::sleep_until(deadline);
+    Clock::time_point woke = Clock::now();
+    fillStatus(tick, status);
+    lock.write(status);
+    Clock::time_point done = Clock::now();
+    stats.late_us.push_back(std::chrono::duration<double, std::micro>(woke - deadline).count());
+    stats.write_us.push_back(std::chrono::duration<double, std::micro>(done - woke).count());
+  }
+}
+
+double percentile(std::vector<double> values, double pct) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(pct / 100.0 * (values.size() - 1) + 0.5);
+  return values[index];
+}
+
+void printWriter(const char *label, const WriterStats &stats) {
+  printf("%-14s late p50=%7.1fus p99=%7.1fus max=%8.1fus   write p50=%5.2fus p99=%6.2fus max=%7.1fus\n", label,
+         percentile(stats.late_us, 50), percentile(stats.late_us, 99), percentile(stats.late_us, 100),
+         percentile(stats.write_us, 50), percentile(stats.write_us, 99), percentile(stats.write_us, 100));
+}
+} // namespace
+
+bool seqlockStressRun(uint32_t ticks) {
+  ticks = std::min(ticks, kMaxTicks - 1);
+  printf("seqlock stress: %u ticks every %lldus, %u readers, ControlStatus %zu bytes\n", ticks,
+         static_cast<long long>(kPeriod.count()), kReaders, sizeof(ControlStatus));
+
+  Seqlock<ControlStatus> idle_lock;
+  WriterStats idle;
+  runWriter(idle_lock, ticks, idle);
+  printWriter("no readers", idle);
+
+  Seqlock<ControlStatus> lock;
+  ControlStatus first;
+  fillStatus(0, first);
+  lock.write(first);
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> reads{0};
+  std::atomic<uint64_t> torn{0};
+  std::atomic<uint64_t> backwards{0};
+  std::vector<std::thread> readers;
+  for (uint8_t r = 0; r < kReaders; ++r) {
+    readers.emplace_back([&]() {
+      ControlStatus copy;
+      uint64_t local_reads = 0;
+      uint32_t last_tick = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        lock.read(copy);
+        local_reads++;
+        if (!consistent(copy)) {
+          torn.fetch_add(1);
+          continue;
+        }
+        uint32_t tick = static_cast<uint32_t>(copy.t_meas_c[0]);
+        if (tick < last_tick) {
+          backwards.fetch_add(1);
+        }
+        last_tick = tick;
+      }
+      reads.fetch_add(local_reads);
+    });
+  }
+  WriterStats loaded;
+  runWriter(lock, ticks, loaded);
+  stop.store(true);
+  for (std::thread &reader : readers) {
+    reader.join();
+  }
+  printWriter("with readers", loaded);
+  printf("reads=%llu torn=%llu out_of_order=%llu\n", static_cast<unsigned long long>(reads.load()),
+         static_cast<unsigned long long>(torn.load()), static_cast<unsigned long long>(backwards.load()));
+  bool ok = torn.load() == 0 && backwards.load() == 0 && reads.load() > 0;
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Status snapshot stress test (sim --seqlock-stress N): a writer thread
+// publishes N ControlStatus snapshots through a Seqlock at a fixed period,
+// as the control task does, while reader threads copy them in a tight loop.
+// Every field of a snapshot is derived from its tick, so a mixed copy is
+// caught. Prints torn reads and the writer's wake-up jitter and write time,
+// idle and under reader load. Returns false on any torn read.
+bool seqlockStressRun(uint32_t ticks);
@@ -0,0 +1,116 @@
+#include "setpoint_bench.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "app_config.h"
+#include "hal.h"
+#include "profile.h"
+#include "profile_store.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr uint16_t kPointCounts[] = {16, 256, kMaxProfilePoints};
+constexpr char kBenchName[] = "setpoint-bench";
+// Interpolation is in float; both paths do the same arithmetic per segment.
+constexpr float kMaxDiffC = 1e-3f;
+
+uint32_t nextRandom(uint32_t &state) {
+  // xorshift32
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+bool storeProfile(uint16_t count, uint32_t &rng, std::vector<ProfilePoint> &out_points) {
+  out_points.clear();
+  uint32_t session = profileStoreWriteBegin();
+  const char *error = nullptr;
+  uint32_t t_sec = 0;
+  for (uint16_t i = 0; session && !error && i < count; ++i) {
+    ProfilePoint point;
+    point.t_sec = t_sec;
+    point.temp_c = 25.0f + static_cast<float>(nextRandom(rng) % 2000) / 10.0f;
+    t_sec += 1 + nextRandom(rng) % 5;
+    out_points.push_back(point);
+    profileStoreWritePoint(session, point, error);
+  }
+  if (session && !error) {
+    profileStoreWriteCommit(session, kBenchName, EndBehavior::HOLD_LAST, error);
+  }
+  if (!session || error) {
+    fprintf(stderr, "setpoint bench: save failed: %s\n", error ? error : "upload_busy");
+    return false;
+  }
+  return true;
+}
+
+// The evaluation before the segment cursor: scan from point 0 every tick.
+float rescanSetpoint(const std::vector<ProfilePoint> &points, uint32_t elapsed_ms) {
+  if (elapsed_ms <= points.front().t_sec * 1000) {
+    return points.front().temp_c;
+  }
+  for (size_t i = 0; i + 1 < points.size(); ++i) {
+    const ProfilePoint &a = points[i];
+    const ProfilePoint &b = points[i + 1];
+    uint32_t a_ms = a.t_sec * 1000;
+    uint32_t b_ms = b.t_sec * 1000;
+    if (elapsed_ms <= b_ms) {
+      return a.temp_c + (b.temp_c - a.temp_c) * static_cast<float>(elapsed_ms - a_ms) /
+                            static_cast<float>(b_ms - a_ms);
+    }
+  }
+  return points.back().temp_c;
+}
+
+double elapsedNs(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+bool benchOne(uint16_t count, uint32_t &rng) {
+  std::vector<ProfilePoint> points;
+  if (!storeProfile(count, rng, points) || !profileStartRun(0, kBenchName)) {
+    return false;
+  }
+  uint32_t start_ms = halMillis();
+  uint32_t end_ms = points.back().t_sec * 1000 + 10 * CONTROL_PERIOD_MS;
+  double cursor_ns = 0.0;
+  double rescan_ns = 0.0;
+  float max_diff = 0.0f;
+  uint32_t ticks = 0;
+  for (uint32_t elapsed = 0; elapsed <= end_ms; elapsed += CONTROL_PERIOD_MS, ++ticks) {
+    // The store task's read-ahead, outside the timed call as on the device.
+    if (elapsed % PROFILE_PREFETCH_MS < CONTROL_PERIOD_MS) {
+      profilePrefetch();
+    }
+    ProfileSetpoint setpoint;
+    Clock::time_point t0 = Clock::now();
+    profileGetSetpoints(start_ms + elapsed, 0, &setpoint, 1);
+    cursor_ns += elapsedNs(t0);
+    Clock::time_point t1 = Clock::now();
+    float expected = rescanSetpoint(points, elapsed);
+    rescan_ns += elapsedNs(t1);
+    max_diff = fmaxf(max_diff, isnan(setpoint.setpoint_c) ? INFINITY : fabsf(setpoint.setpoint_c - expected));
+  }
+  profileClearActive();
+  bool ok = max_diff <= kMaxDiffC;
+  printf("%6u points %7u ticks   cursor %8.1f ns/tick   rescan %9.1f ns/tick   x%-7.1f max diff %.5fC %s\n",
+         count, ticks, cursor_ns / ticks, rescan_ns / ticks, cursor_ns > 0.0 ? rescan_ns / cursor_ns : 0.0,
+         max_diff, ok ? "ok" : "MISMATCH");
+  return ok;
+}
+} // namespace
+
+bool setpointBenchRun(uint32_t seed) {
+  profileInit();
+  printf("setpoint bench: one zone, %u ms ticks, points 1-5 s apart\n", CONTROL_PERIOD_MS);
+  uint32_t rng = seed ? seed : 1;
+  bool ok = true;
+  for (uint16_t count : kPointCounts) {
+    ok = benchOne(count, rng) && ok;
+  }
+  printf("page misses: %u (pages the control step read itself)\n", profilePageMisses());
+  return ok;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Setpoint evaluation benchmark (sim --setpoint-bench): walks profiles of
+// increasing length tick by tick through profileGetSetpoints() (paged
+// segment cursor) and through a linear rescan from point 0 per tick, the
+// evaluation the cursor replaced. Prints the time per tick of both and
+// returns false if their setpoints ever disagree.
+bool setpointBenchRun(uint32_t seed);
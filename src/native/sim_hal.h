@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Arduino.h>
+#include "storage.h"
+
+// Simulator-side controls for the native HAL: the virtual clock, GPIO levels
+// and the value the thermocouple read returns next. Moving the clock runs the
+// halStartTimer() callback for every period it crosses; reset removes it.
+
+constexpr uint8_t kSimPinCount = 40;
+
+void simHalReset();
+void simHalSetMillis(uint32_t now_ms);
+void simHalAdvanceMillis(uint32_t delta_ms);
+
+int simHalPinLevel(uint8_t pin);
+void simHalSetPinLevel(uint8_t pin, uint8_t level);
+
+// Zone count reported by halZoneCount(); set before controlInit().
+void simHalSetZoneCount(uint8_t count);
+void simHalSetThermocouple(uint8_t zone, float temp_c, uint8_t fault);
+int simHalSsrLevel(uint8_t zone);
+
+// Cuts a RAM-backed store file short, as a reset in the middle of an append
+// would (storage_native.cpp).
+void simStorageTruncate(StoreFile file, uint32_t size);
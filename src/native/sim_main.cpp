@@ -0,0 +1,956 @@
+// Host simulator: runs the firmware control path (control.cpp / profile.cpp)
+// against the FOPDT oven model on a virtual clock.
+//
+//   pio run -e native && .pio/build/native/program --runs 100 --kp 0.05
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "app_config.h"
+#include "app_state.h"
+#include "autotune.h"
+#include "checkpoint.h"
+#include "control.h"
+#include "controller.h"
+#include "filter_eval.h"
+#include "hal.h"
+#include "log.h"
+#include "plant_model.h"
+#include "profile.h"
+#include "profile_store.h"
+#include "sim_hal.h"
+#include "seqlock_stress.h"
+#include "sensor_bench.h"
+#include "setpoint_bench.h"
+#include "status_bench.h"
+#include "store_bench.h"
+#include "telemetry.h"
+
+namespace {
+constexpr uint32_t kSimStepMs = 10;
+// Profile completion is detected on the control tick after the last point.
+constexpr uint32_t kCompletionSlackMs = 2000;
+// Settled = every zone within this of its setpoint from then on.
+constexpr float kSettleBandC = 2.0f;
+
+// What the firmware finds at boot after a simulated reset (simulateReset()).
+enum class ResetKind : uint8_t {
+  BROWNOUT,         // retained memory intact
+  POWER_LOSS,       // retained memory is garbage
+  TORN_WRITE,       // reset while the next checkpoint slot was half written
+  SWITCH_OFF,       // run switch off at boot
+  SENSOR_FAULT,     // zone 0's thermocouple reports a fault at boot
+  ZONE_REMOVED,     // one zone fewer configured
+  PROFILE_DELETED,  // the run's profile deleted during the outage
+  PROFILE_EDITED,   // saved again kEditShiftC hotter under the same name
+};
+// Far beyond any tolerance a resume policy would use.
+constexpr float kEditShiftC = 30.0f;
+
+struct SimOptions {
+  PlantParams plant;
+  ControlConfig config;
+  const char *profile_path = nullptr;
+  const char *csv_path = nullptr;
+  uint32_t runs = 1;
+  uint32_t hold_s = 0;
+  uint8_t zones = 1;
+  uint32_t store_bench_ops = 0;
+  uint32_t seqlock_ticks = 0;
+  uint32_t status_bench_renders = 0;
+  uint32_t sensor_bench_samples = 0;
+  bool setpoint_bench = false;
+  const char *filter_eval_path = nullptr;
+  bool filter_set = false;
+  bool controller_bench = false;
+  AutotuneConfig autotune;
+  bool autotune_run = false;
+  uint32_t brownout_s = 0;   // reset the firmware this far into the run
+  int32_t outage_s = -1;     // heater off this long around the reset; -1 = sweep
+  ResetKind reset = ResetKind::BROWNOUT;
+  bool resume_check = false;
+  ResumePolicy resume;
+  bool batch = false;
+  bool verbose = false;
+};
+
+struct RunResult {
+  uint32_t sim_ms = 0;
+  uint32_t samples = 0;
+  double sq_error_sum = 0.0;
+  float max_abs_error_c = 0.0f;
+  float max_overshoot_c = 0.0f;
+  float max_lag_c = 0.0f;        // worst shortfall while the setpoint rises
+  float max_set_c = 0.0f;
+  uint32_t last_tick_ms = 0;
+  uint32_t last_change_ms = 0;   // last tick the setpoint moved
+  uint32_t last_outside_ms = 0;  // last tick a zone was outside kSettleBandC
+  float peak_temp_c = 0.0f;
+  uint32_t ssr_switches = 0;
+  double requested_on_ms = 0.0;  // duty handed to the SSR, integrated
+  double delivered_on_ms = 0.0;  // time the SSR actually conducted
+  double tick_wall_us_sum = 0.0;  // host time spent in the control tick
+  double tick_wall_us_max = 0.0;
+  RunState final_state = RunState::IDLE;
+  ResumeDecision resume = ResumeDecision::NO_CHECKPOINT;
+};
+
+void printUsage(const char *argv0) {
+  printf("usage: %s [options]\n", argv0);
+  printf("  --profile FILE   CSV of t_sec,temp_c, up to %u points (default: built-in lead-free reflow)\n",
+         kMaxProfilePoints);
+  printf("  --runs N         repeat the run N times (throughput check)\n");
+  printf("  --hold S         keep running S seconds after the last point\n");
+  printf("  --zones N        independent zones (1..%u), each with a slightly different plant\n", MAX_ZONES);
+  printf("  --controller p|pid --kp X --ki X --kd X --bias X --aw clamp|back --kb X\n");
+  printf("  --ff X --ff-lead S   feedforward: duty per C/s of the profile slope S seconds ahead\n");
+  printf("  --controller-bench   tracking of P/PI/PID/feedforward presets for this plant, then exit\n");
+  printf("  --autotune C [--hysteresis C --cycles N]   relay autotune at setpoint C: estimates against\n");
+  printf("                   the plant, then the profile with the suggested gains, then exit\n");
+  printf("  --window MS --tmax C\n");
+  printf("  --smooth N | --ema ALPHA, --median N, --rate N   measurement filter (filter.h)\n");
+  printf("  --ssr-mode tp|burst --min-on MS --min-off MS\n");
+  printf("  --brownout S [--outage S] [--resume-tolerance C --resume-drop C]   reset the firmware S seconds\n");
+  printf("                   into the run and resume from the run checkpoint; without --outage, a sweep\n");
+  printf("  --resume-check   resets that must and must not resume, with the expected decision each, then exit\n");
+  printf("  --ambient C --gain C --tau S --dead S --noise C --spikes P --seed N\n");
+  printf("  --csv FILE       write a per-tick trace of the last run\n");
+  printf("  --verbose        print controlLogStatus() output\n");
+  printf("  --batch          read one set of options per stdin line, print one result line each\n");
+  printf("                   (tools/autotune.py)\n");
+  printf("  --filter-eval FILE  replay a --csv or decoded run log trace through the filters, then exit\n");
+  printf("  --store-bench N  profile store write benchmark over N ops (uses --seed), then exit\n");
+  printf("  --setpoint-bench  segment cursor against a rescan per tick, 16..%u points (uses --seed), then exit\n",
+         kMaxProfilePoints);
+  printf("  --seqlock-stress N  N status snapshots under reader load: torn reads and writer jitter, then exit\n");
+  printf("  --status-bench N  render N /api/status bodies into a slot and by String concatenation (uses --seed),\n");
+  printf("                   then exit\n");
+  printf("  --sensor-bench N  read N MAX31855 frames by two soft-SPI reads and by one SPI transaction\n");
+  printf("                   (uses --seed), then exit\n");
+}
+
+bool parseArgs(int argc, char **argv, SimOptions &opts) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--verbose") == 0) {
+      opts.verbose = true;
+      continue;
+    }
+    if (strcmp(arg, "--controller-bench") == 0) {
+      opts.controller_bench = true;
+      continue;
+    }
+    if (strcmp(arg, "--setpoint-bench") == 0) {
+      opts.setpoint_bench = true;
+      continue;
+    }
+    if (strcmp(arg, "--resume-check") == 0) {
+      opts.resume_check = true;
+      continue;
+    }
+    if (strcmp(arg, "--batch") == 0) {
+      opts.batch = true;
+      continue;
+    }
+    if (strcmp(arg, "--help") == 0 || i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (strcmp(arg, "--profile") == 0) opts.profile_path = value;
+    else if (strcmp(arg, "--csv") == 0) opts.csv_path = value;
+    else if (strcmp(arg, "--runs") == 0) opts.runs = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--hold") == 0) opts.hold_s = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--store-bench") == 0) opts.store_bench_ops = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--seqlock-stress") == 0) opts.seqlock_ticks = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--status-bench") == 0) opts.status_bench_renders = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--sensor-bench") == 0) opts.sensor_bench_samples = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--zones") == 0) opts.zones = static_cast<uint8_t>(strtoul(value, nullptr, 10));
+    else if (strcmp(arg, "--controller") == 0) {
+      if (strcmp(value, "p") == 0) opts.config.controller = ControllerKind::P;
+      else if (strcmp(value, "pid") == 0) opts.config.controller = ControllerKind::PID;
+      else return false;
+    }
+    else if (strcmp(arg, "--kp") == 0) opts.config.kp = strtof(value, nullptr);
+    else if (strcmp(arg, "--ki") == 0) opts.config.ki = strtof(value, nullptr);
+    else if (strcmp(arg, "--kd") == 0) opts.config.kd = strtof(value, nullptr);
+    else if (strcmp(arg, "--kb") == 0) opts.config.kb = strtof(value, nullptr);
+    else if (strcmp(arg, "--aw") == 0) {
+      if (strcmp(value, "clamp") == 0) opts.config.anti_windup = AntiWindup::CLAMP;
+      else if (strcmp(value, "back") == 0) opts.config.anti_windup = AntiWindup::BACK_CALCULATION;
+      else return false;
+    }
+    else if (strcmp(arg, "--autotune") == 0) {
+      opts.autotune.setpoint_c = strtof(value, nullptr);
+      opts.autotune.apply = true;
+      opts.autotune_run = true;
+    }
+    else if (strcmp(arg, "--brownout") == 0) opts.brownout_s = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--outage") == 0) opts.outage_s = static_cast<int32_t>(strtol(value, nullptr, 10));
+    else if (strcmp(arg, "--resume-tolerance") == 0) opts.resume.tolerance_c = strtof(value, nullptr);
+    else if (strcmp(arg, "--resume-drop") == 0) opts.resume.max_drop_c = strtof(value, nullptr);
+    else if (strcmp(arg, "--hysteresis") == 0) opts.autotune.hysteresis_c = strtof(value, nullptr);
+    else if (strcmp(arg, "--cycles") == 0) opts.autotune.cycles = static_cast<uint8_t>(strtoul(value, nullptr, 10));
+    else if (strcmp(arg, "--ff") == 0) opts.config.ff_gain = strtof(value, nullptr);
+    else if (strcmp(arg, "--ff-lead") == 0) opts.config.ff_lead_s = strtof(value, nullptr);
+    else if (strcmp(arg, "--bias") == 0) opts.config.bias = strtof(value, nullptr);
+    else if (strcmp(arg, "--window") == 0) opts.config.window_ms = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--smooth") == 0) {
+      opts.config.filter.smoothing = FilterSmoothing::MOVING_AVERAGE;
+      opts.config.filter.average_window = static_cast<uint8_t>(strtoul(value, nullptr, 10));
+      opts.filter_set = true;
+    } else if (strcmp(arg, "--ema") == 0) {
+      opts.config.filter.smoothing = FilterSmoothing::EMA;
+      opts.config.filter.ema_alpha = strtof(value, nullptr);
+      opts.filter_set = true;
+    } else if (strcmp(arg, "--median") == 0) {
+      opts.config.filter.median_window = static_cast<uint8_t>(strtoul(value, nullptr, 10));
+      opts.filter_set = true;
+    } else if (strcmp(arg, "--rate") == 0) {
+      opts.config.filter.rate_window = static_cast<uint8_t>(strtoul(value, nullptr, 10));
+      opts.filter_set = true;
+    }
+    else if (strcmp(arg, "--filter-eval") == 0) opts.filter_eval_path = value;
+    else if (strcmp(arg, "--tmax") == 0) opts.config.tmax_c = strtof(value, nullptr);
+    else if (strcmp(arg, "--min-on") == 0) opts.config.min_on_ms = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--min-off") == 0) opts.config.min_off_ms = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--ssr-mode") == 0) {
+      if (strcmp(value, "tp") == 0) opts.config.ssr_mode = SsrMode::TIME_PROPORTIONAL;
+      else if (strcmp(value, "burst") == 0) opts.config.ssr_mode = SsrMode::BURST;
+      else return false;
+    }
+    else if (strcmp(arg, "--ambient") == 0) opts.plant.ambient_c = strtof(value, nullptr);
+    else if (strcmp(arg, "--gain") == 0) opts.plant.gain_c = strtof(value, nullptr);
+    else if (strcmp(arg, "--tau") == 0) opts.plant.time_constant_s = strtof(value, nullptr);
+    else if (strcmp(arg, "--dead") == 0) opts.plant.dead_time_s = strtof(value, nullptr);
+    else if (strcmp(arg, "--noise") == 0) opts.plant.noise_c = strtof(value, nullptr);
+    else if (strcmp(arg, "--spikes") == 0) opts.plant.spike_rate = strtof(value, nullptr);
+    else if (strcmp(arg, "--seed") == 0) opts.plant.seed = strtoul(value, nullptr, 10);
+    else return false;
+  }
+  return opts.runs > 0 && opts.zones >= 1 && opts.zones <= MAX_ZONES;
+}
+
+void loadDefaultProfile(Profile &profile) {
+  // Lead-free (SAC305) style: preheat, soak, reflow peak, cool.
+  static const ProfilePoint kPoints[] = {
+      {0, 25.0f}, {90, 150.0f}, {180, 180.0f}, {240, 217.0f},
+      {270, 245.0f}, {300, 217.0f}, {360, 150.0f}, {420, 80.0f},
+  };
+  strlcpy(profile.name, "sim-default", sizeof(profile.name));
+  profile.end_behavior = EndBehavior::STOP;
+  profile.count = sizeof(kPoints) / sizeof(kPoints[0]);
+  for (uint8_t i = 0; i < profile.count; ++i) {
+    profile.points[i] = kPoints[i];
+  }
+}
+
+// Streams the CSV into the profile store like an upload would.
+bool storeProfileCsv(const char *path, const char *name) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  uint32_t session = profileStoreWriteBegin();
+  const char *error = nullptr;
+  char line[128];
+  while (session && !error && fgets(line, sizeof(line), file)) {
+    unsigned long t_sec = 0;
+    float temp_c = 0.0f;
+    if (sscanf(line, "%lu , %f", &t_sec, &temp_c) != 2) {
+      continue;
+    }
+    ProfilePoint point;
+    point.t_sec = static_cast<uint32_t>(t_sec);
+    point.temp_c = temp_c;
+    profileStoreWritePoint(session, point, error);
+  }
+  fclose(file);
+  if (!error) {
+    profileStoreWriteCommit(session, name, EndBehavior::STOP, error);
+  }
+  if (error) {
+    fprintf(stderr, "profile rejected: %s\n", error);
+  }
+  return error == nullptr;
+}
+
+bool heaterOn(const ControlConfig &config, uint8_t zone) {
+  int level = simHalSsrLevel(zone);
+  return config.ssr_active_high ? level == HIGH : level == LOW;
+}
+
+// Zone z gets a slightly weaker, slower heater so the zones diverge.
+PlantParams zonePlant(const SimOptions &opts, uint8_t zone) {
+  PlantParams params = opts.plant;
+  params.gain_c *= 1.0f - 0.03f * zone;
+  params.time_constant_s *= 1.0f + 0.05f * zone;
+  params.seed += zone;
+  return params;
+}
+
+// Fresh plants and firmware state with the switch on and one sample taken.
+void startSim(const SimOptions &opts, PlantModel *plants) {
+  for (uint8_t z = 0; z < opts.zones; ++z) {
+    plantInit(plants[z], zonePlant(opts, z), kSimStepMs);
+  }
+
+  simHalReset();
+  simHalSetZoneCount(opts.zones);
+  simHalSetPinLevel(PIN_RUN_SWITCH, opts.config.switch_active_high ? HIGH : LOW);
+  for (uint8_t z = 0; z < opts.zones; ++z) {
+    simHalSetThermocouple(z, plantSensorTemp(plants[z]), 0);
+  }
+
+  g_control = ControlData{};
+  g_control.config = opts.config;
+  controlInit();
+  // controlInit() configures the switch pin with a pull-up; re-assert the
+  // simulated switch position afterwards.
+  simHalSetPinLevel(PIN_RUN_SWITCH, opts.config.switch_active_high ? HIGH : LOW);
+
+  controlUpdateTemperature();
+  controlUpdateState();
+}
+
+// Saves checkpoint into the next slot, then puts back the second half of
+// the bytes that changed, as a reset in the middle of checkpointSave()
+// would leave them.
+void tearCheckpointWrite(RunCheckpoint checkpoint) {
+  uint8_t *memory = static_cast<uint8_t *>(halRetainedMemory());
+  static uint8_t before[RETAINED_MEMORY_BYTES];
+  memcpy(before, memory, sizeof(before));
+  checkpointSave(checkpoint);
+  size_t first = RETAINED_MEMORY_BYTES;
+  size_t last = 0;
+  for (size_t i = 0; i < RETAINED_MEMORY_BYTES; ++i) {
+    if (memory[i] != before[i]) {
+      first = min(first, i);
+      last = i;
+    }
+  }
+  if (first < last) {
+    size_t middle = first + (last - first) / 2 + 1;
+    memcpy(memory + middle, before + middle, last + 1 - middle);
+  }
+}
+
+// Stores the named profile again with every point shifted by delta_c.
+bool shiftStoredProfile(const char *name, float delta_c) {
+  ProfileInfo info;
+  if (!profileStoreFind(name, info)) {
+    return false;
+  }
+  uint32_t session = profileStoreWriteBegin();
+  const char *error = nullptr;
+  for (uint16_t i = 0; session && !error && i < info.count; ++i) {
+    ProfilePoint point;
+    if (!profileStoreReadPoints(info, i, &point, 1)) {
+      error = "read_failed";
+      break;
+    }
+    point.temp_c += delta_c;
+    profileStoreWritePoint(session, point, error);
+  }
+  if (session && !error) {
+    profileStoreWriteCommit(session, name, info.end_behavior, error);
+  } else if (session) {
+    profileStoreWriteAbort(session);
+  }
+  return session && !error;
+}
+
+// A reset at the current tick: the heater is off for the outage, firmware
+// RAM is lost, retained memory survives unless the power went entirely.
+// The firmware then boots, in the state opts.reset describes, and decides
+// on the checkpoint.
+ResumeDecision simulateReset(const SimOptions &opts, PlantModel *plants) {
+  uint32_t steps = static_cast<uint32_t>(max<int32_t>(opts.outage_s, 0)) * 1000 / kSimStepMs;
+  for (uint32_t i = 0; i < steps; ++i) {
+    for (uint8_t z = 0; z < opts.zones; ++z) {
+      plantStep(plants[z], 0.0f);
+    }
+  }
+  char profile[kMaxProfileNameLength + 1];
+  profileCopyActiveName(0, profile, sizeof(profile));
+  RunCheckpoint next;
+  if (opts.reset == ResetKind::POWER_LOSS) {
+    memset(halRetainedMemory(), 0xA5, RETAINED_MEMORY_BYTES);
+  } else if (opts.reset == ResetKind::TORN_WRITE && checkpointLoad(next)) {
+    tearCheckpointWrite(next);
+  }
+  profileClearActive();
+  if (opts.reset == ResetKind::PROFILE_DELETED) {
+    profileStoreDelete(profile);
+  } else if (opts.reset == ResetKind::PROFILE_EDITED && !shiftStoredProfile(profile, kEditShiftC)) {
+    fprintf(stderr, "cannot edit profile %s\n", profile);
+  }
+  g_control = ControlData{};
+  g_control.config = opts.config;
+  if (opts.reset == ResetKind::ZONE_REMOVED) {
+    simHalSetZoneCount(opts.zones - 1);
+  }
+  controlInit();
+  bool switch_on = opts.reset != ResetKind::SWITCH_OFF;
+  simHalSetPinLevel(PIN_RUN_SWITCH, switch_on == opts.config.switch_active_high ? HIGH : LOW);
+  for (uint8_t z = 0; z < opts.zones; ++z) {
+    bool fault = z == 0 && opts.reset == ResetKind::SENSOR_FAULT;
+    simHalSetThermocouple(z, plantSensorTemp(plants[z]), fault ? 1 : 0);
+  }
+  controlUpdateTemperature();
+  controlUpdateState();
+  controlComputeControl();
+  return controlResumeRun(opts.resume);
+}
+
+RunResult runOnce(const SimOptions &opts, const ProfileInfo &profile, FILE *csv) {
+  RunResult result;
+  PlantModel plants[MAX_ZONES];
+  startSim(opts, plants);
+  for (uint8_t z = 0; z < opts.zones; ++z) {
+    profileStartRun(z, profile.name);
+  }
+  if (!controlTryStartRun()) {
+    fprintf(stderr, "run refused (switch/fault)\n");
+    exit(1);
+  }
+
+  uint32_t start_ms = halMillis();
+  ProfilePoint last_point;
+  if (!profileStoreReadPoints(profile, profile.count - 1, &last_point, 1)) {
+    fprintf(stderr, "profile unreadable\n");
+    exit(1);
+  }
+  uint32_t last_point_ms = last_point.t_sec * 1000;
+  uint32_t end_ms = last_point_ms + opts.hold_s * 1000 + kCompletionSlackMs;
+  float last_set[MAX_ZONES];
+  for (uint8_t z = 0; z < opts.zones; ++z) {
+    last_set[z] = NAN;
+  }
+  bool last_heater[MAX_ZONES] = {};
+  float handed_duty[MAX_ZONES] = {};
+
+  for (uint32_t elapsed = 0; elapsed <= end_ms; elapsed += kSimStepMs) {
+    uint32_t now_ms = start_ms + elapsed;
+    simHalSetMillis(now_ms);
+
+    bool sample = elapsed % TEMP_SAMPLE_MS == 0;
+    bool control = elapsed % CONTROL_PERIOD_MS == 0;
+    if (sample) {
+      for (uint8_t z = 0; z < opts.zones; ++z) {
+        simHalSetThermocouple(z, plantSensorTemp(plants[z]), 0);
+      }
+    }
+    auto tick_start = std::chrono::steady_clock::now();
+    if (sample) {
+      controlUpdateTemperature();
+    }
+    if (control) {
+      if (opts.brownout_s && elapsed == opts.brownout_s * 1000) {
+        result.resume = simulateReset(opts, plants);
+      }
+      controlUpdateState();
+      controlComputeControl();
+      controlUpdateSsrOutput();
+      telemetryPublish(now_ms);
+      double tick_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tick_start).count();
+      result.tick_wall_us_sum += tick_us;
+      if (tick_us > result.tick_wall_us_max) result.tick_wall_us_max = tick_us;
+      if (opts.verbose) {
+        controlLogStatus(now_ms);
+        logProcess();
+      }
+      // The firmware's store task reads ahead on its own period.
+      if (elapsed % PROFILE_PREFETCH_MS == 0) {
+        profilePrefetch();
+      }
+
+      ControlStatus status{};
+      controlGetStatus(status);
+      result.final_state = status.state;
+      if (status.state != RunState::RUNNING) {
+        break;
+      }
+      result.samples++;
+      result.last_tick_ms = elapsed;
+      for (uint8_t z = 0; z < opts.zones; ++z) {
+        handed_duty[z] = status.duty[z];
+        float error_c = status.t_set_c[z] - plants[z].temp_c;
+        result.sq_error_sum += static_cast<double>(error_c) * error_c;
+        if (fabsf(error_c) > result.max_abs_error_c) result.max_abs_error_c = fabsf(error_c);
+        if (-error_c > result.max_overshoot_c) result.max_overshoot_c = -error_c;
+        if (status.t_set_c[z] > last_set[z] && error_c > result.max_lag_c) result.max_lag_c = error_c;
+        if (status.t_set_c[z] != last_set[z]) result.last_change_ms = elapsed;
+        if (fabsf(error_c) > kSettleBandC) result.last_outside_ms = elapsed;
+        last_set[z] = status.t_set_c[z];
+        if (status.t_set_c[z] > result.max_set_c) result.max_set_c = status.t_set_c[z];
+      }
+      if (csv) {
+        for (uint8_t z = 0; z < opts.zones; ++z) {
+          fprintf(csv, "%.1f,%u,%.2f,%.2f,%.2f,%.3f,%.2f\n", elapsed / 1000.0f, z, status.t_set_c[z],
+                  plants[z].temp_c, status.t_meas_c[z], status.duty[z], status.t_filt_c[z]);
+        }
+      }
+    }
+
+    for (uint8_t z = 0; z < opts.zones; ++z) {
+      bool heater = heaterOn(g_control.config, z);
+      if (heater != last_heater[z]) {
+        result.ssr_switches++;
+        last_heater[z] = heater;
+      }
+      result.requested_on_ms += static_cast<double>(handed_duty[z]) * kSimStepMs;
+      result.delivered_on_ms += heater ? kSimStepMs : 0;
+      plantStep(plants[z], heater ? 1.0f : 0.0f);
+      if (plants[z].temp_c > result.peak_temp_c) result.peak_temp_c = plants[z].temp_c;
+    }
+    result.sim_ms = elapsed;
+  }
+
+  controlStopRun();
+  return result;
+}
+
+const char *stateLabel(RunState state) {
+  switch (state) {
+    case RunState::IDLE: return "IDLE";
+    case RunState::RUNNING: return "RUNNING";
+    case RunState::SWITCH_DISABLED: return "DISABLED";
+    case RunState::FAULT: return "ERROR";
+    case RunState::AUTOTUNE: return "AUTOTUNE";
+    default: return "UNKNOWN";
+  }
+}
+void formatSettling(const RunResult &result, char *out, size_t len) {
+  if (result.last_change_ms >= result.last_tick_ms) {
+    snprintf(out, len, "-");  // the setpoint never stopped moving
+  } else if (result.last_outside_ms >= result.last_tick_ms) {
+    snprintf(out, len, "none");
+  } else if (result.last_outside_ms < result.last_change_ms) {
+    snprintf(out, len, "0.0s");
+  } else {
+    snprintf(out, len, "%.1fs", (result.last_outside_ms - result.last_change_ms + CONTROL_PERIOD_MS) / 1000.0f);
+  }
+}
+
+// SIMC-style gains for the FOPDT plant; the SSR window adds about half a
+// window of dead time.
+void presetConfigs(const SimOptions &opts, ControlConfig *out, const char **names, uint8_t &count) {
+  float gain = opts.plant.gain_c;
+  float tau = opts.plant.time_constant_s;
+  float theta = opts.plant.dead_time_s + opts.config.window_ms / 2000.0f;
+  float kc = tau / (gain * 2.0f * theta);
+  float ti = min(tau, 8.0f * theta);
+  float td = theta / 3.0f;
+  count = 0;
+  names[count] = "p";
+  out[count++] = opts.config;
+  names[count] = "p+ff";
+  out[count] = opts.config;
+  out[count].ff_gain = tau / gain;
+  out[count++].ff_lead_s = theta;
+  names[count] = "pi clamp";
+  out[count] = opts.config;
+  out[count].controller = ControllerKind::PID;
+  out[count].kp = kc;
+  out[count].ki = kc / ti;
+  out[count++].kd = 0.0f;
+  names[count] = "pid clamp";
+  out[count] = out[count - 1];
+  out[count++].kd = kc * td;
+  names[count] = "pid back-calc";
+  out[count] = out[count - 1];
+  out[count].anti_windup = AntiWindup::BACK_CALCULATION;
+  out[count++].kb = 1.0f / sqrtf(ti * td);
+  names[count] = "pid back-calc+ff";
+  out[count] = out[count - 1];
+  out[count].ff_gain = tau / gain;
+  out[count++].ff_lead_s = theta;
+}
+
+// Worker mode for tools/autotune.py: each stdin line holds options applied
+// on top of the command line ones; the profile and plant stay loaded.
+int batchLoop(const SimOptions &base, const ProfileInfo &profile) {
+  char line[512];
+  while (fgets(line, sizeof(line), stdin)) {
+    char *argv[64] = {const_cast<char *>("batch")};
+    int argc = 1;
+    for (char *token = strtok(line, " \t\r\n"); token && argc < 64; token = strtok(nullptr, " \t\r\n")) {
+      argv[argc++] = token;
+    }
+    SimOptions opts = base;
+    if (!parseArgs(argc, argv, opts)) {
+      printf("error bad_options\n");
+      fflush(stdout);
+      continue;
+    }
+    RunResult result = runOnce(opts, profile, nullptr);
+    double rms = result.samples ? sqrt(result.sq_error_sum / (result.samples * opts.zones)) : 0.0;
+    printf("ok rms=%.4f max_error=%.4f overshoot=%.4f lag=%.4f switches=%u state=%s\n", rms,
+           result.max_abs_error_c, result.max_overshoot_c, result.max_lag_c, result.ssr_switches,
+           stateLabel(result.final_state));
+    fflush(stdout);
+  }
+  return 0;
+}
+
+// Ultimate gain and period of the FOPDT plant: the frequency where
+// atan(w * tau) + w * theta = pi, found by bisection.
+void plantUltimate(float gain, float tau, float theta, float &ku, float &pu_s) {
+  float low = 0.0f;
+  float high = 3.14159265f / theta;
+  for (int i = 0; i < 60; ++i) {
+    float w = (low + high) / 2.0f;
+    if (atanf(w * tau) + w * theta < 3.14159265f) low = w;
+    else high = w;
+  }
+  float w = (low + high) / 2.0f;
+  ku = sqrtf(1.0f + w * tau * w * tau) / gain;
+  pu_s = 6.2831853f / w;
+}
+
+// Relay experiment through the firmware path (controlStartAutotune), then
+// the profile with the suggested gains next to the default P controller.
+int autotuneSim(SimOptions opts, const ProfileInfo &profile) {
+  PlantModel plants[MAX_ZONES];
+  startSim(opts, plants);
+  const char *error = nullptr;
+  if (!controlStartAutotune(opts.autotune, error)) {
+    fprintf(stderr, "autotune refused: %s\n", error);
+    return 1;
+  }
+  uint32_t start_ms = halMillis();
+  uint32_t switches = 0;
+  bool last_heater[MAX_ZONES] = {};
+  ControlStatus status{};
+  uint32_t elapsed = 0;
+  for (; elapsed <= (opts.autotune.max_s + 10) * 1000; elapsed += kSimStepMs) {
+    simHalSetMillis(start_ms + elapsed);
+    if (elapsed % TEMP_SAMPLE_MS == 0) {
+      for (uint8_t z = 0; z < opts.zones; ++z) {
+        simHalSetThermocouple(z, plantSensorTemp(plants[z]), 0);
+      }
+      controlUpdateTemperature();
+    }
+    if (elapsed % CONTROL_PERIOD_MS == 0) {
+      controlUpdateState();
+      controlComputeControl();
+      controlUpdateSsrOutput();
+      if (opts.verbose) {
+        controlLogStatus(start_ms + elapsed);
+        logProcess();
+      }
+      controlGetStatus(status);
+      if (status.state != RunState::AUTOTUNE) {
+        break;
+      }
+    }
+    for (uint8_t z = 0; z < opts.zones; ++z) {
+      bool heater = heaterOn(g_control.config, z);
+      switches += heater != last_heater[z];
+      last_heater[z] = heater;
+      plantStep(plants[z], heater ? 1.0f : 0.0f);
+    }
+  }
+  AutotuneState autotune;
+  controlGetAutotune(autotune);
+  printf("autotune setpoint=%.1fC hysteresis=%.2fC cycles=%u: %s%s%s after %.1fs, %u ssr switches\n",
+         autotune.config.setpoint_c, autotune.config.hysteresis_c, autotune.config.cycles,
+         autotunePhaseName(autotune.phase), autotune.reason[0] ? " " : "", autotune.reason, elapsed / 1000.0f,
+         switches);
+  float window_s = opts.config.window_ms / 1000.0f;
+  for (uint8_t z = 0; z < autotune.zone_count; ++z) {
+    const AutotuneResult &result = autotune.zones[z].result;
+    PlantParams plant = zonePlant(opts, z);
+    // The relay runs at 0/100% duty, so the SSR window adds no delay; the
+    // sampling and control period add about one period.
+    float theta = plant.dead_time_s + (opts.autotune.high_duty < 1.0f ? window_s / 2.0f : 0.0f) +
+                  CONTROL_PERIOD_MS / 1000.0f;
+    float ku = 0.0f;
+    float pu_s = 0.0f;
+    plantUltimate(plant.gain_c, plant.time_constant_s, theta, ku, pu_s);
+    printf("  zone %u  %-8s %9s %9s %9s %9s %9s\n", z, "", "ku", "pu_s", "theta_s", "tau_s", "gain_c");
+    printf("          %-8s %9.4f %9.1f %9.2f %9.1f %9.1f\n", "estimate", result.ku, result.pu_s, result.theta_s,
+           result.tau_s, result.gain_c);
+    printf("          %-8s %9.4f %9.1f %9.2f %9.1f %9.1f\n", "plant", ku, pu_s, theta, plant.time_constant_s,
+           plant.gain_c);
+    printf("          gains kp=%.4f ki=%.5f kd=%.3f ff=%.3f@%.1fs (amplitude %.2fC)\n", result.kp, result.ki,
+           result.kd, result.ff_gain, result.ff_lead_s, result.amplitude_c);
+  }
+  if (autotune.phase != AutotunePhase::DONE) {
+    return 1;
+  }
+  ControlConfig tuned = opts.config;
+  autotuneApply(autotune, tuned);
+  const ControlConfig configs[] = {opts.config, tuned};
+  const char *names[] = {"before", "autotuned"};
+  printf("%s (%u points)\n", profile.name, profile.count);
+  for (uint8_t i = 0; i < 2; ++i) {
+    opts.config = configs[i];
+    RunResult result = runOnce(opts, profile, nullptr);
+    double rms = result.samples ? sqrt(result.sq_error_sum / (result.samples * opts.zones)) : 0.0;
+    printf("  %-10s %-3s rms=%6.2fC max_error=%6.2fC overshoot=%6.2fC lag=%6.2fC state=%s\n", names[i],
+           controllerName(configs[i].controller), rms, result.max_abs_error_c, result.max_overshoot_c,
+           result.max_lag_c, stateLabel(result.final_state));
+  }
+  return 0;
+}
+
+// Brownouts of growing length at the same point of the run, against the
+// default resume policy (or the one given).
+int brownoutSweep(SimOptions opts, const ProfileInfo &profile) {
+  printf("%s, reset at %us, tolerance %.1fC, max drop %.1fC\n", profile.name, opts.brownout_s,
+         opts.resume.tolerance_c, opts.resume.max_drop_c);
+  const int32_t outages[] = {-1, 0, 5, 15, 30, 60, 120, 0};
+  uint8_t count = sizeof(outages) / sizeof(outages[0]);
+  for (uint8_t i = 0; i < count; ++i) {
+    SimOptions run = opts;
+    run.outage_s = outages[i];
+    run.reset = i + 1 == count ? ResetKind::POWER_LOSS : ResetKind::BROWNOUT;
+    if (outages[i] < 0) {
+      run.brownout_s = 0;  // reference: no reset
+    }
+    RunResult result = runOnce(run, profile, nullptr);
+    double rms = result.samples ? sqrt(result.sq_error_sum / (result.samples * run.zones)) : 0.0;
+    char label[24];
+    if (outages[i] < 0) snprintf(label, sizeof(label), "no reset");
+    else if (run.reset == ResetKind::POWER_LOSS) snprintf(label, sizeof(label), "power loss");
+    else snprintf(label, sizeof(label), "outage %lds", static_cast<long>(outages[i]));
+    printf("  %-12s resume=%-15s final=%-8s ran=%6.1fs rms=%6.2fC overshoot=%6.2fC\n", label,
+           outages[i] < 0 ? "-" : resumeDecisionName(result.resume), stateLabel(result.final_state),
+           result.sim_ms / 1000.0f, rms, result.max_overshoot_c);
+  }
+  return 0;
+}
+
+// One reset per case at the same point of the default profile, each
+// expected to end in one decision; a resumed run must also reach the end of
+// the profile. Uses the default plant and policy unless a case says
+// otherwise, so the expectations hold whatever else was given.
+bool resumeCheck() {
+  struct Case {
+    const char *label;
+    ResetKind reset;
+    int32_t outage_s;
+    uint8_t zones;
+    bool enabled;
+    ResumeDecision expected;
+  };
+  static const Case kCases[] = {
+      {"reset only", ResetKind::BROWNOUT, 0, 1, true, ResumeDecision::RESUME},
+      {"outage 10s", ResetKind::BROWNOUT, 10, 1, true, ResumeDecision::RESUME},
+      {"2 zones 10s", ResetKind::BROWNOUT, 10, 2, true, ResumeDecision::RESUME},
+      {"torn write", ResetKind::TORN_WRITE, 0, 1, true, ResumeDecision::RESUME},
+      {"disabled", ResetKind::BROWNOUT, 0, 1, false, ResumeDecision::DISABLED},
+      {"switch off", ResetKind::SWITCH_OFF, 0, 1, true, ResumeDecision::NOT_IDLE},
+      {"sensor fault", ResetKind::SENSOR_FAULT, 0, 1, true, ResumeDecision::NOT_IDLE},
+      {"zone removed", ResetKind::ZONE_REMOVED, 0, 2, true, ResumeDecision::ZONES_CHANGED},
+      {"prof deleted", ResetKind::PROFILE_DELETED, 0, 1, true, ResumeDecision::PROFILE_MISSING},
+      {"prof edited", ResetKind::PROFILE_EDITED, 0, 1, true, ResumeDecision::OFF_PROFILE},
+      {"outage 60s", ResetKind::BROWNOUT, 60, 1, true, ResumeDecision::OFF_PROFILE},
+      {"outage 120s", ResetKind::BROWNOUT, 120, 1, true, ResumeDecision::COOLED},
+      {"power loss", ResetKind::POWER_LOSS, 0, 1, true, ResumeDecision::NO_CHECKPOINT},
+  };
+  constexpr uint32_t kResetS = 100;
+  SimOptions base;
+  printf("resume check: sim-default, reset at %us, tolerance %.1fC, max drop %.1fC\n", kResetS,
+         base.resume.tolerance_c, base.resume.max_drop_c);
+  bool ok = true;
+  for (const Case &c : kCases) {
+    // Each case starts from the unedited profile.
+    Profile builtin{};
+    loadDefaultProfile(builtin);
+    const char *error = nullptr;
+    ProfileInfo profile;
+    if (!profileStoreAdd(builtin, error) || !profileStoreFind(builtin.name, profile)) {
+      fprintf(stderr, "profile rejected: %s\n", error ? error : "not_found");
+      return false;
+    }
+    SimOptions run = base;
+    run.brownout_s = kResetS;
+    run.outage_s = c.outage_s;
+    run.reset = c.reset;
+    run.zones = c.zones;
+    run.resume.enabled = c.enabled;
+    ProfilePoint last_point;
+    profileStoreReadPoints(profile, profile.count - 1, &last_point, 1);
+    RunResult result = runOnce(run, profile, nullptr);
+    bool finished = result.sim_ms >= last_point.t_sec * 1000;
+    bool pass = result.resume == c.expected && finished == (c.expected == ResumeDecision::RESUME);
+    printf("  %-13s expected=%-15s got=%-15s ran=%6.1fs %s\n", c.label, resumeDecisionName(c.expected),
+           resumeDecisionName(result.resume), result.sim_ms / 1000.0f, pass ? "ok" : "WRONG");
+    ok = pass && ok;
+  }
+
+  // A zone without a temperature cannot be reached through a boot: the
+  // sensor fault stops at NOT_IDLE first.
+  RunCheckpoint checkpoint;
+  checkpoint.zone_count = 1;
+  strlcpy(checkpoint.zones[0].profile, "sim-default", sizeof(checkpoint.zones[0].profile));
+  checkpoint.zones[0].temp_c = 150.0f;
+  checkpoint.zones[0].set_c = 170.0f;
+  float temp_c = NAN;
+  float expected_c = 170.0f;
+  ResumeDecision sensor = resumeDecide(base.resume, checkpoint, RunState::IDLE, 1, &temp_c, &expected_c);
+  bool pass = sensor == ResumeDecision::SENSOR;
+  printf("  %-13s expected=%-15s got=%-15s %s\n", "no reading", "SENSOR", resumeDecisionName(sensor),
+         pass ? "ok" : "WRONG");
+  ok = pass && ok;
+
+  // The slot a torn write hits is not the newest valid one: the load falls
+  // back to the checkpoint before it.
+  checkpointClear();
+  checkpoint.zones[0].elapsed_ms = 1000;
+  checkpointSave(checkpoint);
+  checkpoint.zones[0].elapsed_ms = 2000;
+  checkpointSave(checkpoint);
+  RunCheckpoint torn = checkpoint;
+  torn.zones[0].elapsed_ms = 3000;
+  tearCheckpointWrite(torn);
+  RunCheckpoint loaded;
+  pass = checkpointLoad(loaded) && loaded.sequence == checkpoint.sequence && loaded.zones[0].elapsed_ms == 2000;
+  printf("  %-13s expected=sequence %-6u got=sequence %-6u %s\n", "torn slot", checkpoint.sequence,
+         loaded.sequence, pass ? "ok" : "WRONG");
+  ok = pass && ok;
+  checkpointClear();
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int controllerBench(SimOptions opts, const ProfileInfo &reflow) {
+  // Step and hold: settling and overshoot without a moving setpoint.
+  Profile step{};
+  strlcpy(step.name, "sim-step", sizeof(step.name));
+  step.end_behavior = EndBehavior::STOP;
+  step.count = 2;
+  step.points[0] = ProfilePoint{0, 150.0f};
+  step.points[1] = ProfilePoint{900, 150.0f};
+  const char *error = nullptr;
+  ProfileInfo step_info;
+  if (!profileStoreAdd(step, error) || !profileStoreFind("sim-step", step_info)) {
+    fprintf(stderr, "step profile rejected: %s\n", error ? error : "not_found");
+    return 1;
+  }
+  ControlConfig configs[8];
+  const char *names[8];
+  uint8_t count = 0;
+  presetConfigs(opts, configs, names, count);
+  const ProfileInfo *profiles[] = {&reflow, &step_info};
+  for (const ProfileInfo *profile : profiles) {
+    printf("%s (%u points, plant gain=%.0fC tau=%.0fs dead=%.1fs)\n", profile->name, profile->count,
+           opts.plant.gain_c, opts.plant.time_constant_s, opts.plant.dead_time_s);
+    for (uint8_t i = 0; i < count; ++i) {
+      opts.config = configs[i];
+      RunResult result = runOnce(opts, *profile, nullptr);
+      double rms = result.samples ? sqrt(result.sq_error_sum / (result.samples * opts.zones)) : 0.0;
+      char settling[16];
+      formatSettling(result, settling, sizeof(settling));
+      printf("  %-17s rms=%6.2fC lag=%6.2fC peak_overshoot=%6.2fC settling=%-7s kp=%.4f ki=%.5f kd=%.3f ff=%.3f@%.1fs\n",
+             names[i], rms, result.max_lag_c, result.peak_temp_c - result.max_set_c, settling, configs[i].kp,
+             configs[i].controller == ControllerKind::PID ? configs[i].ki : 0.0f,
+             configs[i].controller == ControllerKind::PID ? configs[i].kd : 0.0f, configs[i].ff_gain,
+             configs[i].ff_lead_s);
+    }
+  }
+  return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  SimOptions opts;
+  if (!parseArgs(argc, argv, opts)) {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  if (opts.seqlock_ticks) {
+    return seqlockStressRun(opts.seqlock_ticks) ? 0 : 1;
+  }
+  if (opts.status_bench_renders) {
+    return statusBenchRun(opts.status_bench_renders, opts.plant.seed) ? 0 : 1;
+  }
+  if (opts.sensor_bench_samples) {
+    return sensorBenchRun(opts.sensor_bench_samples, opts.plant.seed) ? 0 : 1;
+  }
+  if (opts.filter_eval_path) {
+    return filterEvalRun(opts.filter_eval_path, opts.filter_set ? &opts.config.filter : nullptr) ? 0 : 1;
+  }
+  profileStoreLoad();
+  if (opts.store_bench_ops) {
+    return storeBenchRun(opts.store_bench_ops, opts.plant.seed) ? 0 : 1;
+  }
+  if (opts.setpoint_bench) {
+    return setpointBenchRun(opts.plant.seed) ? 0 : 1;
+  }
+  const char *name = "sim-file";
+  if (opts.profile_path) {
+    if (!storeProfileCsv(opts.profile_path, name)) {
+      fprintf(stderr, "cannot load profile %s\n", opts.profile_path);
+      return 1;
+    }
+  } else {
+    Profile builtin{};
+    loadDefaultProfile(builtin);
+    const char *error = nullptr;
+    if (!profileStoreAdd(builtin, error)) {
+      fprintf(stderr, "profile rejected: %s\n", error);
+      return 1;
+    }
+    name = "sim-default";
+  }
+  ProfileInfo profile;
+  profileStoreFind(name, profile);
+  if (opts.controller_bench) {
+    return controllerBench(opts, profile);
+  }
+  if (opts.autotune_run) {
+    return autotuneSim(opts, profile);
+  }
+  if (opts.resume_check) {
+    return resumeCheck() ? 0 : 1;
+  }
+  if (opts.brownout_s && opts.outage_s < 0) {
+    return brownoutSweep(opts, profile);
+  }
+  if (opts.batch) {
+    return batchLoop(opts, profile);
+  }
+
+  RunResult result;
+  auto wall_start = std::chrono::steady_clock::now();
+  for (uint32_t run = 0; run < opts.runs; ++run) {
+    FILE *csv = nullptr;
+    if (opts.csv_path && run + 1 == opts.runs) {
+      csv = fopen(opts.csv_path, "w");
+      if (csv) fprintf(csv, "t_s,zone,t_set,t_plant,t_meas,duty,t_filt\n");
+    }
+    result = runOnce(opts, profile, csv);
+    if (csv) fclose(csv);
+  }
+  double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  double sim_s = static_cast<double>(result.sim_ms) / 1000.0 * opts.runs;
+
+  double rms = result.samples ? sqrt(result.sq_error_sum / (result.samples * opts.zones)) : 0.0;
+  printf("profile=%s points=%u runs=%u zones=%u\n", profile.name, profile.count, opts.runs, opts.zones);
+  printf("final_state=%s sim_time=%.1fs ticks=%u\n", stateLabel(result.final_state),
+         result.sim_ms / 1000.0f, result.samples);
+  printf("rms_error=%.2fC max_error=%.2fC overshoot=%.2fC peak=%.2fC ssr_switches=%u\n", rms,
+         result.max_abs_error_c, result.max_overshoot_c, result.peak_temp_c, result.ssr_switches);
+  double energy_error = result.requested_on_ms > 0.0
+                            ? (result.delivered_on_ms - result.requested_on_ms) / result.requested_on_ms * 100.0
+                            : 0.0;
+  char settling[16];
+  formatSettling(result, settling, sizeof(settling));
+  printf("controller=%s max_lag=%.2fC settling=%s (within %.1fC after the last setpoint change)\n",
+         controllerName(opts.config.controller), result.max_lag_c, settling, kSettleBandC);
+  printf("energy requested=%.1fs delivered=%.1fs error=%+.2f%%\n", result.requested_on_ms / 1000.0,
+         result.delivered_on_ms / 1000.0, energy_error);
+  double tick_avg_us = result.samples ? result.tick_wall_us_sum / result.samples : 0.0;
+  printf("control_tick avg=%.1fus max=%.1fus (%.3f%% of %ums period, host)\n", tick_avg_us,
+         result.tick_wall_us_max, tick_avg_us / (CONTROL_PERIOD_MS * 10.0), CONTROL_PERIOD_MS);
+  printf("profile_page_misses=%u (pages of %u points read by the control step)\n", profilePageMisses(),
+         PROFILE_PAGE_POINTS);
+  printf("wall=%.3fs speedup=%.0fx\n", wall_s, wall_s > 0.0 ? sim_s / wall_s : 0.0);
+  return 0;
+}
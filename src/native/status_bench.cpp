@@ -0,0 +1,163 @@
+#include "status_bench.h"
+#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "app_config.h"
+#include "status_json.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// The size of a web_api.cpp status slot.
+constexpr size_t kSlotSize = 1280;
+constexpr uint8_t kZoneCounts[] = {1, MAX_ZONES};
+
+struct Snapshot {
+  uint32_t seq;
+  ControlStatus status;
+  ControlTiming timing;
+};
+
+uint32_t nextRandom(uint32_t &state) {
+  // xorshift32
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// Half are multiples of 1/64 (exact in binary, like the MAX31855's 0.25 C
+// steps), so rounding ties are rendered too.
+float randomTemp(uint32_t &rng) {
+  if (nextRandom(rng) & 1u) {
+    return static_cast<float>(nextRandom(rng) % 16000) / 64.0f - 10.0f;
+  }
+  return 20.0f + static_cast<float>(nextRandom(rng) % 250000) / 1000.0f;
+}
+
+void fillSnapshot(uint32_t seq, uint8_t zones, uint32_t &rng, Snapshot &out) {
+  out.seq = seq;
+  out.status = ControlStatus{};
+  out.status.state = static_cast<RunState>(nextRandom(rng) % 5);
+  out.status.run_switch_enabled = nextRandom(rng) & 1u;
+  out.status.last_fault = static_cast<uint8_t>(nextRandom(rng) % 4);
+  out.status.zone_count = zones;
+  for (uint8_t z = 0; z < zones; ++z) {
+    out.status.t_meas_c[z] = randomTemp(rng);
+    out.status.t_set_c[z] = randomTemp(rng);
+    out.status.duty[z] = static_cast<float>(nextRandom(rng) % 1025) / 1024.0f;
+    out.status.zone_fault[z] = static_cast<uint8_t>(nextRandom(rng) % 4);
+  }
+  out.timing = ControlTiming{};
+  out.timing.last_latency_us = nextRandom(rng) % 5000;
+  out.timing.max_latency_us = out.timing.last_latency_us + nextRandom(rng) % 5000;
+  out.timing.deadline_misses = nextRandom(rng) % 100;
+}
+
+// handleStatus() before the shared slots, extended to the current fields:
+// one String grown piece by piece for every request.
+String renderConcat(const Snapshot &snap, const char (*profiles)[kMaxProfileNameLength + 1]) {
+  const ControlStatus &s = snap.status;
+  String json = "{";
+  json += "\"ok\":true,";
+  json += "\"data\":{";
+  json += "\"seq\":";
+  json += String(static_cast<unsigned long>(snap.seq));
+  json += ",\"state\":\"";
+  json += runStateName(s.state);
+  json += "\",\"t_meas\":";
+  json += String(s.t_meas_c[0], 2);
+  json += ",\"t_set\":";
+  json += String(s.t_set_c[0], 2);
+  json += ",\"duty\":";
+  json += String(s.duty[0], 3);
+  json += ",\"delta\":";
+  json += String(s.t_set_c[0] - s.t_meas_c[0], 2);
+  json += ",\"run_switch\":";
+  json += s.run_switch_enabled ? "true" : "false";
+  json += ",\"active_profile\":\"";
+  json += profiles[0];
+  json += "\",\"fault\":";
+  json += String(static_cast<unsigned long>(s.last_fault));
+  json += ",\"latency_us\":";
+  json += String(static_cast<unsigned long>(snap.timing.last_latency_us));
+  json += ",\"latency_max_us\":";
+  json += String(static_cast<unsigned long>(snap.timing.max_latency_us));
+  json += ",\"deadline_misses\":";
+  json += String(static_cast<unsigned long>(snap.timing.deadline_misses));
+  if (s.zone_count > 1) {
+    json += ",\"zones\":[";
+    for (uint8_t z = 0; z < s.zone_count; ++z) {
+      if (z > 0) {
+        json += ",";
+      }
+      json += "{\"t_meas\":";
+      json += String(s.t_meas_c[z], 2);
+      json += ",\"t_set\":";
+      json += String(s.t_set_c[z], 2);
+      json += ",\"duty\":";
+      json += String(s.duty[z], 3);
+      json += ",\"fault\":";
+      json += String(static_cast<unsigned long>(s.zone_fault[z]));
+      json += ",\"profile\":\"";
+      json += profiles[z];
+      json += "\"}";
+    }
+    json += "]";
+  }
+  json += "}}";
+  return json;
+}
+
+double elapsedNs(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+bool benchOne(uint8_t zones, uint32_t renders, uint32_t &rng) {
+  char profiles[MAX_ZONES][kMaxProfileNameLength + 1];
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    snprintf(profiles[z], sizeof(profiles[z]), "reflow-zone-%u", z);
+  }
+  std::vector<Snapshot> snaps(renders);
+  for (uint32_t i = 0; i < renders; ++i) {
+    fillSnapshot(i + 1, zones, rng, snaps[i]);
+  }
+
+  static char slot[kSlotSize];
+  double slot_ns = 0.0;
+  double concat_ns = 0.0;
+  size_t max_len = 0;
+  uint32_t mismatches = 0;
+  for (const Snapshot &snap : snaps) {
+    Clock::time_point t0 = Clock::now();
+    size_t len = statusRenderJson(slot, sizeof(slot), snap.seq, snap.status, snap.timing, profiles);
+    slot_ns += elapsedNs(t0);
+    Clock::time_point t1 = Clock::now();
+    String json = renderConcat(snap, profiles);
+    concat_ns += elapsedNs(t1);
+    if (len == 0 || len != json.length() || memcmp(slot, json.c_str(), len) != 0) {
+      if (mismatches++ == 0) {
+        fprintf(stderr, "status bench: bodies differ\n  slot:   %.*s\n  concat: %s\n", static_cast<int>(len), slot,
+                json.c_str());
+      }
+    }
+    max_len = len > max_len ? len : max_len;
+  }
+  printf("%u zone%s %7u renders   slot %8.1f ns   concat %8.1f ns   x%-5.1f body <= %zu/%zu bytes %s\n", zones,
+         zones == 1 ? " " : "s", renders, slot_ns / renders, concat_ns / renders,
+         slot_ns > 0.0 ? concat_ns / slot_ns : 0.0, max_len, kSlotSize, mismatches == 0 ? "ok" : "MISMATCH");
+  return mismatches == 0;
+}
+} // namespace
+
+bool statusBenchRun(uint32_t renders, uint32_t seed) {
+  printf("status bench: statusRenderJson() into a %zu-byte slot against String concatenation\n", kSlotSize);
+  uint32_t rng = seed ? seed : 1;
+  bool ok = true;
+  for (uint8_t zones : kZoneCounts) {
+    ok = benchOne(zones, renders, rng) && ok;
+  }
+  return ok;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// /api/status render benchmark (sim --status-bench N): renders N random
+// snapshots, for one zone and for MAX_ZONES, with statusRenderJson() into a
+// fixed slot and with the per-request String concatenation it replaced.
+// Prints the time per render of both and returns false if the two bodies
+// ever differ.
+bool statusBenchRun(uint32_t renders, uint32_t seed);
@@ -0,0 +1,62 @@
+// Native stand-in for the profile store files of storage.cpp: RAM buffers,
+// so the simulator (and host tools) run the store code unchanged.
+
+#include <cstring>
+#include <vector>
+#include "sim_hal.h"
+#include "storage.h"
+
+namespace {
+std::vector<uint8_t> g_files[static_cast<uint8_t>(StoreFile::COUNT)];
+uint32_t g_bytes_written = 0;
+
+std::vector<uint8_t> &buffer(StoreFile file) {
+  return g_files[static_cast<uint8_t>(file)];
+}
+} // namespace
+
+uint32_t storageFileSize(StoreFile file) {
+  return buffer(file).size();
+}
+
+bool storageFileRead(StoreFile file, uint32_t offset, void *out, size_t len) {
+  const std::vector<uint8_t> &data = buffer(file);
+  if (offset > data.size() || len > data.size() - offset) {
+    return false;
+  }
+  memcpy(out, data.data() + offset, len);
+  return true;
+}
+
+bool storageFileAppend(StoreFile file, const void *data, size_t len) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  buffer(file).insert(buffer(file).end(), bytes, bytes + len);
+  g_bytes_written += len;
+  return true;
+}
+
+bool storageFileSync(StoreFile file) {
+  (void)file;
+  return true;
+}
+
+uint32_t storageFileBytesWritten() {
+  return g_bytes_written;
+}
+
+void simStorageTruncate(StoreFile file, uint32_t size) {
+  if (size < buffer(file).size()) {
+    buffer(file).resize(size);
+  }
+}
+
+bool storageFileReset(StoreFile file) {
+  buffer(file).clear();
+  return true;
+}
+
+bool storageFileCommitRewrite() {
+  buffer(StoreFile::PROFILES).swap(buffer(StoreFile::REWRITE));
+  buffer(StoreFile::REWRITE).clear();
+  return true;
+}
@@ -0,0 +1,196 @@
+#include "store_bench.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "crc32.h"
+#include "profile_store.h"
+#include "sim_hal.h"
+#include "storage.h"
+
+namespace {
+constexpr uint8_t kBenchProfiles = 32;
+constexpr uint16_t kMinPoints = 16;
+constexpr uint16_t kMaxPoints = 512;
+// One op in this many is a delete.
+constexpr uint32_t kDeleteEvery = 8;
+
+struct BenchResult {
+  uint32_t logical_bytes = 0;  // point data the ops asked to store
+  uint32_t written_bytes = 0;
+  uint32_t compactions = 0;
+  uint32_t file_bytes = 0;
+  double wall_s = 0.0;
+};
+
+uint32_t nextRandom(uint32_t &state) {
+  // xorshift32
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+void benchName(uint8_t index, char *out, size_t len) {
+  snprintf(out, len, "bench-%02u", index);
+}
+
+bool saveProfile(const char *name, uint16_t count, uint32_t &rng) {
+  uint32_t session = profileStoreWriteBegin();
+  const char *error = nullptr;
+  uint32_t t_sec = 0;
+  for (uint16_t i = 0; session && !error && i < count; ++i) {
+    ProfilePoint point;
+    t_sec += 1 + nextRandom(rng) % 5;
+    point.t_sec = t_sec;
+    point.temp_c = 25.0f + static_cast<float>(nextRandom(rng) % 2000) / 10.0f;
+    profileStoreWritePoint(session, point, error);
+  }
+  if (session && !error) {
+    profileStoreWriteCommit(session, name, EndBehavior::STOP, error);
+  }
+  if (!session || error) {
+    fprintf(stderr, "store bench: save %s failed: %s\n", name, error ? error : "upload_busy");
+    return false;
+  }
+  return true;
+}
+
+bool resetStore() {
+  return storageFileReset(StoreFile::PROFILES) && profileStoreLoad();
+}
+
+// rewrite_all stands in for the old store, which rewrote the file per change.
+bool runWorkload(uint32_t ops, uint32_t seed, bool rewrite_all, BenchResult &result) {
+  if (!resetStore()) {
+    return false;
+  }
+  ProfileStoreStats before;
+  profileStoreGetStats(before);
+  uint32_t rng = seed ? seed : 1;
+  auto wall_start = std::chrono::steady_clock::now();
+  for (uint32_t op = 0; op < ops; ++op) {
+    char name[16];
+    benchName(nextRandom(rng) % kBenchProfiles, name, sizeof(name));
+    if (nextRandom(rng) % kDeleteEvery == 0) {
+      profileStoreDelete(name);
+    } else {
+      uint16_t count = kMinPoints + nextRandom(rng) % (kMaxPoints - kMinPoints + 1);
+      if (!saveProfile(name, count, rng)) {
+        return false;
+      }
+      result.logical_bytes += count * sizeof(ProfilePoint);
+    }
+    if (!profileStoreCompact(rewrite_all)) {
+      return false;
+    }
+  }
+  result.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  ProfileStoreStats after;
+  profileStoreGetStats(after);
+  result.written_bytes = after.bytes_written - before.bytes_written;
+  result.compactions = after.compactions - before.compactions;
+  result.file_bytes = after.file_bytes;
+  return true;
+}
+
+void printResult(const char *mode, const BenchResult &result) {
+  printf("%-8s written=%u logical=%u amplification=%.2fx compactions=%u file=%u wall=%.3fs\n", mode,
+         result.written_bytes, result.logical_bytes,
+         result.logical_bytes ? static_cast<double>(result.written_bytes) / result.logical_bytes : 0.0,
+         result.compactions, result.file_bytes, result.wall_s);
+}
+
+// Name, point count and CRC of the points of every stored profile.
+struct Digest {
+  char name[32];
+  uint16_t count;
+  uint32_t crc;
+};
+
+uint16_t digestStore(Digest *out, uint16_t max) {
+  uint16_t n = 0;
+  for (uint8_t p = 0; p < kBenchProfiles && n < max; ++p) {
+    char name[16];
+    benchName(p, name, sizeof(name));
+    ProfileInfo info;
+    if (!profileStoreFind(name, info)) {
+      continue;
+    }
+    Digest &digest = out[n++];
+    strncpy(digest.name, name, sizeof(digest.name));
+    digest.count = info.count;
+    digest.crc = 0;
+    for (uint16_t i = 0; i < info.count; ++i) {
+      ProfilePoint point;
+      if (!profileStoreReadPoints(info, i, &point, 1)) {
+        digest.count = 0;
+        break;
+      }
+      digest.crc = crc32Update(digest.crc, &point, sizeof(point));
+    }
+  }
+  return n;
+}
+
+bool sameDigests(const Digest *a, uint16_t a_count, const Digest *b, uint16_t b_count) {
+  if (a_count != b_count) {
+    return false;
+  }
+  for (uint16_t i = 0; i < a_count; ++i) {
+    if (strcmp(a[i].name, b[i].name) != 0 || a[i].count != b[i].count || a[i].crc != b[i].crc) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The log left by the last workload replays to the same profiles, and a
+// record cut short (reset mid-append) is dropped without losing the rest.
+bool checkRecovery(uint32_t seed) {
+  static Digest expected[kBenchProfiles];
+  static Digest actual[kBenchProfiles];
+  uint16_t expected_count = digestStore(expected, kBenchProfiles);
+  bool replay_ok = profileStoreLoad();
+  uint16_t actual_count = digestStore(actual, kBenchProfiles);
+  replay_ok = replay_ok && sameDigests(expected, expected_count, actual, actual_count);
+  printf("replay:  %u profiles %s\n", expected_count, replay_ok ? "ok" : "MISMATCH");
+
+  uint32_t rng = seed ^ 0x5a5a5a5au;
+  char torn_name[16];
+  benchName(0, torn_name, sizeof(torn_name));
+  uint32_t size_before = storageFileSize(StoreFile::PROFILES);
+  bool torn_ok = saveProfile(torn_name, kMaxPoints, rng);
+  // Lose the end of the new record, as a reset before its trailer would.
+  simStorageTruncate(StoreFile::PROFILES, storageFileSize(StoreFile::PROFILES) - 3);
+  ProfileStoreStats before;
+  profileStoreGetStats(before);
+  torn_ok = torn_ok && profileStoreLoad();
+  ProfileStoreStats after;
+  profileStoreGetStats(after);
+  actual_count = digestStore(actual, kBenchProfiles);
+  torn_ok = torn_ok && sameDigests(expected, expected_count, actual, actual_count) &&
+            after.compactions == before.compactions + 1 && after.file_bytes <= size_before;
+  // The compacted log takes appends again.
+  torn_ok = torn_ok && saveProfile(torn_name, kMinPoints, rng) && profileStoreLoad();
+  ProfileInfo info;
+  torn_ok = torn_ok && profileStoreFind(torn_name, info) && info.count == kMinPoints;
+  printf("torn:    %s\n", torn_ok ? "ok" : "FAILED");
+  return replay_ok && torn_ok;
+}
+} // namespace
+
+bool storeBenchRun(uint32_t ops, uint32_t seed) {
+  printf("store bench: %u ops over %u profiles of %u..%u points, 1 in %u a delete\n", ops, kBenchProfiles,
+         kMinPoints, kMaxPoints, kDeleteEvery);
+  BenchResult rewrite;
+  if (!runWorkload(ops, seed, true, rewrite)) {
+    return false;
+  }
+  printResult("rewrite", rewrite);
+  BenchResult log;
+  if (!runWorkload(ops, seed, false, log)) {
+    return false;
+  }
+  printResult("log", log);
+  return checkRecovery(seed);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+// Profile store write benchmark (sim --store-bench N): N random saves and
+// deletes over a small set of profiles, once with the append-only log and
+// once rewriting the whole file after every change, then a replay and a
+// torn-record recovery check. Returns false if a check fails.
+bool storeBenchRun(uint32_t ops, uint32_t seed);
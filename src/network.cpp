@@ -0,0 +1,137 @@
+#include "network.h"
+#include "app_config.h"
+#include "log.h"
+#include "seqlock.h"
+#include <ESPmDNS.h>
+#include <WiFi.h>
+
+#if __has_include("secrets.h")
+#include "secrets.h"
+#endif
+
+namespace {
+// Written by the network task only.
+Seqlock<NetworkStatus> g_status_snapshot;
+NetworkStatus g_status;
+bool g_mdns_up = false;
+
+void enter(NetworkState state, uint32_t now_ms) {
+  g_status.state = state;
+  g_status.since_ms = now_ms;
+  g_status_snapshot.write(g_status);
+}
+
+// Restarted on every interface change so it answers on the current one.
+void startMdns() {
+  if (g_mdns_up) {
+    MDNS.end();
+  }
+  g_mdns_up = MDNS.begin(MDNS_HOST);
+  if (g_mdns_up) {
+    MDNS.addService("http", "tcp", 80);
+    logInfo(LogModule::WEB, "mDNS: http://%s.local/", MDNS_HOST);
+  } else {
+    logWarn(LogModule::WEB, "mDNS start failed");
+  }
+}
+
+void startAp(wifi_mode_t mode) {
+  WiFi.mode(mode);
+  g_status.ap_up = WiFi.softAP(AP_SSID, AP_PASSWORD);
+  if (g_status.ap_up) {
+    g_status.ip = static_cast<uint32_t>(WiFi.softAPIP());
+    logInfo(LogModule::WEB, "AP started: %s IP: %s", AP_SSID, WiFi.softAPIP().toString());
+    startMdns();
+  } else {
+    logError(LogModule::WEB, "AP start failed");
+  }
+}
+
+#if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
+void startJoin(uint32_t now_ms) {
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  enter(NetworkState::STA_CONNECTING, now_ms);
+}
+
+void onConnected(uint32_t now_ms) {
+  if (g_status.ap_up) {
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_STA);
+    g_status.ap_up = false;
+  }
+  g_status.ip = static_cast<uint32_t>(WiFi.localIP());
+  logInfo(LogModule::WEB, "WiFi connected: %s after %lu ms", WiFi.localIP().toString(),
+          static_cast<unsigned long>(now_ms - g_status.since_ms));
+  startMdns();
+  enter(NetworkState::STA_CONNECTED, now_ms);
+}
+#endif
+} // namespace
+
+const char *networkStateName(NetworkState state) {
+  switch (state) {
+    case NetworkState::OFF: return "off";
+    case NetworkState::STA_CONNECTING: return "sta_connecting";
+    case NetworkState::STA_CONNECTED: return "sta_connected";
+    case NetworkState::AP_FALLBACK: return "ap_fallback";
+    case NetworkState::AP_ONLY: return "ap_only";
+    default: return "unknown";
+  }
+}
+
+void networkBegin() {
+  uint32_t now_ms = millis();
+#if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
+  // Reconnection is driven from networkStep(), not by the driver.
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false);
+  startJoin(now_ms);
+#else
+  logInfo(LogModule::WEB, "WiFi credentials missing. Starting AP mode.");
+  startAp(WIFI_AP);
+  enter(NetworkState::AP_ONLY, now_ms);
+#endif
+}
+
+void networkStep(uint32_t now_ms) {
+#if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
+  bool linked = WiFi.status() == WL_CONNECTED;
+  switch (g_status.state) {
+    case NetworkState::STA_CONNECTING:
+      if (linked) {
+        onConnected(now_ms);
+      } else if (now_ms - g_status.since_ms >= NETWORK_CONNECT_TIMEOUT_MS) {
+        WiFi.disconnect();
+        if (!g_status.ap_up) {
+          logWarn(LogModule::WEB, "WiFi connect failed");
+          // AP and station together, so the join can be retried under it.
+          startAp(WIFI_AP_STA);
+        }
+        enter(NetworkState::AP_FALLBACK, now_ms);
+      }
+      break;
+    case NetworkState::STA_CONNECTED:
+      if (!linked) {
+        logWarn(LogModule::WEB, "WiFi link lost");
+        g_status.ip = 0;
+        g_status.reconnects++;
+        startJoin(now_ms);
+      }
+      break;
+    case NetworkState::AP_FALLBACK:
+      if (now_ms - g_status.since_ms >= NETWORK_RETRY_MS) {
+        g_status.reconnects++;
+        startJoin(now_ms);
+      }
+      break;
+    default:
+      break;
+  }
+#else
+  (void)now_ms;
+#endif
+}
+
+void networkGetStatus(NetworkStatus &out_status) {
+  g_status_snapshot.read(out_status);
+}
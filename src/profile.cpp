@@ -1,76 +1,159 @@
 #include "profile.h"
+#include "hal.h"
+#include "metrics.h"
+#include "profile_store.h"
 #include <ArduinoJson.h>
+#include <atomic>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
 namespace {
-constexpr uint8_t kMaxProfiles = 8;
-Profile g_profiles[kMaxProfiles];
-uint8_t g_profile_count = 0;
+constexpr uint16_t kNoPage = 0xFFFF;
 
-String g_active_name;
-uint32_t g_active_start_ms = 0;
+// Profile a zone is running; empty name = no profile. Page p (points
+// p * PROFILE_PAGE_POINTS ...) lives in pages[p % 2], so a segment that
+// straddles two pages has both in RAM.
+struct ActiveRun {
+  char name[kMaxProfileNameLength + 1] = "";
+  uint32_t run_id = 0;
+  uint32_t start_ms = 0;
+  uint16_t count = 0;
+  uint16_t cursor = 0;  // segment: points cursor, cursor + 1
+  uint32_t first_ms = 0;
+  float first_c = NAN;
+  float last_c = NAN;
+  EndBehavior end_behavior = EndBehavior::HOLD_LAST;
+  uint16_t page_no[2] = {kNoPage, kNoPage};
+  uint16_t want_page = kNoPage;  // for profilePrefetch()
+  ProfilePoint pages[2][PROFILE_PAGE_POINTS];
+};
 
-float g_temp_min_c = -100.0f;
-float g_temp_max_c = 500.0f;
+ActiveRun g_active[MAX_ZONES];
+uint32_t g_next_run_id = 1;
+// Bumped whenever an active name changes so readers can cache a copy.
+std::atomic<uint32_t> g_active_name_version{1};
+std::atomic<uint32_t> g_page_misses{0};
 
 SemaphoreHandle_t g_profile_mutex = nullptr;
 
-int findProfileIndex(const String &name) {
-  for (uint8_t i = 0; i < g_profile_count; ++i) {
-    if (g_profiles[i].name == name) {
-      return i;
-    }
-  }
-  return -1;
-}
-
-bool parseEndBehavior(const String &value, EndBehavior &out) {
-  if (value == "hold_last") {
+bool parseEndBehavior(const char *value, EndBehavior &out) {
+  if (strcmp(value, "hold_last") == 0) {
     out = EndBehavior::HOLD_LAST;
     return true;
   }
-  if (value == "stop") {
+  if (strcmp(value, "stop") == 0) {
     out = EndBehavior::STOP;
     return true;
   }
   return false;
 }
 
-String endBehaviorToString(EndBehavior value) {
-  return value == EndBehavior::STOP ? "stop" : "hold_last";
+uint16_t pagePoints(const ActiveRun &run, uint16_t page) {
+  uint32_t first = static_cast<uint32_t>(page) * PROFILE_PAGE_POINTS;
+  return static_cast<uint16_t>(min(static_cast<uint32_t>(PROFILE_PAGE_POINTS), run.count - first));
 }
 
-bool validateProfile(const Profile &profile, String &error) {
-  if (profile.name.isEmpty()) {
-    error = "name_required";
-    return false;
-  }
-  if (profile.count < 2) {
-    error = "points_min";
-    return false;
-  }
-  for (uint8_t i = 0; i < profile.count; ++i) {
-    if (profile.points[i].temp_c < g_temp_min_c || profile.points[i].temp_c > g_temp_max_c) {
-      error = "temp_out_of_range";
-      return false;
+void clearRun(uint8_t zone) {
+  ActiveRun &run = g_active[zone];
+  run.name[0] = '\0';
+  run.want_page = kNoPage;
+  profileStoreUnpin(zone);
+}
+
+// Point i of zone's run; reads its page from flash if the prefetch has not.
+const ProfilePoint *runPoint(uint8_t zone, uint16_t i) {
+  ActiveRun &run = g_active[zone];
+  uint16_t page = i / PROFILE_PAGE_POINTS;
+  uint8_t slot = page & 1;
+  if (run.page_no[slot] != page) {
+    if (!profileStoreReadPinned(zone, page * PROFILE_PAGE_POINTS, run.pages[slot], pagePoints(run, page))) {
+      return nullptr;
     }
-    if (i > 0 && profile.points[i].t_sec <= profile.points[i - 1].t_sec) {
-      error = "points_not_monotonic";
-      return false;
+    run.page_no[slot] = page;
+    g_page_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+  return &run.pages[slot][i % PROFILE_PAGE_POINTS];
+}
+
+// Point i if its page is in RAM; never reads flash.
+const ProfilePoint *residentPoint(const ActiveRun &run, uint16_t i) {
+  uint16_t page = i / PROFILE_PAGE_POINTS;
+  return run.page_no[page & 1] == page ? &run.pages[page & 1][i % PROFILE_PAGE_POINTS] : nullptr;
+}
+
+// Slope of the segment at ahead_ms into the run. Walks on from the cursor
+// through resident pages only: until profilePrefetch() brings in the next
+// page, the last resident segment stands in.
+float lookaheadSlope(const ActiveRun &run, uint32_t ahead_ms) {
+  uint16_t i = run.cursor;
+  const ProfilePoint *a = residentPoint(run, i);
+  const ProfilePoint *b = a ? residentPoint(run, i + 1) : nullptr;
+  while (b && i + 2 < run.count && ahead_ms > b->t_sec * 1000) {
+    const ProfilePoint *next = residentPoint(run, i + 2);
+    if (!next) {
+      break;
     }
+    ++i;
+    a = b;
+    b = next;
   }
-  return true;
+  if (!b || b->t_sec <= a->t_sec || (i + 2 >= run.count && ahead_ms > b->t_sec * 1000)) {
+    return 0.0f;  // past the end: the run holds or stops
+  }
+  return (b->temp_c - a->temp_c) / static_cast<float>(b->t_sec - a->t_sec);
 }
 
-float interpolate(const ProfilePoint &a, const ProfilePoint &b, uint32_t t_sec) {
-  if (b.t_sec == a.t_sec) {
-    return b.temp_c;
+ProfileSetpoint evaluateRun(uint8_t zone, uint32_t now_ms, uint32_t lookahead_ms) {
+  ActiveRun &run = g_active[zone];
+  ProfileSetpoint out;
+  if (run.name[0] == '\0') {
+    return out;
+  }
+
+  out.active = true;
+  out.end_behavior = run.end_behavior;
+
+  uint32_t elapsed_ms = now_ms - run.start_ms;
+  out.elapsed_ms = elapsed_ms;
+  if (elapsed_ms <= run.first_ms) {
+    out.setpoint_c = run.first_c;
+    return out;
+  }
+
+  // Time only moves forward during a run, so the cursor advances at most a
+  // segment or two per call; rewind only if the clock went backwards.
+  const ProfilePoint *a = runPoint(zone, run.cursor);
+  if (a && run.cursor > 0 && elapsed_ms <= a->t_sec * 1000) {
+    run.cursor = 0;
+    a = runPoint(zone, 0);
+  }
+  const ProfilePoint *b = a ? runPoint(zone, run.cursor + 1) : nullptr;
+  while (b && run.cursor + 2 < run.count && elapsed_ms > b->t_sec * 1000) {
+    run.cursor++;
+    a = b;
+    b = runPoint(zone, run.cursor + 1);
+  }
+  if (!b) {
+    return out;  // flash read failed: no setpoint (NAN) this tick
+  }
+  // Ask for the page after the cursor's before the cursor gets there.
+  uint16_t next_page = run.cursor / PROFILE_PAGE_POINTS + 1;
+  bool need = next_page * PROFILE_PAGE_POINTS < run.count && run.page_no[next_page & 1] != next_page;
+  run.want_page = need ? next_page : kNoPage;
+
+  uint32_t a_ms = a->t_sec * 1000;
+  uint32_t b_ms = b->t_sec * 1000;
+  if (elapsed_ms > b_ms) {
+    out.completed = true;
+    out.setpoint_c = run.last_c;
+    return out;
   }
-  float ratio = (static_cast<float>(t_sec) - static_cast<float>(a.t_sec)) /
-                (static_cast<float>(b.t_sec - a.t_sec));
-  return a.temp_c + (b.temp_c - a.temp_c) * ratio;
+  out.setpoint_c = a->temp_c + (b->temp_c - a->temp_c) * static_cast<float>(elapsed_ms - a_ms) /
+                                   static_cast<float>(b_ms - a_ms);
+  out.slope_c_s = lookaheadSlope(run, elapsed_ms + lookahead_ms);
+  return out;
 }
+
 } // namespace
 
 void profileInit() {
@@ -79,144 +162,133 @@ void profileInit() {
   }
 }
 
-void profileSetTempLimits(float min_c, float max_c) {
-  g_temp_min_c = min_c;
-  g_temp_max_c = max_c;
+bool profileDelete(const char *name) {
+  // Stop the zones first so the store does not keep the record pinned.
+  metricsTake(g_profile_mutex, Metric::LOCK_PROFILE);
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    if (strcmp(g_active[z].name, name) == 0) {
+      clearRun(z);
+      g_active_name_version.fetch_add(1);
+    }
+  }
+  xSemaphoreGive(g_profile_mutex);
+  return profileStoreDelete(name);
 }
 
-bool profileAddOrUpdate(const Profile &profile, String &error) {
-  if (!validateProfile(profile, error)) {
-    return false;
-  }
+const char *profileEndBehaviorName(EndBehavior value) {
+  return value == EndBehavior::STOP ? "stop" : "hold_last";
+}
 
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  int index = findProfileIndex(profile.name);
-  if (index < 0) {
-    if (g_profile_count >= kMaxProfiles) {
-      xSemaphoreGive(g_profile_mutex);
-      error = "profiles_full";
-      return false;
+void profileFromJson(JsonObjectConst in, Profile &out_profile) {
+  // A name that does not fit is left empty, so the store rejects the profile.
+  const char *name = in["name"] | "";
+  strlcpy(out_profile.name, strlen(name) <= kMaxProfileNameLength ? name : "", sizeof(out_profile.name));
+  out_profile.end_behavior = EndBehavior::HOLD_LAST;
+  parseEndBehavior(in["end_behavior"] | "hold_last", out_profile.end_behavior);
+  out_profile.count = 0;
+  for (JsonObjectConst point : in["points"].as<JsonArrayConst>()) {
+    if (out_profile.count >= kProfileInlinePoints) {
+      break;
     }
-    index = g_profile_count++;
+    out_profile.points[out_profile.count].t_sec = point["t_sec"] | 0;
+    out_profile.points[out_profile.count].temp_c = point["temp_c"] | 0.0f;
+    out_profile.count++;
   }
-  g_profiles[index] = profile;
-  xSemaphoreGive(g_profile_mutex);
-  return true;
 }
 
-bool profileDelete(const String &name) {
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  int index = findProfileIndex(name);
-  if (index < 0) {
-    xSemaphoreGive(g_profile_mutex);
+bool profileStartRun(uint8_t zone, const char *name, uint32_t elapsed_ms) {
+  if (zone >= MAX_ZONES) {
     return false;
   }
-  for (uint8_t i = index + 1; i < g_profile_count; ++i) {
-    g_profiles[i - 1] = g_profiles[i];
-  }
-  g_profile_count--;
-  if (g_active_name == name) {
-    g_active_name = "";
-  }
-  xSemaphoreGive(g_profile_mutex);
-  return true;
-}
-
-bool profileGet(const String &name, Profile &out_profile) {
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  int index = findProfileIndex(name);
-  if (index < 0) {
+  // Held across the flash reads so the zone's previous run never sees the
+  // new pin; a run start is rare and reads two pages at most.
+  metricsTake(g_profile_mutex, Metric::LOCK_PROFILE);
+  ActiveRun &run = g_active[zone];
+  ProfileInfo info;
+  ProfilePoint last;
+  if (!profileStorePin(zone, name, info)) {
     xSemaphoreGive(g_profile_mutex);
     return false;
   }
-  out_profile = g_profiles[index];
-  xSemaphoreGive(g_profile_mutex);
-  return true;
-}
-
-void profileList(String &json_out) {
-  JsonDocument doc;
-  JsonArray items = doc["profiles"].to<JsonArray>();
-
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  for (uint8_t i = 0; i < g_profile_count; ++i) {
-    JsonObject item = items.add<JsonObject>();
-    item["name"] = g_profiles[i].name;
-    item["points"] = g_profiles[i].count;
-    item["end_behavior"] = endBehaviorToString(g_profiles[i].end_behavior);
-  }
-  xSemaphoreGive(g_profile_mutex);
-
-  String payload;
-  serializeJson(doc, payload);
-  json_out = payload;
-}
-
-bool profileStartRun(const String &name) {
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  int index = findProfileIndex(name);
-  if (index < 0) {
+  if (!profileStoreReadPinned(zone, 0, run.pages[0], min<uint16_t>(PROFILE_PAGE_POINTS, info.count)) ||
+      !profileStoreReadPinned(zone, info.count - 1, &last, 1)) {
+    clearRun(zone);
+    g_active_name_version.fetch_add(1);
     xSemaphoreGive(g_profile_mutex);
     return false;
   }
-  g_active_name = name;
-  g_active_start_ms = millis();
+  strlcpy(run.name, info.name, sizeof(run.name));
+  run.run_id = g_next_run_id++;
+  run.start_ms = halMillis() - elapsed_ms;
+  run.count = info.count;
+  run.cursor = 0;
+  run.first_ms = run.pages[0][0].t_sec * 1000;
+  run.first_c = run.pages[0][0].temp_c;
+  run.last_c = last.temp_c;
+  run.end_behavior = info.end_behavior;
+  run.page_no[0] = 0;
+  run.page_no[1] = kNoPage;
+  run.want_page = info.count > PROFILE_PAGE_POINTS ? 1 : kNoPage;
+  g_active_name_version.fetch_add(1);
   xSemaphoreGive(g_profile_mutex);
   return true;
 }
 
 void profileClearActive() {
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  g_active_name = "";
+  metricsTake(g_profile_mutex, Metric::LOCK_PROFILE);
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    clearRun(z);
+  }
+  g_active_name_version.fetch_add(1);
   xSemaphoreGive(g_profile_mutex);
 }
 
-ProfileSetpoint profileGetSetpoint(uint32_t now_ms) {
-  ProfileSetpoint out;
-
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  if (g_active_name.isEmpty()) {
-    xSemaphoreGive(g_profile_mutex);
-    return out;
+void profileGetSetpoints(uint32_t now_ms, uint32_t lookahead_ms, ProfileSetpoint *out_setpoints,
+                         uint8_t zone_count) {
+  metricsTake(g_profile_mutex, Metric::LOCK_PROFILE);
+  for (uint8_t z = 0; z < zone_count && z < MAX_ZONES; ++z) {
+    out_setpoints[z] = evaluateRun(z, now_ms, lookahead_ms);
   }
+  xSemaphoreGive(g_profile_mutex);
+}
 
-  int index = findProfileIndex(g_active_name);
-  if (index < 0) {
-    g_active_name = "";
+void profilePrefetch() {
+  static ProfilePoint page_buf[PROFILE_PAGE_POINTS];
+  for (uint8_t z = 0; z < MAX_ZONES; ++z) {
+    metricsTake(g_profile_mutex, Metric::LOCK_PROFILE);
+    const ActiveRun &run = g_active[z];
+    uint16_t page = run.name[0] != '\0' ? run.want_page : kNoPage;
+    uint32_t run_id = run.run_id;
+    uint16_t points = page != kNoPage ? pagePoints(run, page) : 0;
     xSemaphoreGive(g_profile_mutex);
-    return out;
-  }
-
-  const Profile &profile = g_profiles[index];
-  out.active = true;
-  out.end_behavior = profile.end_behavior;
+    if (page == kNoPage || !profileStoreReadPinned(z, page * PROFILE_PAGE_POINTS, page_buf, points)) {
+      continue;
+    }
 
-  uint32_t elapsed_sec = (now_ms - g_active_start_ms) / 1000;
-  if (elapsed_sec <= profile.points[0].t_sec) {
-    out.setpoint_c = profile.points[0].temp_c;
+    metricsTake(g_profile_mutex, Metric::LOCK_PROFILE);
+    ActiveRun &current = g_active[z];
+    // The zone may have been restarted or stopped while the page was read.
+    if (current.run_id == run_id && current.want_page == page) {
+      memcpy(current.pages[page & 1], page_buf, points * sizeof(ProfilePoint));
+      current.page_no[page & 1] = page;
+      current.want_page = kNoPage;
+    }
     xSemaphoreGive(g_profile_mutex);
-    return out;
   }
+}
 
-  for (uint8_t i = 1; i < profile.count; ++i) {
-    const ProfilePoint &prev = profile.points[i - 1];
-    const ProfilePoint &next = profile.points[i];
-    if (elapsed_sec <= next.t_sec) {
-      out.setpoint_c = interpolate(prev, next, elapsed_sec);
-      xSemaphoreGive(g_profile_mutex);
-      return out;
-    }
-  }
+uint32_t profilePageMisses() {
+  return g_page_misses.load(std::memory_order_relaxed);
+}
 
-  out.completed = true;
-  out.setpoint_c = profile.points[profile.count - 1].temp_c;
+uint32_t profileCopyActiveName(uint8_t zone, char *out, size_t cap) {
+  metricsTake(g_profile_mutex, Metric::LOCK_PROFILE);
+  uint32_t version = g_active_name_version.load();
+  strlcpy(out, zone < MAX_ZONES ? g_active[zone].name : "", cap);
   xSemaphoreGive(g_profile_mutex);
-  return out;
+  return version;
 }
 
-String profileGetActiveName() {
-  xSemaphoreTake(g_profile_mutex, portMAX_DELAY);
-  String name = g_active_name;
-  xSemaphoreGive(g_profile_mutex);
-  return name;
+uint32_t profileActiveNameVersion() {
+  return g_active_name_version.load();
 }
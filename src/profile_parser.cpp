@@ -0,0 +1,357 @@
+#include "profile_parser.h"
+#include "profile_store.h"
+#include <cmath>
+
+namespace {
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+} // namespace
+
+void ProfileParser::begin() {
+  *this = ProfileParser{};
+  name_[0] = '\0';
+  session_ = profileStoreWriteBegin();
+  if (session_ == 0) {
+    error_ = "upload_busy";
+  }
+}
+
+bool ProfileParser::feed(const char *data, size_t len) {
+  for (size_t i = 0; i < len && !error_; ++i) {
+    if (!step(data[i])) {
+      break;
+    }
+    position_++;
+  }
+  return error_ == nullptr;
+}
+
+bool ProfileParser::finish() {
+  if (error_) {
+    return false;
+  }
+  if (state_ != State::DONE) {
+    return fail("incomplete");
+  }
+  if (!have_points_) {
+    return fail("points_required");
+  }
+  const char *code = nullptr;
+  if (!profileStoreWriteCommit(session_, name_, end_behavior_, code)) {
+    return fail(code);
+  }
+  return true;
+}
+
+bool ProfileParser::fail(const char *code) {
+  if (!error_) {
+    error_ = code;
+    profileStoreWriteAbort(session_);
+  }
+  return false;
+}
+
+ProfileParser::Field ProfileParser::currentField() const {
+  if (depth_ == 1) {
+    Field key = keys_[0];
+    return key == Field::NAME || key == Field::END_BEHAVIOR || key == Field::POINTS ? key : Field::OTHER;
+  }
+  if (depth_ == 2 && points_open_) {
+    return Field::POINT;
+  }
+  if (depth_ == 3 && points_open_ && stack_[2] == 'o') {
+    Field key = keys_[2];
+    return key == Field::T_SEC || key == Field::TEMP_C ? key : Field::OTHER;
+  }
+  return Field::OTHER;
+}
+
+bool ProfileParser::step(char c) {
+  switch (state_) {
+    case State::STRING:
+      if (c == '"') {
+        return finishString();
+      }
+      if (c == '\\') {
+        state_ = State::STRING_ESCAPE;
+        return true;
+      }
+      if (static_cast<uint8_t>(c) < 0x20) {
+        return fail("syntax");
+      }
+      return appendToken(c);
+    case State::STRING_ESCAPE: {
+      const char *from = "\"\\/bfnrt";
+      const char *to = "\"\\/\b\f\n\r\t";
+      const char *hit = c ? strchr(from, c) : nullptr;
+      if (c == 'u') {
+        state_ = State::STRING_UNICODE;
+        unicode_digits_ = 0;
+        unicode_ = 0;
+        return true;
+      }
+      if (!hit) {
+        return fail("syntax");
+      }
+      state_ = State::STRING;
+      return appendToken(to[hit - from]);
+    }
+    case State::STRING_UNICODE: {
+      int digit = hexValue(c);
+      if (digit < 0) {
+        return fail("syntax");
+      }
+      unicode_ = static_cast<uint16_t>((unicode_ << 4) | digit);
+      if (++unicode_digits_ < 4) {
+        return true;
+      }
+      state_ = State::STRING;
+      // UTF-8; surrogate halves are not paired up and become '?'.
+      if (unicode_ < 0x80) {
+        return appendToken(static_cast<char>(unicode_));
+      }
+      if (unicode_ >= 0xD800 && unicode_ < 0xE000) {
+        return appendToken('?');
+      }
+      if (unicode_ < 0x800) {
+        return appendToken(static_cast<char>(0xC0 | (unicode_ >> 6))) &&
+               appendToken(static_cast<char>(0x80 | (unicode_ & 0x3F)));
+      }
+      return appendToken(static_cast<char>(0xE0 | (unicode_ >> 12))) &&
+             appendToken(static_cast<char>(0x80 | ((unicode_ >> 6) & 0x3F))) &&
+             appendToken(static_cast<char>(0x80 | (unicode_ & 0x3F)));
+    }
+    case State::NUMBER:
+      if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+        if (token_len_ + 1 >= kTokenBytes) {
+          return fail("syntax");
+        }
+        return appendToken(c);
+      }
+      return finishNumber() && step(c);
+    case State::LITERAL:
+      if (c >= 'a' && c <= 'z') {
+        return appendToken(c);
+      }
+      token_[token_len_] = '\0';
+      if (token_overflow_ ||
+          (strcmp(token_, "true") != 0 && strcmp(token_, "false") != 0 && strcmp(token_, "null") != 0)) {
+        return fail("syntax");
+      }
+      return endValue() && step(c);
+    default:
+      break;
+  }
+
+  if (isSpace(c)) {
+    return true;
+  }
+  switch (state_) {
+    case State::VALUE:
+      return beginValue(c);
+    case State::VALUE_OR_END:
+      return c == ']' ? closeContainer('a') : beginValue(c);
+    case State::KEY_OR_END:
+      if (c == '}') {
+        return closeContainer('o');
+      }
+      [[fallthrough]];
+    case State::KEY:
+      if (c != '"') {
+        return fail("syntax");
+      }
+      string_is_key_ = true;
+      token_len_ = 0;
+      token_overflow_ = false;
+      state_ = State::STRING;
+      return true;
+    case State::COLON:
+      if (c != ':') {
+        return fail("syntax");
+      }
+      state_ = State::VALUE;
+      return true;
+    case State::COMMA_OR_END:
+      if (c == ',') {
+        state_ = stack_[depth_ - 1] == 'o' ? State::KEY : State::VALUE;
+        return true;
+      }
+      if (c == '}' || c == ']') {
+        return closeContainer(c == '}' ? 'o' : 'a');
+      }
+      return fail("syntax");
+    case State::DONE:
+      return fail("trailing_data");
+    default:
+      return fail("syntax");
+  }
+}
+
+bool ProfileParser::beginValue(char c) {
+  Field field = currentField();
+  bool is_string = c == '"';
+  bool is_number = c == '-' || (c >= '0' && c <= '9');
+  if (depth_ == 0 && c != '{') {
+    return fail("not_object");
+  }
+  switch (field) {
+    case Field::NAME:
+      if (!is_string) return fail("bad_name");
+      break;
+    case Field::END_BEHAVIOR:
+      if (!is_string) return fail("bad_end_behavior");
+      break;
+    case Field::POINTS:
+      if (c != '[') return fail("bad_points");
+      break;
+    case Field::POINT:
+      if (c != '{') return fail("bad_point");
+      point_ = ProfilePoint{};
+      point_fields_ = 0;
+      break;
+    case Field::T_SEC:
+    case Field::TEMP_C:
+      if (!is_number) return fail("bad_point");
+      break;
+    default:
+      break;
+  }
+
+  token_len_ = 0;
+  token_overflow_ = false;
+  if (c == '{' || c == '[') {
+    if (!openContainer(c == '{' ? 'o' : 'a')) {
+      return false;
+    }
+    if (field == Field::POINTS) {
+      if (have_points_) {
+        return fail("bad_points");  // the session already holds the first array's points
+      }
+      points_open_ = true;
+      have_points_ = true;
+    }
+    return true;
+  }
+  if (is_string) {
+    string_is_key_ = false;
+    state_ = State::STRING;
+    return true;
+  }
+  if (is_number) {
+    state_ = State::NUMBER;
+    return appendToken(c);
+  }
+  if (c == 't' || c == 'f' || c == 'n') {
+    state_ = State::LITERAL;
+    return appendToken(c);
+  }
+  return fail("syntax");
+}
+
+bool ProfileParser::endValue() {
+  state_ = depth_ == 0 ? State::DONE : State::COMMA_OR_END;
+  return true;
+}
+
+bool ProfileParser::openContainer(char kind) {
+  if (depth_ >= kMaxDepth) {
+    return fail("too_deep");
+  }
+  stack_[depth_] = kind;
+  keys_[depth_] = Field::OTHER;
+  depth_++;
+  state_ = kind == 'o' ? State::KEY_OR_END : State::VALUE_OR_END;
+  return true;
+}
+
+bool ProfileParser::closeContainer(char kind) {
+  if (depth_ == 0 || stack_[depth_ - 1] != kind) {
+    return fail("syntax");
+  }
+  if (depth_ == 3 && points_open_ && kind == 'o') {
+    if (point_fields_ != 3) {
+      return fail("bad_point");
+    }
+    const char *code = nullptr;
+    if (!profileStoreWritePoint(session_, point_, code)) {
+      return fail(code);
+    }
+  } else if (depth_ == 2 && points_open_ && kind == 'a') {
+    points_open_ = false;
+  }
+  depth_--;
+  return endValue();
+}
+
+bool ProfileParser::appendToken(char c) {
+  if (token_len_ + 1 >= kTokenBytes) {
+    token_overflow_ = true;
+    return true;
+  }
+  token_[token_len_++] = c;
+  return true;
+}
+
+bool ProfileParser::finishString() {
+  token_[token_len_] = '\0';
+  if (string_is_key_) {
+    Field key = Field::OTHER;
+    if (!token_overflow_) {
+      if (strcmp(token_, "name") == 0) key = Field::NAME;
+      else if (strcmp(token_, "end_behavior") == 0) key = Field::END_BEHAVIOR;
+      else if (strcmp(token_, "points") == 0) key = Field::POINTS;
+      else if (strcmp(token_, "t_sec") == 0) key = Field::T_SEC;
+      else if (strcmp(token_, "temp_c") == 0) key = Field::TEMP_C;
+    }
+    keys_[depth_ - 1] = key;
+    state_ = State::COLON;
+    return true;
+  }
+
+  Field field = currentField();
+  if (field == Field::NAME) {
+    if (token_overflow_) {
+      return fail("name_too_long");
+    }
+    memcpy(name_, token_, token_len_ + 1);
+  } else if (field == Field::END_BEHAVIOR) {
+    if (strcmp(token_, "hold_last") == 0) {
+      end_behavior_ = EndBehavior::HOLD_LAST;
+    } else if (strcmp(token_, "stop") == 0) {
+      end_behavior_ = EndBehavior::STOP;
+    } else {
+      return fail("bad_end_behavior");
+    }
+  }
+  return endValue();
+}
+
+bool ProfileParser::finishNumber() {
+  token_[token_len_] = '\0';
+  char *end = nullptr;
+  double value = strtod(token_, &end);
+  if (end == token_ || *end != '\0' || !std::isfinite(value)) {
+    return fail("syntax");
+  }
+  Field field = currentField();
+  if (field == Field::T_SEC) {
+    // Setpoint times are kept in uint32 milliseconds.
+    if (value < 0.0 || value > UINT32_MAX / 1000 || value != floor(value)) {
+      return fail("bad_point");
+    }
+    point_.t_sec = static_cast<uint32_t>(value);
+    point_fields_ |= 1;
+  } else if (field == Field::TEMP_C) {
+    point_.temp_c = static_cast<float>(value);
+    point_fields_ |= 2;
+  }
+  return endValue();
+}
@@ -0,0 +1,718 @@
+#include "profile_store.h"
+#include "crc32.h"
+#include "hal.h"
+#include "log.h"
+#include "metrics.h"
+#include "storage.h"
+#include <algorithm>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+namespace {
+constexpr uint32_t kFileMagic = 0x5350564F;    // "OVPS"
+constexpr uint32_t kRecordMagic = 0x52505650;  // "PVPR"
+constexpr uint32_t kCommitMagic = 0x54494D43;  // "CMIT"
+constexpr uint16_t kFileVersion = 2;
+
+struct StoreFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+};
+
+enum class RecordKind : uint8_t {
+  PUT,     // the profile's new contents
+  DELETE   // tombstone, no points
+};
+
+struct StoreRecordHeader {
+  uint32_t magic;
+  uint16_t count;  // 0 for DELETE
+  RecordKind kind;
+  uint8_t end_behavior;
+  uint8_t name_len;
+  char name[kMaxProfileNameLength];  // not NUL-terminated
+};
+static_assert(sizeof(StoreRecordHeader) == 40, "record header layout");
+
+// Written last: a record counts only once its trailer is on flash and the
+// CRC (header and points) matches, so a torn append is never replayed.
+struct StoreRecordTrailer {
+  uint32_t crc;
+  uint32_t magic;
+};
+
+struct IndexEntry {
+  uint32_t hash;
+  uint32_t offset;
+  uint16_t count;
+  uint8_t end_behavior;
+};
+static_assert(sizeof(IndexEntry) == 12, "index entry layout");
+
+IndexEntry g_index[PROFILE_STORE_MAX_PROFILES];
+uint16_t g_index_count = 0;
+// Bumped by every replay and compaction; ProfileInfo offsets from an older
+// one are stale.
+uint32_t g_generation = 1;
+
+struct Pin {
+  bool used;
+  uint32_t offset;
+  uint16_t count;
+};
+Pin g_pins[MAX_ZONES];
+
+struct WriteSession {
+  uint32_t id;  // 0 = none
+  uint32_t last_ms;
+  uint16_t count;
+  ProfilePoint last;
+  uint8_t buffered;
+  ProfilePoint buffer[PROFILE_PAGE_POINTS];
+};
+WriteSession g_write;
+uint32_t g_next_session = 1;
+
+// Set when an append failed part way: the log has garbage at its end, so
+// further appends are refused until a compaction drops it.
+bool g_tail_dirty = false;
+uint32_t g_compactions = 0;
+
+// Compaction scratch (compaction only): old and new offsets of the records
+// being copied, and its copy buffer, used outside the lock.
+constexpr uint16_t kMaxRecords = PROFILE_STORE_MAX_PROFILES + MAX_ZONES;
+uint32_t g_copy_from[kMaxRecords];
+uint32_t g_copy_to[kMaxRecords];
+uint16_t g_copy_counts[kMaxRecords];
+// Pinned record no longer in the index: a tombstone follows its copy.
+bool g_copy_dead[kMaxRecords];
+bool g_compacting = false;
+uint8_t g_compact_buf[256];
+// Replay and commit copies, under the lock.
+uint8_t g_copy_buf[256];
+
+float g_temp_min_c = -100.0f;
+float g_temp_max_c = 500.0f;
+
+SemaphoreHandle_t g_store_mutex = nullptr;
+
+void lockStore() {
+  if (!g_store_mutex) {
+    g_store_mutex = xSemaphoreCreateMutex();  // first use is during setup()
+  }
+  metricsTake(g_store_mutex, Metric::LOCK_STORE);
+}
+
+void unlockStore() {
+  xSemaphoreGive(g_store_mutex);
+}
+
+// FNV-1a.
+uint32_t nameHash(const char *name) {
+  uint32_t hash = 2166136261u;
+  for (; *name; ++name) {
+    hash = (hash ^ static_cast<uint8_t>(*name)) * 16777619u;
+  }
+  return hash;
+}
+
+uint32_t recordBytes(uint16_t count) {
+  return sizeof(StoreRecordHeader) + static_cast<uint32_t>(count) * sizeof(ProfilePoint) +
+         sizeof(StoreRecordTrailer);
+}
+
+uint32_t pointOffset(uint32_t record, uint16_t first) {
+  return record + sizeof(StoreRecordHeader) + static_cast<uint32_t>(first) * sizeof(ProfilePoint);
+}
+
+bool readHeader(uint32_t offset, StoreRecordHeader &out) {
+  if (!storageFileRead(StoreFile::PROFILES, offset, &out, sizeof(out)) || out.magic != kRecordMagic ||
+      out.name_len == 0 || out.name_len > kMaxProfileNameLength) {
+    return false;
+  }
+  if (out.kind == RecordKind::DELETE) {
+    return out.count == 0;
+  }
+  return out.kind == RecordKind::PUT && out.count >= 2 && out.count <= kMaxProfilePoints &&
+         out.end_behavior <= static_cast<uint8_t>(EndBehavior::STOP);
+}
+
+bool headerNameIs(const StoreRecordHeader &header, const char *name) {
+  return strlen(name) == header.name_len && memcmp(header.name, name, header.name_len) == 0;
+}
+
+// First index position with hash >= the given one.
+uint16_t lowerBound(uint32_t hash) {
+  uint16_t lo = 0;
+  uint16_t hi = g_index_count;
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if (g_index[mid].hash < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Index position of name, or -1. Equal hashes are told apart by the name
+// in the record header.
+int findEntry(const char *name, uint32_t hash) {
+  for (uint16_t i = lowerBound(hash); i < g_index_count && g_index[i].hash == hash; ++i) {
+    StoreRecordHeader header;
+    if (readHeader(g_index[i].offset, header) && headerNameIs(header, name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Adds or replaces name's entry; false when the index is full.
+bool putEntry(const char *name, uint32_t offset, uint16_t count, EndBehavior end_behavior) {
+  uint32_t hash = nameHash(name);
+  int index = findEntry(name, hash);
+  if (index < 0) {
+    if (g_index_count >= PROFILE_STORE_MAX_PROFILES) {
+      return false;
+    }
+    index = lowerBound(hash);
+    memmove(&g_index[index + 1], &g_index[index], (g_index_count - index) * sizeof(IndexEntry));
+    g_index_count++;
+  }
+  g_index[index] = IndexEntry{hash, offset, count, static_cast<uint8_t>(end_behavior)};
+  return true;
+}
+
+void removeEntry(uint16_t index) {
+  memmove(&g_index[index], &g_index[index + 1], (g_index_count - index - 1) * sizeof(IndexEntry));
+  g_index_count--;
+}
+
+bool fillInfo(uint16_t index, ProfileInfo &out) {
+  const IndexEntry &entry = g_index[index];
+  StoreRecordHeader header;
+  if (!readHeader(entry.offset, header)) {
+    return false;
+  }
+  memcpy(out.name, header.name, header.name_len);
+  out.name[header.name_len] = '\0';
+  out.end_behavior = static_cast<EndBehavior>(entry.end_behavior);
+  out.count = entry.count;
+  out.offset = entry.offset;
+  out.generation = g_generation;
+  return true;
+}
+
+bool writeFileHeader(StoreFile file) {
+  StoreFileHeader header{kFileMagic, kFileVersion, 0};
+  return storageFileReset(file) && storageFileAppend(file, &header, sizeof(header)) && storageFileSync(file);
+}
+
+uint32_t liveBytes() {
+  uint32_t live = sizeof(StoreFileHeader);
+  for (uint16_t i = 0; i < g_index_count; ++i) {
+    live += recordBytes(g_index[i].count);
+  }
+  return live;
+}
+
+bool indexedOffset(uint32_t offset) {
+  for (uint16_t i = 0; i < g_index_count; ++i) {
+    if (g_index[i].offset == offset) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool needsCompaction() {
+  uint32_t size = storageFileSize(StoreFile::PROFILES);
+  // Compaction keeps pinned records, so they do not count as reclaimable.
+  uint32_t kept = liveBytes();
+  for (const Pin &pin : g_pins) {
+    if (pin.used && !indexedOffset(pin.offset)) {
+      kept += recordBytes(pin.count);
+    }
+  }
+  uint32_t dead = size - min(size, kept);
+  return g_tail_dirty ||
+         (dead >= PROFILE_COMPACT_MIN_BYTES && dead * 100 >= static_cast<uint64_t>(size) * PROFILE_COMPACT_DEAD_PCT);
+}
+
+// Checks the record at offset end to end; out_bytes is its length.
+bool verifyRecord(uint32_t offset, uint32_t size, StoreRecordHeader &header, uint32_t &out_bytes) {
+  if (!readHeader(offset, header)) {
+    return false;
+  }
+  out_bytes = recordBytes(header.count);
+  if (out_bytes > size - offset) {
+    return false;
+  }
+  uint32_t crc = crc32Update(0, &header, sizeof(header));
+  uint32_t pos = pointOffset(offset, 0);
+  uint32_t left = static_cast<uint32_t>(header.count) * sizeof(ProfilePoint);
+  while (left > 0) {
+    uint32_t chunk = min(left, static_cast<uint32_t>(sizeof(g_copy_buf)));
+    if (!storageFileRead(StoreFile::PROFILES, pos, g_copy_buf, chunk)) {
+      return false;
+    }
+    crc = crc32Update(crc, g_copy_buf, chunk);
+    pos += chunk;
+    left -= chunk;
+  }
+  StoreRecordTrailer trailer;
+  return storageFileRead(StoreFile::PROFILES, pos, &trailer, sizeof(trailer)) && trailer.magic == kCommitMagic &&
+         trailer.crc == crc;
+}
+
+// Appends one record (points from the staging file for PUT) and syncs it.
+bool appendRecord(const StoreRecordHeader &header, uint32_t &out_offset) {
+  if (g_tail_dirty) {
+    return false;
+  }
+  out_offset = storageFileSize(StoreFile::PROFILES);
+  uint32_t crc = crc32Update(0, &header, sizeof(header));
+  bool ok = storageFileAppend(StoreFile::PROFILES, &header, sizeof(header));
+  uint32_t pos = 0;
+  uint32_t left = static_cast<uint32_t>(header.count) * sizeof(ProfilePoint);
+  while (ok && left > 0) {
+    uint32_t chunk = min(left, static_cast<uint32_t>(sizeof(g_copy_buf)));
+    ok = storageFileRead(StoreFile::STAGING, pos, g_copy_buf, chunk) &&
+         storageFileAppend(StoreFile::PROFILES, g_copy_buf, chunk);
+    crc = crc32Update(crc, g_copy_buf, chunk);
+    pos += chunk;
+    left -= chunk;
+  }
+  StoreRecordTrailer trailer{crc, kCommitMagic};
+  ok = ok && storageFileAppend(StoreFile::PROFILES, &trailer, sizeof(trailer)) && storageFileSync(StoreFile::PROFILES);
+  if (!ok) {
+    g_tail_dirty = true;
+    logError(LogModule::PROFILE, "profile store append failed at %u", out_offset);
+  }
+  return ok;
+}
+
+StoreRecordHeader makeHeader(RecordKind kind, const char *name, uint16_t count, EndBehavior end_behavior) {
+  StoreRecordHeader header{};
+  header.magic = kRecordMagic;
+  header.count = count;
+  header.kind = kind;
+  header.end_behavior = static_cast<uint8_t>(end_behavior);
+  header.name_len = static_cast<uint8_t>(strlen(name));
+  memcpy(header.name, name, header.name_len);
+  return header;
+}
+
+// Appends a DELETE record for the record header's name to REWRITE.
+bool appendTombstone(const StoreRecordHeader &record) {
+  StoreRecordHeader header = record;
+  header.kind = RecordKind::DELETE;
+  header.count = 0;
+  StoreRecordTrailer trailer{crc32Update(0, &header, sizeof(header)), kCommitMagic};
+  return storageFileAppend(StoreFile::REWRITE, &header, sizeof(header)) &&
+         storageFileAppend(StoreFile::REWRITE, &trailer, sizeof(trailer));
+}
+
+// Position of offset among the copied records' old offsets, or -1.
+int copiedIndex(uint16_t copied, uint32_t offset) {
+  uint32_t *hit = std::lower_bound(g_copy_from, g_copy_from + copied, offset);
+  return hit != g_copy_from + copied && *hit == offset ? hit - g_copy_from : -1;
+}
+
+// Offset after compaction of a record at offset before it; the tail
+// appended while copying moved by tail_shift.
+bool remapOffset(uint16_t copied, uint32_t snapshot_end, int32_t tail_shift, uint32_t &offset) {
+  if (offset >= snapshot_end) {
+    offset += tail_shift;
+    return true;
+  }
+  int i = copiedIndex(copied, offset);
+  if (i < 0) {
+    return false;
+  }
+  offset = g_copy_to[i];
+  return true;
+}
+
+// Copies file bytes [offset, offset + len) to the end of REWRITE, taking the
+// lock per chunk when unlocked is set.
+bool copyToRewrite(uint32_t offset, uint32_t len, bool unlocked) {
+  while (len > 0) {
+    uint32_t chunk = min(len, static_cast<uint32_t>(sizeof(g_compact_buf)));
+    if (unlocked) lockStore();
+    bool ok = storageFileRead(StoreFile::PROFILES, offset, g_compact_buf, chunk);
+    if (unlocked) unlockStore();
+    if (!ok || !storageFileAppend(StoreFile::REWRITE, g_compact_buf, chunk)) {
+      return false;
+    }
+    offset += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+bool flushSession() {
+  if (g_write.buffered == 0) {
+    return true;
+  }
+  bool ok = storageFileAppend(StoreFile::STAGING, g_write.buffer, g_write.buffered * sizeof(ProfilePoint));
+  g_write.buffered = 0;
+  return ok;
+}
+
+void endSession() {
+  g_write.id = 0;
+  g_write.buffered = 0;
+}
+
+bool sessionValid(uint32_t session) {
+  return session != 0 && session == g_write.id;
+}
+} // namespace
+
+bool profileStoreLoad() {
+  lockStore();
+  g_index_count = 0;
+  g_tail_dirty = false;
+  g_generation++;
+  uint32_t size = storageFileSize(StoreFile::PROFILES);
+  StoreFileHeader file_header{};
+  if (size == 0 || !storageFileRead(StoreFile::PROFILES, 0, &file_header, sizeof(file_header)) ||
+      file_header.magic != kFileMagic || file_header.version != kFileVersion) {
+    if (size != 0) {
+      logError(LogModule::PROFILE, "profile store unreadable, starting empty");
+    }
+    bool ok = writeFileHeader(StoreFile::PROFILES);
+    unlockStore();
+    return ok;
+  }
+
+  // Replay: each committed record applies in order; the first one that does
+  // not verify ends the log.
+  uint32_t offset = sizeof(StoreFileHeader);
+  uint32_t records = 0;
+  while (offset < size) {
+    StoreRecordHeader header;
+    uint32_t bytes = 0;
+    if (!verifyRecord(offset, size, header, bytes)) {
+      logWarn(LogModule::PROFILE, "profile store: torn record at %u, %u bytes dropped", offset, size - offset);
+      g_tail_dirty = true;
+      break;
+    }
+    char name[kMaxProfileNameLength + 1];
+    memcpy(name, header.name, header.name_len);
+    name[header.name_len] = '\0';
+    if (header.kind == RecordKind::DELETE) {
+      int index = findEntry(name, nameHash(name));
+      if (index >= 0) {
+        removeEntry(index);
+      }
+    } else if (!putEntry(name, offset, header.count, static_cast<EndBehavior>(header.end_behavior))) {
+      logWarn(LogModule::PROFILE, "profile store: index full, %s skipped", name);
+    }
+    offset += bytes;
+    records++;
+  }
+  logInfo(LogModule::PROFILE, "profile store: %u profiles from %u records, %u/%u bytes live", g_index_count,
+          records, liveBytes(), size);
+  unlockStore();
+  // Later appends must not land behind garbage.
+  return !g_tail_dirty || profileStoreCompact(true);
+}
+
+bool profileStoreCompact(bool force) {
+  lockStore();
+  if (g_compacting || (!force && !needsCompaction())) {
+    unlockStore();
+    return !g_compacting;
+  }
+  g_compacting = true;
+  bool was_dirty = g_tail_dirty;
+  uint32_t snapshot_end = storageFileSize(StoreFile::PROFILES);
+  uint16_t copied = 0;
+  for (uint16_t i = 0; i < g_index_count; ++i) {
+    g_copy_from[copied++] = g_index[i].offset;
+  }
+  for (const Pin &pin : g_pins) {
+    if (pin.used) {
+      g_copy_from[copied++] = pin.offset;
+    }
+  }
+  // File order keeps a replaced-but-pinned record ahead of its replacement,
+  // so the replacement still wins on replay; the tombstone written after a
+  // pinned-only record keeps a deleted profile deleted.
+  std::sort(g_copy_from, g_copy_from + copied);
+  copied = std::unique(g_copy_from, g_copy_from + copied) - g_copy_from;
+  bool ok = true;
+  for (uint16_t i = 0; i < copied && ok; ++i) {
+    StoreRecordHeader header;
+    ok = readHeader(g_copy_from[i], header);
+    g_copy_counts[i] = header.count;
+    g_copy_dead[i] = !indexedOffset(g_copy_from[i]);
+  }
+  unlockStore();
+
+  // The records before snapshot_end never change, so they are copied with
+  // the lock taken per chunk; readers and appends carry on meanwhile.
+  ok = ok && writeFileHeader(StoreFile::REWRITE);
+  uint32_t offset = sizeof(StoreFileHeader);
+  for (uint16_t i = 0; i < copied && ok; ++i) {
+    uint32_t bytes = recordBytes(g_copy_counts[i]);
+    ok = copyToRewrite(g_copy_from[i], bytes, true);
+    g_copy_to[i] = offset;
+    offset += bytes;
+    if (ok && g_copy_dead[i]) {
+      StoreRecordHeader header;
+      lockStore();
+      ok = readHeader(g_copy_from[i], header);
+      unlockStore();
+      ok = ok && appendTombstone(header);
+      offset += recordBytes(0);
+    }
+  }
+
+  lockStore();
+  // Records appended since the snapshot go over as they are.
+  uint32_t end = storageFileSize(StoreFile::PROFILES);
+  int32_t tail_shift = static_cast<int32_t>(offset) - static_cast<int32_t>(snapshot_end);
+  ok = ok && (was_dirty || !g_tail_dirty) && copyToRewrite(snapshot_end, end - snapshot_end, false);
+  for (uint16_t i = 0; i < g_index_count && ok; ++i) {
+    uint32_t moved = g_index[i].offset;
+    ok = remapOffset(copied, snapshot_end, tail_shift, moved);
+  }
+  for (const Pin &pin : g_pins) {
+    uint32_t moved = pin.offset;
+    ok = ok && (!pin.used || remapOffset(copied, snapshot_end, tail_shift, moved));
+  }
+  ok = ok && storageFileSync(StoreFile::REWRITE) && storageFileCommitRewrite();
+  if (ok) {
+    for (uint16_t i = 0; i < g_index_count; ++i) {
+      remapOffset(copied, snapshot_end, tail_shift, g_index[i].offset);
+    }
+    for (Pin &pin : g_pins) {
+      if (pin.used) {
+        remapOffset(copied, snapshot_end, tail_shift, pin.offset);
+      }
+    }
+    g_generation++;
+    g_compactions++;
+    g_tail_dirty = false;
+    logInfo(LogModule::PROFILE, "profile store compacted: %u -> %u bytes", end, storageFileSize(StoreFile::PROFILES));
+  } else {
+    storageFileReset(StoreFile::REWRITE);
+    logWarn(LogModule::PROFILE, "profile store compaction failed");
+  }
+  g_compacting = false;
+  unlockStore();
+  return ok;
+}
+
+void profileStoreGetStats(ProfileStoreStats &out_stats) {
+  lockStore();
+  out_stats.file_bytes = storageFileSize(StoreFile::PROFILES);
+  out_stats.live_bytes = liveBytes();
+  out_stats.compactions = g_compactions;
+  out_stats.bytes_written = storageFileBytesWritten();
+  unlockStore();
+}
+
+uint16_t profileStoreCount() {
+  return g_index_count;
+}
+
+bool profileStoreInfoAt(uint16_t index, ProfileInfo &out_info) {
+  lockStore();
+  bool ok = index < g_index_count && fillInfo(index, out_info);
+  unlockStore();
+  return ok;
+}
+
+bool profileStoreFind(const char *name, ProfileInfo &out_info) {
+  lockStore();
+  int index = findEntry(name, nameHash(name));
+  bool ok = index >= 0 && fillInfo(index, out_info);
+  unlockStore();
+  return ok;
+}
+
+bool profileStoreReadPoints(const ProfileInfo &info, uint16_t first, ProfilePoint *out, uint16_t n) {
+  if (first > info.count || n > info.count - first) {
+    return false;
+  }
+  lockStore();
+  bool ok = info.generation == g_generation &&
+            storageFileRead(StoreFile::PROFILES, pointOffset(info.offset, first), out, n * sizeof(ProfilePoint));
+  unlockStore();
+  return ok;
+}
+
+void profileSetTempLimits(float min_c, float max_c) {
+  g_temp_min_c = min_c;
+  g_temp_max_c = max_c;
+}
+
+uint32_t profileStoreWriteBegin() {
+  lockStore();
+  uint32_t now_ms = halMillis();
+  if (g_write.id != 0 && now_ms - g_write.last_ms < PROFILE_WRITE_TIMEOUT_MS) {
+    unlockStore();
+    return 0;
+  }
+  if (g_write.id != 0) {
+    logWarn(LogModule::PROFILE, "idle profile upload %u taken over", g_write.id);
+  }
+  endSession();
+  if (!storageFileReset(StoreFile::STAGING)) {
+    unlockStore();
+    return 0;
+  }
+  g_write.id = g_next_session++;
+  if (g_next_session == 0) {
+    g_next_session = 1;
+  }
+  g_write.last_ms = now_ms;
+  g_write.count = 0;
+  uint32_t session = g_write.id;
+  unlockStore();
+  return session;
+}
+
+bool profileStoreWritePoint(uint32_t session, const ProfilePoint &point, const char *&error) {
+  lockStore();
+  error = nullptr;
+  if (!sessionValid(session)) {
+    error = "upload_superseded";
+  } else if (g_write.count >= kMaxProfilePoints) {
+    error = "too_many_points";
+  } else if (!(point.temp_c >= g_temp_min_c && point.temp_c <= g_temp_max_c)) {
+    error = "temp_out_of_range";
+  } else if (g_write.count > 0 && point.t_sec <= g_write.last.t_sec) {
+    error = "points_not_monotonic";
+  } else {
+    g_write.buffer[g_write.buffered++] = point;
+    g_write.last = point;
+    g_write.count++;
+    g_write.last_ms = halMillis();
+    if (g_write.buffered == PROFILE_PAGE_POINTS && !flushSession()) {
+      error = "storage_failed";
+    }
+  }
+  if (error && sessionValid(session)) {
+    endSession();
+  }
+  unlockStore();
+  return error == nullptr;
+}
+
+bool profileStoreWriteCommit(uint32_t session, const char *name, EndBehavior end_behavior, const char *&error) {
+  lockStore();
+  error = nullptr;
+  size_t name_len = strlen(name);
+  int existing = -1;
+  if (!sessionValid(session)) {
+    error = "upload_superseded";
+  } else if (name_len == 0) {
+    error = "name_required";
+  } else if (name_len > kMaxProfileNameLength) {
+    error = "name_too_long";
+  } else if (g_write.count < 2) {
+    error = "points_min";
+  } else if ((existing = findEntry(name, nameHash(name))) < 0 && g_index_count >= PROFILE_STORE_MAX_PROFILES) {
+    error = "profiles_full";
+  } else if (!flushSession()) {
+    error = "storage_failed";
+  }
+
+  if (!error) {
+    StoreRecordHeader header = makeHeader(RecordKind::PUT, name, g_write.count, end_behavior);
+    uint32_t offset = 0;
+    if (!appendRecord(header, offset)) {
+      error = "storage_failed";
+    } else if (existing >= 0) {
+      g_index[existing].offset = offset;
+      g_index[existing].count = header.count;
+      g_index[existing].end_behavior = header.end_behavior;
+    } else {
+      putEntry(name, offset, header.count, end_behavior);
+    }
+  }
+  if (sessionValid(session)) {
+    endSession();
+  }
+  unlockStore();
+  if (error && strcmp(error, "storage_failed") == 0) {
+    logError(LogModule::PROFILE, "profile %s not saved", name);
+  }
+  return error == nullptr;
+}
+
+void profileStoreWriteAbort(uint32_t session) {
+  lockStore();
+  if (sessionValid(session)) {
+    endSession();
+  }
+  unlockStore();
+}
+
+bool profileStoreAdd(const Profile &profile, const char *&error) {
+  uint32_t session = profileStoreWriteBegin();
+  if (session == 0) {
+    error = "upload_busy";
+    return false;
+  }
+  for (uint8_t i = 0; i < profile.count; ++i) {
+    if (!profileStoreWritePoint(session, profile.points[i], error)) {
+      return false;
+    }
+  }
+  return profileStoreWriteCommit(session, profile.name, profile.end_behavior, error);
+}
+
+bool profileStoreDelete(const char *name) {
+  lockStore();
+  int index = findEntry(name, nameHash(name));
+  uint32_t offset = 0;
+  bool ok = index >= 0 && appendRecord(makeHeader(RecordKind::DELETE, name, 0, EndBehavior::HOLD_LAST), offset);
+  if (ok) {
+    removeEntry(index);
+  }
+  unlockStore();
+  return ok;
+}
+
+bool profileStorePin(uint8_t slot, const char *name, ProfileInfo &out_info) {
+  if (slot >= MAX_ZONES) {
+    return false;
+  }
+  lockStore();
+  int index = findEntry(name, nameHash(name));
+  bool ok = index >= 0 && fillInfo(index, out_info);
+  if (ok) {
+    g_pins[slot] = Pin{true, out_info.offset, out_info.count};
+  }
+  unlockStore();
+  return ok;
+}
+
+void profileStoreUnpin(uint8_t slot) {
+  if (slot >= MAX_ZONES) {
+    return;
+  }
+  lockStore();
+  g_pins[slot].used = false;
+  unlockStore();
+}
+
+bool profileStoreReadPinned(uint8_t slot, uint16_t first, ProfilePoint *out, uint16_t n) {
+  if (slot >= MAX_ZONES) {
+    return false;
+  }
+  lockStore();
+  const Pin &pin = g_pins[slot];
+  bool ok = pin.used && first <= pin.count && n <= pin.count - first &&
+            storageFileRead(StoreFile::PROFILES, pointOffset(pin.offset, first), out, n * sizeof(ProfilePoint));
+  unlockStore();
+  return ok;
+}
@@ -0,0 +1,323 @@
+#include "runlog.h"
+#include "app_config.h"
+#include "crc32.h"
+#include "log.h"
+#include "metrics.h"
+#include "profile.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+namespace {
+constexpr char kRunDir[] = "/runs";
+constexpr uint8_t kBatchCount = 3;
+constexpr uint8_t kQueueLength = 8;
+constexpr uint8_t kMaxScannedRuns = 64;
+// A single run stops growing past this (e.g. HOLD_LAST left running).
+constexpr uint32_t kMaxRunBytes = RUNLOG_MAX_BYTES / 2;
+
+enum class RunlogOp : uint8_t {
+  OPEN,
+  BATCH,
+  CLOSE
+};
+
+struct RunlogMessage {
+  RunlogOp op;
+  uint8_t batch;
+  uint8_t zone_count;
+  uint32_t run_id;
+  uint32_t start_ms;
+};
+
+// busy is set by the control task when it starts filling a batch and
+// cleared by the writer task once the batch is on flash.
+struct RunlogBatch {
+  std::atomic<bool> busy{false};
+  uint32_t first_tick = 0;
+  uint16_t count = 0;
+  TickRecord records[RUNLOG_BATCH_RECORDS];
+};
+
+RunlogBatch g_batches[kBatchCount];
+QueueHandle_t g_queue = nullptr;
+std::atomic<uint32_t> g_dropped{0};
+uint32_t g_next_run_id = 1;
+
+// Control task only.
+bool g_run_active = false;
+uint32_t g_run_tick = 0;
+int8_t g_fill = -1;
+
+// Writer task only.
+File g_file;
+
+bool parseRunId(const char *name, uint32_t &out_id) {
+  char *end = nullptr;
+  unsigned long id = strtoul(name, &end, 10);
+  if (end == name || strcmp(end, ".bin") != 0) {
+    return false;
+  }
+  out_id = static_cast<uint32_t>(id);
+  return true;
+}
+
+// Reads a header of any version into the current layout; zone_count is 1
+// for version 1. False without a magic and CRC of a known layout.
+bool readHeader(File &file, RunlogFileHeader &out) {
+  size_t got = file.read(reinterpret_cast<uint8_t *>(&out), sizeof(out));
+  if (got < sizeof(RunlogFileHeaderV2) || out.magic != kRunlogMagic) {
+    return false;
+  }
+  if (out.version >= 3) {
+    return got == sizeof(out) && out.crc == crc32(&out, offsetof(RunlogFileHeader, crc));
+  }
+  RunlogFileHeaderV2 old;
+  memcpy(&old, &out, sizeof(old));
+  if (old.crc != crc32(&old, offsetof(RunlogFileHeaderV2, crc))) {
+    return false;
+  }
+  memset(out.profile, 0, sizeof(out.profile));
+  memcpy(out.profile, old.profile, sizeof(old.profile));
+  out.zone_count = old.version >= 2 ? old.zone_count : 1;
+  return true;
+}
+
+int8_t claimBatch() {
+  for (uint8_t i = 0; i < kBatchCount; ++i) {
+    bool expected = false;
+    if (g_batches[i].busy.compare_exchange_strong(expected, true)) {
+      g_batches[i].count = 0;
+      return static_cast<int8_t>(i);
+    }
+  }
+  return -1;
+}
+
+bool sendMessage(RunlogOp op, uint8_t batch, uint32_t run_id = 0, uint32_t start_ms = 0, uint8_t zone_count = 0) {
+  RunlogMessage msg{op, batch, zone_count, run_id, start_ms};
+  return xQueueSend(g_queue, &msg, 0) == pdTRUE;
+}
+
+void submitBatch() {
+  if (g_fill < 0) {
+    return;
+  }
+  RunlogBatch &batch = g_batches[g_fill];
+  if (batch.count > 0 && !sendMessage(RunlogOp::BATCH, static_cast<uint8_t>(g_fill))) {
+    g_dropped.fetch_add(batch.count);
+    batch.busy.store(false);
+  } else if (batch.count == 0) {
+    batch.busy.store(false);
+  }
+  g_fill = -1;
+}
+
+// Deletes the oldest runs until one more fits in the count/size budget.
+void enforceRetention() {
+  uint32_t ids[kMaxScannedRuns];
+  uint32_t sizes[kMaxScannedRuns];
+  uint8_t count = 0;
+  uint32_t total = 0;
+
+  File dir = LittleFS.open(kRunDir);
+  if (!dir) {
+    return;
+  }
+  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+    uint32_t id = 0;
+    if (!entry.isDirectory() && parseRunId(entry.name(), id) && count < kMaxScannedRuns) {
+      ids[count] = id;
+      sizes[count] = entry.size();
+      total += sizes[count];
+      count++;
+    }
+  }
+  dir.close();
+
+  while (count > 0 && (count >= RUNLOG_MAX_RUNS || total >= RUNLOG_MAX_BYTES)) {
+    uint8_t oldest = 0;
+    for (uint8_t i = 1; i < count; ++i) {
+      if (ids[i] < ids[oldest]) {
+        oldest = i;
+      }
+    }
+    char path[kRunlogPathSize];
+    runlogPath(ids[oldest], path, sizeof(path));
+    LittleFS.remove(path);
+    total -= sizes[oldest];
+    ids[oldest] = ids[count - 1];
+    sizes[oldest] = sizes[count - 1];
+    count--;
+  }
+}
+
+void openRun(uint32_t run_id, uint32_t start_ms, uint8_t zone_count) {
+  enforceRetention();
+  char path[kRunlogPathSize];
+  runlogPath(run_id, path, sizeof(path));
+  g_file = LittleFS.open(path, "w");
+  if (!g_file) {
+    logError(LogModule::RUNLOG, "open failed");
+    return;
+  }
+  RunlogFileHeader header{};
+  header.magic = kRunlogMagic;
+  header.version = kRunlogVersion;
+  header.record_size = sizeof(TickRecord);
+  header.run_id = run_id;
+  header.start_ms = start_ms;
+  header.period_ms = CONTROL_PERIOD_MS;
+  header.zone_count = zone_count;
+  profileCopyActiveName(0, header.profile, sizeof(header.profile));
+  header.crc = crc32(&header, offsetof(RunlogFileHeader, crc));
+  g_file.write(reinterpret_cast<const uint8_t *>(&header), sizeof(header));
+  g_file.flush();
+}
+
+void writeBatch(RunlogBatch &batch) {
+  if (!g_file || g_file.size() >= kMaxRunBytes) {
+    g_dropped.fetch_add(batch.count);
+    return;
+  }
+  RunlogFrameHeader frame{kRunlogFrameMagic, batch.count, batch.first_tick};
+  size_t records_len = batch.count * sizeof(TickRecord);
+  uint32_t crc = crc32(&frame, sizeof(frame));
+  crc = crc32Update(crc, batch.records, records_len);
+  g_file.write(reinterpret_cast<const uint8_t *>(&frame), sizeof(frame));
+  g_file.write(reinterpret_cast<const uint8_t *>(batch.records), records_len);
+  g_file.write(reinterpret_cast<const uint8_t *>(&crc), sizeof(crc));
+  g_file.flush();
+}
+} // namespace
+
+void runlogInit() {
+  if (!LittleFS.exists(kRunDir)) {
+    LittleFS.mkdir(kRunDir);
+  }
+  File dir = LittleFS.open(kRunDir);
+  if (dir) {
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+      uint32_t id = 0;
+      if (parseRunId(entry.name(), id) && id >= g_next_run_id) {
+        g_next_run_id = id + 1;
+      }
+    }
+    dir.close();
+  }
+  if (!g_queue) {
+    g_queue = xQueueCreate(kQueueLength, sizeof(RunlogMessage));
+  }
+}
+
+void runlogOnTick() {
+  if (!g_queue) {
+    return;
+  }
+  TelemetryFrame frame;
+  if (!telemetryLatest(frame)) {
+    return;
+  }
+  // Autotune experiments are logged like runs.
+  bool running = frame.status.state == RunState::RUNNING || frame.status.state == RunState::AUTOTUNE;
+  uint8_t zones = frame.status.zone_count;
+  if (!g_run_active) {
+    if (!running) {
+      return;
+    }
+    g_run_active = true;
+    g_run_tick = 0;
+    sendMessage(RunlogOp::OPEN, 0, g_next_run_id++, frame.t_ms, zones);
+  }
+
+  if (g_fill < 0) {
+    g_fill = claimBatch();
+    if (g_fill >= 0) {
+      g_batches[g_fill].first_tick = g_run_tick;
+    }
+  }
+  if (g_fill >= 0) {
+    RunlogBatch &batch = g_batches[g_fill];
+    for (uint8_t z = 0; z < zones; ++z) {
+      telemetryEncodeRecord(frame, z, batch.records[batch.count++]);
+    }
+    // Frames hold whole ticks.
+    if (batch.count + zones > RUNLOG_BATCH_RECORDS) {
+      submitBatch();
+    }
+  } else {
+    g_dropped.fetch_add(zones);
+  }
+  g_run_tick++;
+
+  // The first non-running tick is logged so the file records how it ended.
+  if (!running) {
+    submitBatch();
+    sendMessage(RunlogOp::CLOSE, 0);
+    g_run_active = false;
+  }
+}
+
+void runlogProcess() {
+  RunlogMessage msg;
+  if (!g_queue || xQueueReceive(g_queue, &msg, portMAX_DELAY) != pdTRUE) {
+    return;
+  }
+  MetricTimer timer(Metric::TASK_RUNLOG);
+  switch (msg.op) {
+    case RunlogOp::OPEN:
+      if (g_file) {
+        g_file.close();
+      }
+      openRun(msg.run_id, msg.start_ms, msg.zone_count);
+      break;
+    case RunlogOp::BATCH:
+      writeBatch(g_batches[msg.batch]);
+      g_batches[msg.batch].busy.store(false);
+      break;
+    case RunlogOp::CLOSE:
+      if (g_file) {
+        g_file.close();
+      }
+      break;
+  }
+}
+
+void runlogList(JsonDocument &out_doc) {
+  JsonArray items = out_doc["runs"].to<JsonArray>();
+
+  File dir = LittleFS.open(kRunDir);
+  if (dir) {
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+      uint32_t id = 0;
+      if (entry.isDirectory() || !parseRunId(entry.name(), id)) {
+        continue;
+      }
+      RunlogFileHeader header{};
+      bool valid = readHeader(entry, header);
+      JsonObject item = items.add<JsonObject>();
+      item["id"] = id;
+      item["bytes"] = entry.size();
+      if (valid) {
+        header.profile[sizeof(header.profile) - 1] = '\0';
+        item["profile"] = header.profile;
+        item["start_ms"] = header.start_ms;
+        item["zones"] = header.zone_count;
+      }
+    }
+    dir.close();
+  }
+  out_doc["dropped"] = g_dropped.load();
+}
+
+void runlogPath(uint32_t run_id, char *out, size_t cap) {
+  snprintf(out, cap, "%s/%lu.bin", kRunDir, static_cast<unsigned long>(run_id));
+}
+
+uint32_t runlogDroppedRecords() {
+  return g_dropped.load();
+}
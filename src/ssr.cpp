@@ -0,0 +1,159 @@
+#include "ssr.h"
+#include "app_config.h"
+#include "hal.h"
+#include <atomic>
+
+namespace {
+// Duty in Q16 fixed point: the tick runs in interrupt context, where the
+// ESP32 does not preserve FPU state.
+constexpr uint32_t kDutyOne = 1u << 16;
+
+// Shared with the timer callback; written by tasks, read once per tick.
+std::atomic<uint32_t> g_duty_q16[MAX_ZONES] = {};
+std::atomic<uint8_t> g_zone_count{0};
+std::atomic<uint8_t> g_mode{static_cast<uint8_t>(SsrMode::TIME_PROPORTIONAL)};
+std::atomic<uint32_t> g_window_ticks{1};
+std::atomic<uint32_t> g_min_on_ticks{0};
+std::atomic<uint32_t> g_min_off_ticks{0};
+std::atomic<bool> g_active_high{true};
+std::atomic<bool> g_reset{true};
+
+// Timer callback only, one per zone.
+struct Modulator {
+  uint8_t mode = 0;
+  bool on = false;
+  uint32_t dwell_ticks = 0;    // ticks spent in the current output state
+  uint32_t window_tick = 0;    // TIME_PROPORTIONAL position in the window
+  int32_t accumulator = 0;     // BURST error, Q16
+};
+Modulator g_mod[MAX_ZONES];
+
+uint32_t msToTicks(uint32_t ms, bool round_up) {
+  uint64_t us = static_cast<uint64_t>(ms) * 1000;
+  return static_cast<uint32_t>(round_up ? (us + SSR_TICK_US - 1) / SSR_TICK_US
+                                        : (us + SSR_TICK_US / 2) / SSR_TICK_US);
+}
+
+void writeOutput(uint8_t zone, bool on) {
+  bool active_high = g_active_high.load(std::memory_order_relaxed);
+  halSetSsr(zone, on == active_high ? HIGH : LOW);
+}
+
+bool timeProportional(Modulator &mod, uint32_t duty) {
+  uint32_t window = g_window_ticks.load(std::memory_order_relaxed);
+  uint32_t min_on = g_min_on_ticks.load(std::memory_order_relaxed);
+  uint32_t min_off = g_min_off_ticks.load(std::memory_order_relaxed);
+  if (mod.window_tick >= window) {
+    mod.window_tick = 0;
+  }
+  uint32_t on_ticks = static_cast<uint32_t>((static_cast<uint64_t>(duty) * window + kDutyOne / 2) >> 16);
+  if (on_ticks > 0 && on_ticks < min_on) {
+    on_ticks = min_on;
+  }
+  if (on_ticks < window && window - on_ticks < min_off) {
+    on_ticks = window > min_off ? window - min_off : 0;
+  }
+  return mod.window_tick++ < on_ticks;
+}
+
+// First-order sigma-delta: accumulate the requested duty and fire a tick
+// whenever a whole tick's worth is owed. Ticks forced by the dwell limits are
+// booked against the accumulator, so the long-run average stays on target.
+bool burst(Modulator &mod, uint32_t duty) {
+  uint32_t min_on = g_min_on_ticks.load(std::memory_order_relaxed);
+  uint32_t min_off = g_min_off_ticks.load(std::memory_order_relaxed);
+  mod.accumulator += static_cast<int32_t>(duty);
+  bool want = mod.accumulator >= static_cast<int32_t>(kDutyOne);
+  if (mod.on && mod.dwell_ticks < min_on) {
+    want = true;
+  } else if (!mod.on && mod.dwell_ticks < min_off) {
+    want = false;
+  }
+  if (want) {
+    mod.accumulator -= static_cast<int32_t>(kDutyOne);
+  }
+  int32_t limit = static_cast<int32_t>((max(min_on, min_off) + 1) * kDutyOne);
+  if (mod.accumulator > limit) {
+    mod.accumulator = limit;
+  } else if (mod.accumulator < -limit) {
+    mod.accumulator = -limit;
+  }
+  return want;
+}
+
+void tickZone(uint8_t zone, uint8_t mode, bool reset) {
+  Modulator &mod = g_mod[zone];
+  if (reset || mode != mod.mode) {
+    mod = Modulator{};
+    mod.mode = mode;
+  }
+  uint32_t duty = g_duty_q16[zone].load(std::memory_order_relaxed);
+  bool on = false;
+  if (duty > 0) {
+    on = mode == static_cast<uint8_t>(SsrMode::BURST) ? burst(mod, duty) : timeProportional(mod, duty);
+  } else {
+    mod.window_tick = 0;
+    mod.accumulator = 0;
+  }
+  if (on != mod.on) {
+    mod.on = on;
+    mod.dwell_ticks = 0;
+  }
+  if (mod.dwell_ticks < UINT32_MAX) {
+    mod.dwell_ticks++;
+  }
+  writeOutput(zone, on);
+}
+
+void ssrTick() {
+  uint8_t mode = g_mode.load(std::memory_order_relaxed);
+  bool reset = g_reset.exchange(false);
+  uint8_t zones = g_zone_count.load(std::memory_order_relaxed);
+  for (uint8_t z = 0; z < zones; ++z) {
+    tickZone(z, mode, reset);
+  }
+}
+} // namespace
+
+void ssrInit(const ControlConfig &config, uint8_t zone_count) {
+  ssrConfigure(config);
+  g_zone_count.store(min(zone_count, MAX_ZONES));
+  for (uint8_t z = 0; z < zone_count && z < MAX_ZONES; ++z) {
+    writeOutput(z, false);
+  }
+  halStartTimer(SSR_TICK_US, ssrTick);
+}
+
+void ssrConfigure(const ControlConfig &config) {
+  g_window_ticks.store(max<uint32_t>(1, msToTicks(config.window_ms, false)));
+  g_min_on_ticks.store(msToTicks(config.min_on_ms, true));
+  g_min_off_ticks.store(msToTicks(config.min_off_ms, true));
+  g_active_high.store(config.ssr_active_high);
+  g_mode.store(static_cast<uint8_t>(config.ssr_mode));
+}
+
+void ssrSetDuty(uint8_t zone, float duty) {
+  if (zone >= MAX_ZONES) {
+    return;
+  }
+  if (isnan(duty) || duty <= 0.0f) {
+    g_duty_q16[zone].store(0);
+  } else if (duty >= 1.0f) {
+    g_duty_q16[zone].store(kDutyOne);
+  } else {
+    g_duty_q16[zone].store(static_cast<uint32_t>(duty * kDutyOne + 0.5f));
+  }
+}
+
+void ssrStop() {
+  uint8_t zones = g_zone_count.load();
+  for (uint8_t z = 0; z < zones; ++z) {
+    g_duty_q16[z].store(0);
+  }
+  g_reset.store(true);
+  // A tick already in flight may still write once; the next one sees the
+  // reset, so the outputs are off within SSR_TICK_US.
+  for (uint8_t z = 0; z < zones; ++z) {
+    writeOutput(z, false);
+  }
+}
@@ -0,0 +1,54 @@
+#include "status_json.h"
+#include "json_writer.h"
+
+const char *runStateName(RunState state) {
+  switch (state) {
+    case RunState::IDLE:
+      return "IDLE";
+    case RunState::RUNNING:
+      return "RUNNING";
+    case RunState::SWITCH_DISABLED:
+      return "DISABLED";
+    case RunState::FAULT:
+      return "ERROR";
+    case RunState::AUTOTUNE:
+      return "AUTOTUNE";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+size_t statusRenderJson(char *buf, size_t cap, uint32_t seq, const ControlStatus &s, const ControlTiming &timing,
+                        const char (*profiles)[kMaxProfileNameLength + 1]) {
+  JsonWriter out(buf, cap);
+  out.raw("{\"ok\":true,\"data\":");
+  out.beginObject();
+  out.field("seq", seq);
+  out.field("state", runStateName(s.state));
+  out.field("t_meas", s.t_meas_c[0], 2);
+  out.field("t_set", s.t_set_c[0], 2);
+  out.field("duty", s.duty[0], 3);
+  out.field("delta", s.t_set_c[0] - s.t_meas_c[0], 2);
+  out.field("run_switch", s.run_switch_enabled);
+  out.field("active_profile", profiles[0]);
+  out.field("fault", static_cast<uint32_t>(s.last_fault));
+  out.field("latency_us", timing.last_latency_us);
+  out.field("latency_max_us", timing.max_latency_us);
+  out.field("deadline_misses", timing.deadline_misses);
+  if (s.zone_count > 1) {
+    out.beginArray("zones");
+    for (uint8_t z = 0; z < s.zone_count; ++z) {
+      out.beginObject();
+      out.field("t_meas", s.t_meas_c[z], 2);
+      out.field("t_set", s.t_set_c[z], 2);
+      out.field("duty", s.duty[z], 3);
+      out.field("fault", static_cast<uint32_t>(s.zone_fault[z]));
+      out.field("profile", profiles[z]);
+      out.endObject();
+    }
+    out.endArray();
+  }
+  out.endObject();
+  out.raw("}");
+  return out.length();
+}
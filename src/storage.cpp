@@ -0,0 +1,156 @@
+#include "storage.h"
+#include "app_config.h"
+#include "log.h"
+#include "profile.h"
+#include "profile_store.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <atomic>
+
+namespace {
+constexpr char kLegacyProfilesPath[] = "/profiles.json";
+constexpr char kLegacyImportedPath[] = "/profiles.json.imported";
+constexpr char kLogPath[] = "/log.txt";
+constexpr char kLogOldPath[] = "/log.old";
+
+constexpr const char *kStorePaths[] = {"/profiles.bin", "/profiles.stage", "/profiles.new"};
+static_assert(sizeof(kStorePaths) / sizeof(kStorePaths[0]) == static_cast<uint8_t>(StoreFile::COUNT),
+              "one path per StoreFile");
+File g_store_files[static_cast<uint8_t>(StoreFile::COUNT)];
+std::atomic<uint32_t> g_store_bytes_written{0};
+
+// Opened on first use with "a+": reads anywhere, writes at the end.
+File &storeFile(StoreFile file) {
+  File &handle = g_store_files[static_cast<uint8_t>(file)];
+  if (!handle) {
+    handle = LittleFS.open(kStorePaths[static_cast<uint8_t>(file)], "a+");
+  }
+  return handle;
+}
+
+void closeStoreFile(StoreFile file) {
+  File &handle = g_store_files[static_cast<uint8_t>(file)];
+  if (handle) {
+    handle.close();
+  }
+}
+} // namespace
+
+bool storageInit() {
+  if (!LittleFS.begin(true)) {
+    logError(LogModule::STORAGE, "LittleFS mount failed");
+    return false;
+  }
+  return true;
+}
+
+bool storageLoadProfiles() {
+  if (!profileStoreLoad()) {
+    return false;
+  }
+  // Profiles saved by older firmware are imported once, then kept aside.
+  File file = LittleFS.open(kLegacyProfilesPath, "r");
+  if (!file) {
+    return true;
+  }
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, file);
+  file.close();
+  if (err) {
+    logError(LogModule::STORAGE, "profiles import failed: %s", err.c_str());
+    return false;
+  }
+
+  for (JsonObjectConst item : doc["profiles"].as<JsonArrayConst>()) {
+    Profile profile{};
+    profileFromJson(item, profile);
+    const char *error = nullptr;
+    if (!profileStoreAdd(profile, error)) {
+      logWarn(LogModule::STORAGE, "profile skipped: %s %s", profile.name, error);
+    }
+  }
+  LittleFS.remove(kLegacyImportedPath);
+  LittleFS.rename(kLegacyProfilesPath, kLegacyImportedPath);
+  logInfo(LogModule::STORAGE, "imported %u profiles from %s", profileStoreCount(), kLegacyProfilesPath);
+  return true;
+}
+
+uint32_t storageFileSize(StoreFile file) {
+  File &handle = storeFile(file);
+  return handle ? handle.size() : 0;
+}
+
+bool storageFileRead(StoreFile file, uint32_t offset, void *out, size_t len) {
+  File &handle = storeFile(file);
+  if (!handle || !handle.seek(offset)) {
+    return false;
+  }
+  return handle.read(static_cast<uint8_t *>(out), len) == len;
+}
+
+bool storageFileAppend(StoreFile file, const void *data, size_t len) {
+  File &handle = storeFile(file);
+  if (!handle) {
+    return false;
+  }
+  size_t written = handle.write(static_cast<const uint8_t *>(data), len);
+  g_store_bytes_written.fetch_add(written, std::memory_order_relaxed);
+  return written == len;
+}
+
+bool storageFileSync(StoreFile file) {
+  File &handle = storeFile(file);
+  if (!handle) {
+    return false;
+  }
+  handle.flush();
+  return true;
+}
+
+uint32_t storageFileBytesWritten() {
+  return g_store_bytes_written.load(std::memory_order_relaxed);
+}
+
+bool storageFileReset(StoreFile file) {
+  closeStoreFile(file);
+  File handle = LittleFS.open(kStorePaths[static_cast<uint8_t>(file)], "w");
+  if (!handle) {
+    return false;
+  }
+  handle.close();
+  return static_cast<bool>(storeFile(file));
+}
+
+bool storageFileCommitRewrite() {
+  File &rewrite = storeFile(StoreFile::REWRITE);
+  if (!rewrite) {
+    return false;
+  }
+  rewrite.flush();
+  closeStoreFile(StoreFile::REWRITE);
+  closeStoreFile(StoreFile::PROFILES);
+  // LittleFS rename replaces the target atomically: a reset leaves either
+  // the old or the new file.
+  bool ok = LittleFS.rename(kStorePaths[static_cast<uint8_t>(StoreFile::REWRITE)],
+                            kStorePaths[static_cast<uint8_t>(StoreFile::PROFILES)]);
+  storageFileReset(StoreFile::REWRITE);
+  return ok;
+}
+
+void storageAppendLog(const char *line, size_t len) {
+  File file = LittleFS.open(kLogPath, "a");
+  if (!file) {
+    return;
+  }
+  if (file.size() + len > LOG_FILE_MAX_BYTES) {
+    file.close();
+    LittleFS.remove(kLogOldPath);
+    LittleFS.rename(kLogPath, kLogOldPath);
+    file = LittleFS.open(kLogPath, "a");
+    if (!file) {
+      return;
+    }
+  }
+  file.write(reinterpret_cast<const uint8_t *>(line), len);
+  file.close();
+}
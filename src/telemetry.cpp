@@ -0,0 +1,137 @@
+#include "telemetry.h"
+#include <atomic>
+#include "control.h"
+#include "seqlock.h"
+
+namespace {
+Seqlock<TelemetryFrame> g_latest;
+uint32_t g_tick_seq = 0;
+
+// Single writer (control task). g_history_count is the number of ticks ever
+// written; tick n holds g_history_zones consecutive records starting at
+// (n % g_history_ticks) * g_history_zones and was taken at
+// g_history_t0_ms + n * CONTROL_PERIOD_MS. The layout is fixed by the first
+// tick (the zone count does not change at runtime).
+TickRecord g_history[HISTORY_CAPACITY];
+std::atomic<uint32_t> g_history_count{0};
+uint32_t g_history_t0_ms = 0;
+uint8_t g_history_zones = 1;
+uint32_t g_history_ticks = HISTORY_CAPACITY;
+
+int16_t encodeTemp(float temp_c) {
+  if (isnan(temp_c)) {
+    return kHistoryTempInvalid;
+  }
+  float scaled = roundf(temp_c * kHistoryTempScale);
+  if (scaled <= static_cast<float>(INT16_MIN)) return INT16_MIN + 1;
+  if (scaled > static_cast<float>(INT16_MAX)) return INT16_MAX;
+  return static_cast<int16_t>(scaled);
+}
+
+void appendHistory(const TelemetryFrame &frame) {
+  uint32_t n = g_history_count.load(std::memory_order_relaxed);
+  if (n == 0) {
+    g_history_t0_ms = frame.t_ms;
+    g_history_zones = max<uint8_t>(1, frame.status.zone_count);
+    g_history_ticks = HISTORY_CAPACITY / g_history_zones;
+  }
+  TickRecord *slot = &g_history[(n % g_history_ticks) * g_history_zones];
+  for (uint8_t z = 0; z < g_history_zones; ++z) {
+    telemetryEncodeRecord(frame, z, slot[z]);
+  }
+  g_history_count.store(n + 1, std::memory_order_release);
+}
+} // namespace
+
+void telemetryEncodeRecord(const TelemetryFrame &frame, uint8_t zone, TickRecord &out_record) {
+  const ControlStatus &status = frame.status;
+  out_record.t_meas = encodeTemp(status.t_meas_c[zone]);
+  out_record.t_set = encodeTemp(status.t_set_c[zone]);
+  float duty = status.duty[zone] < 0.0f ? 0.0f : (status.duty[zone] > 1.0f ? 1.0f : status.duty[zone]);
+  out_record.duty = static_cast<uint8_t>(lroundf(duty * 255.0f));
+  out_record.state = static_cast<uint8_t>(status.state);
+  out_record.fault = status.zone_fault[zone];
+  out_record.reserved = 0;
+}
+
+void telemetryPublish(uint32_t now_ms) {
+  TelemetryFrame frame;
+  frame.seq = ++g_tick_seq;
+  frame.t_ms = now_ms;
+  controlGetStatus(frame.status);
+  g_latest.write(frame);
+  appendHistory(frame);
+}
+
+bool telemetryLatest(TelemetryFrame &out_frame) {
+  g_latest.read(out_frame);
+  return out_frame.seq != 0;
+}
+
+uint16_t telemetryHistoryQuery(uint8_t zone, uint32_t from_ms, uint32_t to_ms, uint16_t max_points,
+                               HistoryBucket *out_buckets, HistoryRange &out_range) {
+  out_range = HistoryRange{};
+  uint32_t count = g_history_count.load(std::memory_order_acquire);
+  if (count == 0 || max_points == 0 || to_ms < from_ms || zone >= g_history_zones) {
+    return 0;
+  }
+  const uint32_t capacity = g_history_ticks;
+
+  // Index window [first, last] of records that are retained and in range.
+  // Once the ring has wrapped the oldest slot is the next one to be
+  // overwritten, so it is left out.
+  uint32_t t0_ms = g_history_t0_ms;
+  uint32_t oldest = count >= capacity ? count - capacity + 1 : 0;
+  uint32_t first = from_ms > t0_ms ? (from_ms - t0_ms + CONTROL_PERIOD_MS - 1) / CONTROL_PERIOD_MS : 0;
+  uint32_t last = to_ms > t0_ms ? (to_ms - t0_ms) / CONTROL_PERIOD_MS : 0;
+  if (first < oldest) first = oldest;
+  if (last > count - 1) last = count - 1;
+  if (to_ms < t0_ms || first > last) {
+    return 0;
+  }
+
+  uint32_t ticks = last - first + 1;
+  uint32_t per_bucket = (ticks + max_points - 1) / max_points;
+  uint16_t buckets = static_cast<uint16_t>((ticks + per_bucket - 1) / per_bucket);
+
+  uint32_t duty_sum = 0;
+  uint16_t bucket = 0;
+  uint32_t in_bucket = 0;
+  HistoryBucket current;
+  for (uint32_t n = first; n <= last; ++n) {
+    const TickRecord record = g_history[(n % capacity) * g_history_zones + zone];
+    if (record.t_meas != kHistoryTempInvalid) {
+      if (current.t_meas_min == kHistoryTempInvalid || record.t_meas < current.t_meas_min) current.t_meas_min = record.t_meas;
+      if (current.t_meas_max == kHistoryTempInvalid || record.t_meas > current.t_meas_max) current.t_meas_max = record.t_meas;
+    }
+    current.t_set = record.t_set;
+    current.state = record.state;
+    current.fault |= record.fault;
+    duty_sum += record.duty;
+    if (++in_bucket == per_bucket || n == last) {
+      current.duty = static_cast<uint8_t>(duty_sum / in_bucket);
+      out_buckets[bucket++] = current;
+      current = HistoryBucket{};
+      duty_sum = 0;
+      in_bucket = 0;
+    }
+  }
+
+  // Records the control task overwrote while we were reading are unusable;
+  // drop the affected leading buckets.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint32_t now_count = g_history_count.load(std::memory_order_relaxed);
+  uint32_t safe_first = now_count >= capacity ? now_count - capacity + 1 : 0;
+  uint16_t skip = 0;
+  if (safe_first > first) {
+    skip = static_cast<uint16_t>(std::min<uint32_t>((safe_first - first + per_bucket - 1) / per_bucket, buckets));
+    for (uint16_t i = skip; i < buckets; ++i) {
+      out_buckets[i - skip] = out_buckets[i];
+    }
+  }
+
+  out_range.t0_ms = t0_ms + (first + skip * per_bucket) * CONTROL_PERIOD_MS;
+  out_range.bucket_ms = per_bucket * CONTROL_PERIOD_MS;
+  out_range.ticks = ticks > skip * per_bucket ? ticks - skip * per_bucket : 0;
+  return buckets - skip;
+}
@@ -1,273 +1,1050 @@
 #include "web_api.h"
 #include "app_config.h"
+#include "arena.h"
 #include "control.h"
+#include "hal.h"
+#include "json_writer.h"
+#include "log.h"
+#include "metrics.h"
 #include "profile.h"
+#include "profile_parser.h"
+#include "profile_store.h"
+#include "runlog.h"
+#include "status_json.h"
 #include "storage.h"
+#include "telemetry.h"
+#include "web_assets.h"
 #include <FS.h>
 #include <LittleFS.h>
-#include <WiFi.h>
-#include <WebServer.h>
-#include <ESPmDNS.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
-
-#if __has_include("secrets.h")
-#include "secrets.h"
-#endif
+#include <esp_heap_caps.h>
+#include <freertos/semphr.h>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
 
 namespace {
-WebServer g_server(80);
-bool g_server_started = false;
-
-const char *stateName(RunState state) {
-  switch (state) {
-    case RunState::IDLE:
-      return "IDLE";
-    case RunState::RUNNING:
-      return "RUNNING";
-    case RunState::SWITCH_DISABLED:
-      return "DISABLED";
-    case RunState::FAULT:
-      return "ERROR";
-    default:
-      return "UNKNOWN";
-  }
-}
-
-void handleStatus() {
-  ControlStatus status{};
-  controlGetStatus(status);
-
-  String json = "{";
-  json += "\"ok\":true,";
-  json += "\"data\":{";
-  json += "\"state\":\"";
-  json += stateName(status.state);
-  json += "\",";
-  json += "\"t_meas\":";
-  json += String(status.t_meas_c, 2);
-  json += ",";
-  json += "\"t_set\":";
-  json += String(status.t_set_c, 2);
-  json += ",";
-  json += "\"duty\":";
-  json += String(status.duty, 3);
-  json += ",";
-  json += "\"delta\":";
-  json += String(status.t_set_c - status.t_meas_c, 2);
-  json += ",";
-  json += "\"run_switch\":";
-  json += status.run_switch_enabled ? "true" : "false";
-  json += ",";
-  json += "\"active_profile\":";
-  json += "\"";
-  json += profileGetActiveName();
-  json += "\"";
-  json += ",";
-  json += "\"fault\":";
-  json += String(status.last_fault);
-  json += "}}";
-  g_server.send(200, "application/json", json);
-}
-
-void handleRun() {
-  if (g_server.hasArg("plain")) {
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, g_server.arg("plain"));
-    if (err) {
-      g_server.send(400, "application/json", "{\"ok\":false,\"error\":\"BAD_JSON\"}");
-      return;
+// Handlers run on the AsyncTCP task (pinned to core 0), so one connection
+// never waits for another's file transfer.
+AsyncWebServer g_server(80);
+AsyncEventSource g_events("/api/events");
+std::atomic<bool> g_server_started{false};
+
+// Server-sent events: every client shares one delta chain, so a client whose
+// send queue backs up is dropped (EventSource reconnects and starts again
+// from a keyframe).
+constexpr uint8_t kMaxEventClients = 4;
+constexpr uint32_t kEventKeyframeTicks = 25;
+constexpr size_t kEventBufferSize = 1024;
+constexpr size_t kEventMaxQueued = 4;
+constexpr uint32_t kEventRetryMs = 2000;
+
+// g_event_lock guards the client table and the last frame; it is taken by the
+// web task (pumpEvents) and the AsyncTCP task (connect/disconnect).
+SemaphoreHandle_t g_event_lock = nullptr;
+AsyncEventSourceClient *g_event_clients[kMaxEventClients] = {};
+TelemetryFrame g_event_last{};
+char g_event_last_profile[kMaxProfileNameLength + 1] = "";
+uint32_t g_event_keyframe_seq = 0;
+char g_event_buf[kEventBufferSize];
+
+void lockEvents() {
+  uint32_t start_us = halMicros();
+  xSemaphoreTakeRecursive(g_event_lock, portMAX_DELAY);
+  metricsObserve(Metric::LOCK_EVENTS, halMicros() - start_us);
+}
+
+// Records a handler's run time (not the response transfer) under M.
+template <void (*Handler)(AsyncWebServerRequest *), Metric M>
+void timed(AsyncWebServerRequest *request) {
+  MetricTimer timer(M);
+  Handler(request);
+}
+
+void sendJson(AsyncWebServerRequest *request, int code, const char *json) {
+  request->send(code, "application/json", json);
+}
+
+// Request memory. ZERO_HEAP builds keep the handlers off the heap: their
+// JsonDocuments share one arena, reset as each document is created (handlers
+// run one at a time on the AsyncTCP task and none keeps a document past its
+// return), and state that outlives a handler comes from fixed slots
+// (requestState()).
+alignas(8) uint8_t g_json_arena_buf[ZERO_HEAP ? WEB_JSON_ARENA_BYTES : 8];
+Arena g_json_arena(g_json_arena_buf, sizeof(g_json_arena_buf));
+uint32_t g_slot_busy = 0;
+// 503 body when a request's state or body buffer could not be had.
+const char *const kNoStateJson =
+    ZERO_HEAP ? "{\"ok\":false,\"error\":\"BUSY\"}" : "{\"ok\":false,\"error\":\"NO_MEMORY\"}";
+
+class RequestAllocator : public ArduinoJson::Allocator {
+public:
+  void *allocate(size_t size) override { return ZERO_HEAP ? g_json_arena.allocate(size) : malloc(size); }
+  void deallocate(void *ptr) override {
+    if (ZERO_HEAP) {
+      g_json_arena.deallocate(ptr);
+    } else {
+      free(ptr);
     }
-    if (doc["profile_id"]) {
-      String name = doc["profile_id"].as<String>();
-      if (!profileStartRun(name)) {
-        g_server.send(404, "application/json", "{\"ok\":false,\"error\":\"PROFILE_NOT_FOUND\"}");
-        return;
+  }
+  void *reallocate(void *ptr, size_t size) override {
+    return ZERO_HEAP ? g_json_arena.reallocate(ptr, size) : realloc(ptr, size);
+  }
+};
+
+RequestAllocator g_request_allocator;
+
+// For a handler's `JsonDocument doc(requestAllocator());`.
+ArduinoJson::Allocator *requestAllocator() {
+  g_json_arena.reset();
+  return &g_request_allocator;
+}
+
+// State that outlives the handler (download position, POST body, upload
+// parser), kept in request->_tempObject: from Slots fixed slots in ZERO_HEAP
+// builds, nullptr while all are in use; from the heap otherwise. It is
+// destroyed by the request's onDisconnect, which the server runs once, after
+// the response's last filler call and before it deletes the request, and
+// _tempObject is cleared there so the server does not free() it as well.
+// A request holds one at most and then sets no other onDisconnect. Fillers
+// and this callback capture one pointer, which std::function keeps inline.
+template <typename T, uint8_t Slots>
+T *requestState(AsyncWebServerRequest *request) {
+  T *state = nullptr;
+  if constexpr (ZERO_HEAP) {
+    static SlotPool<T, Slots> pool;
+    state = pool.acquire();
+    if (!state) {
+      g_slot_busy++;
+      return nullptr;
+    }
+    request->onDisconnect([request]() {
+      pool.release(static_cast<T *>(request->_tempObject));
+      request->_tempObject = nullptr;
+    });
+  } else {
+    state = new (std::nothrow) T();
+    if (!state) {
+      return nullptr;
+    }
+    request->onDisconnect([request]() {
+      delete static_cast<T *>(request->_tempObject);
+      request->_tempObject = nullptr;
+    });
+  }
+  request->_tempObject = state;
+  return state;
+}
+
+// Fixed-point views used to decide whether a field changed at the precision
+// the UI shows.
+bool changed(float a, float b, float scale) {
+  if (isnan(a) || isnan(b)) {
+    return isnan(a) != isnan(b);
+  }
+  return lroundf(a * scale) != lroundf(b * scale);
+}
+
+// /api/status body, rendered at most once per control tick (generation =
+// telemetry seq) and shared by every request in that tick. Responses read the
+// slot lazily while TCP drains, so each one counts itself as a reader until
+// its request's onDisconnect (the last callback the server runs for it), and
+// a new tick is rendered only into a slot with no readers. AsyncTCP task only.
+constexpr uint8_t kStatusSlots = 4;
+constexpr size_t kStatusBufferSize = 1280;
+
+struct StatusSlot {
+  char body[kStatusBufferSize];
+  size_t len = 0;
+  uint8_t readers = 0;
+};
+
+StatusSlot g_status_slots[kStatusSlots];
+uint8_t g_status_slot = 0;
+uint32_t g_status_generation = 0;
+uint32_t g_status_name_version = 0;
+char g_status_profile[MAX_ZONES][kMaxProfileNameLength + 1];
+
+// nullptr when the tick is new and every slot is still being sent.
+StatusSlot *renderStatus() {
+  TelemetryFrame frame;
+  bool have_frame = telemetryLatest(frame);
+  uint32_t name_version = profileActiveNameVersion();
+  StatusSlot &current = g_status_slots[g_status_slot];
+  if (have_frame && frame.seq == g_status_generation && name_version == g_status_name_version &&
+      current.len > 0) {
+    return &current;
+  }
+  uint8_t next = g_status_slot;
+  do {
+    next = (next + 1) % kStatusSlots;
+  } while (g_status_slots[next].readers > 0 && next != g_status_slot);
+  if (g_status_slots[next].readers > 0) {
+    return nullptr;
+  }
+  if (!have_frame) {
+    frame.seq = 0;
+    controlGetStatus(frame.status);
+  }
+  if (name_version != g_status_name_version) {
+    // Keep the version seen before the first copy, so a rename racing the
+    // loop is picked up on the next request.
+    g_status_name_version = profileCopyActiveName(0, g_status_profile[0], sizeof(g_status_profile[0]));
+    for (uint8_t z = 1; z < MAX_ZONES; ++z) {
+      profileCopyActiveName(z, g_status_profile[z], sizeof(g_status_profile[z]));
+    }
+  }
+
+  g_status_slot = next;
+  StatusSlot &slot = g_status_slots[g_status_slot];
+  ControlTiming timing;
+  controlGetTiming(timing);
+  slot.len = statusRenderJson(slot.body, sizeof(slot.body), frame.seq, frame.status, timing, g_status_profile);
+  g_status_generation = frame.seq;
+  return &slot;
+}
+
+void handleStatus(AsyncWebServerRequest *request) {
+  StatusSlot *slot = renderStatus();
+  if (!slot) {
+    sendJson(request, 503, "{\"ok\":false,\"error\":\"BUSY\"}");
+    return;
+  }
+  if (slot->len == 0) {
+    sendJson(request, 500, "{\"ok\":false,\"error\":\"STATUS_OVERFLOW\"}");
+    return;
+  }
+  slot->readers++;
+  request->onDisconnect([slot]() { slot->readers--; });
+  request->send(request->beginResponse(200, "application/json",
+                                       reinterpret_cast<const uint8_t *>(slot->body), slot->len));
+}
+
+// Encodes frame as SSE data. With prev == nullptr a full "status" keyframe
+// is written, otherwise a "delta" with only the changed fields.
+size_t encodeEvent(char *buf, size_t cap, const TelemetryFrame &frame, const char *profile,
+                   const TelemetryFrame *prev, const char *prev_profile) {
+  const ControlStatus &s = frame.status;
+  const ControlStatus *p = prev ? &prev->status : nullptr;
+  JsonWriter out(buf, cap);
+  out.beginObject();
+  out.field("seq", frame.seq);
+  out.field("t_ms", frame.t_ms);
+  if (!p || s.state != p->state) out.field("state", runStateName(s.state));
+  if (!p || changed(s.t_meas_c[0], p->t_meas_c[0], 100.0f)) out.field("t_meas", s.t_meas_c[0], 2);
+  if (!p || changed(s.t_set_c[0], p->t_set_c[0], 100.0f)) out.field("t_set", s.t_set_c[0], 2);
+  float delta = s.t_set_c[0] - s.t_meas_c[0];
+  if (!p || changed(delta, p->t_set_c[0] - p->t_meas_c[0], 100.0f)) out.field("delta", delta, 2);
+  if (!p || changed(s.duty[0], p->duty[0], 1000.0f)) out.field("duty", s.duty[0], 3);
+  if (!p || s.run_switch_enabled != p->run_switch_enabled) out.field("run_switch", s.run_switch_enabled);
+  if (!p || strcmp(profile, prev_profile) != 0) out.field("active_profile", profile);
+  if (!p || s.last_fault != p->last_fault) out.field("fault", static_cast<uint32_t>(s.last_fault));
+  // Zones go out as one array whenever any of them changed; the top-level
+  // fields above mirror zone 0.
+  bool zones_changed = !p || s.zone_count != p->zone_count;
+  for (uint8_t z = 0; !zones_changed && z < s.zone_count; ++z) {
+    zones_changed = changed(s.t_meas_c[z], p->t_meas_c[z], 100.0f) ||
+                    changed(s.t_set_c[z], p->t_set_c[z], 100.0f) ||
+                    changed(s.duty[z], p->duty[z], 1000.0f) || s.zone_fault[z] != p->zone_fault[z];
+  }
+  if (s.zone_count > 1 && zones_changed) {
+    out.beginArray("zones");
+    for (uint8_t z = 0; z < s.zone_count; ++z) {
+      out.beginObject();
+      out.field("t_meas", s.t_meas_c[z], 2);
+      out.field("t_set", s.t_set_c[z], 2);
+      out.field("duty", s.duty[z], 3);
+      out.field("fault", static_cast<uint32_t>(s.zone_fault[z]));
+      out.endObject();
+    }
+    out.endArray();
+  }
+  out.endObject();
+  return out.length();
+}
+
+void onEventConnect(AsyncEventSourceClient *client) {
+  lockEvents();
+  uint8_t slot = kMaxEventClients;
+  for (uint8_t i = 0; i < kMaxEventClients; ++i) {
+    if (!g_event_clients[i]) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot == kMaxEventClients) {
+    xSemaphoreGiveRecursive(g_event_lock);
+    client->close();
+    return;
+  }
+  g_event_clients[slot] = client;
+  if (g_event_last.seq != 0) {
+    char buf[kEventBufferSize];
+    size_t len = encodeEvent(buf, sizeof(buf), g_event_last, g_event_last_profile, nullptr, nullptr);
+    if (len > 0) {
+      client->send(buf, "status", g_event_last.seq, kEventRetryMs);
+    }
+  }
+  xSemaphoreGiveRecursive(g_event_lock);
+}
+
+void onEventDisconnect(AsyncEventSourceClient *client) {
+  lockEvents();
+  for (uint8_t i = 0; i < kMaxEventClients; ++i) {
+    if (g_event_clients[i] == client) {
+      g_event_clients[i] = nullptr;
+    }
+  }
+  xSemaphoreGiveRecursive(g_event_lock);
+}
+
+// Called from the web task: encodes a new tick once and fans it out.
+void pumpEvents() {
+  TelemetryFrame frame;
+  if (!telemetryLatest(frame) || frame.seq == g_event_last.seq) {
+    return;
+  }
+  char profile[kMaxProfileNameLength + 1];
+  profileCopyActiveName(0, profile, sizeof(profile));
+
+  lockEvents();
+  bool any_client = false;
+  for (uint8_t i = 0; i < kMaxEventClients; ++i) {
+    any_client = any_client || g_event_clients[i];
+  }
+  if (any_client) {
+    bool keyframe = g_event_last.seq == 0 || frame.seq - g_event_keyframe_seq >= kEventKeyframeTicks;
+    size_t len = keyframe ? encodeEvent(g_event_buf, sizeof(g_event_buf), frame, profile, nullptr, nullptr)
+                          : encodeEvent(g_event_buf, sizeof(g_event_buf), frame, profile, &g_event_last,
+                                        g_event_last_profile);
+    if (keyframe) {
+      g_event_keyframe_seq = frame.seq;
+    }
+    for (uint8_t i = 0; i < kMaxEventClients; ++i) {
+      AsyncEventSourceClient *client = g_event_clients[i];
+      if (!client) {
+        continue;
+      }
+      if (len == 0 || client->packetsWaiting() >= kEventMaxQueued) {
+        g_event_clients[i] = nullptr;
+        client->close();
+        continue;
       }
+      client->send(g_event_buf, keyframe ? "status" : "delta", frame.seq);
     }
   }
-  bool ok = controlTryStartRun();
-  g_server.send(ok ? 200 : 409, "application/json", ok ? "{\"ok\":true}" : "{\"ok\":false}");
+  g_event_last = frame;
+  strlcpy(g_event_last_profile, profile, sizeof(g_event_last_profile));
+  xSemaphoreGiveRecursive(g_event_lock);
 }
 
-void handleStop() {
-  controlStopRun();
-  g_server.send(200, "application/json", "{\"ok\":true}");
-}
-
-void handleNotFound() {
-  String uri = g_server.uri();
-  if (LittleFS.exists(uri)) {
-    String content_type = "text/plain";
-    if (uri.endsWith(".html")) content_type = "text/html";
-    else if (uri.endsWith(".css")) content_type = "text/css";
-    else if (uri.endsWith(".js")) content_type = "application/javascript";
-    else if (uri.endsWith(".json")) content_type = "application/json";
-    g_server.send(LittleFS, uri, content_type);
+// ZERO_HEAP streams hold buckets for the largest query; others size them to
+// the query on the heap.
+using HistoryBuckets =
+    std::conditional<ZERO_HEAP, HistoryBucket[HISTORY_MAX_POINTS], std::unique_ptr<HistoryBucket[]>>::type;
+
+template <typename Buckets>
+HistoryBucket *allocBuckets(Buckets &buckets, uint32_t points) {
+  if constexpr (ZERO_HEAP) {
+    (void)points;
+    return buckets;
+  } else {
+    buckets.reset(new (std::nothrow) HistoryBucket[points]);
+    return buckets.get();
+  }
+}
+
+// Columnar history body, produced piecewise by the chunked response filler.
+// Each request owns its buckets, so concurrent downloads do not interfere.
+struct HistoryStream {
+  HistoryBuckets buckets;
+  HistoryRange range{};
+  uint16_t count = 0;
+  uint8_t column = 0;   // 0 header, 1..kHistoryColumns, then trailer
+  uint16_t token = 0;   // within a column: 0 name, 1..count values, count + 1 "]"
+  char pending[40];
+  size_t pending_len = 0;
+  size_t pending_off = 0;
+  bool done = false;
+};
+
+constexpr uint8_t kHistoryColumns = 6;
+constexpr const char *kHistoryColumnNames[kHistoryColumns] = {
+    "t_meas_min", "t_meas_max", "t_set", "duty", "state", "fault"};
+
+int formatHistoryTemp(char *out, size_t cap, const char *sep, int16_t value) {
+  if (value == kHistoryTempInvalid) {
+    return snprintf(out, cap, "%snull", sep);
+  }
+  return snprintf(out, cap, "%s%.1f", sep, historyTempToC(value));
+}
+
+int formatHistoryValue(char *out, size_t cap, uint8_t column, uint16_t i, const HistoryBucket &b) {
+  const char *sep = i == 0 ? "" : ",";
+  switch (column) {
+    case 1: return formatHistoryTemp(out, cap, sep, b.t_meas_min);
+    case 2: return formatHistoryTemp(out, cap, sep, b.t_meas_max);
+    case 3: return formatHistoryTemp(out, cap, sep, b.t_set);
+    case 4: return snprintf(out, cap, "%s%u", sep, b.duty);
+    case 5: return snprintf(out, cap, "%s%u", sep, b.state);
+    default: return snprintf(out, cap, "%s%u", sep, b.fault);
+  }
+}
+
+// Renders the next token into stream.pending; false once the body is complete.
+bool nextHistoryToken(HistoryStream &stream) {
+  char *out = stream.pending;
+  size_t cap = sizeof(stream.pending);
+  int n = 0;
+  if (stream.column == 0) {
+    n = snprintf(out, cap, "{\"ok\":true,\"data\":{\"t0\":%lu,\"dt\":%lu,\"count\":%u",
+                 static_cast<unsigned long>(stream.range.t0_ms),
+                 static_cast<unsigned long>(stream.range.bucket_ms), stream.count);
+    stream.column = 1;
+  } else if (stream.column <= kHistoryColumns) {
+    if (stream.token == 0) {
+      n = snprintf(out, cap, ",\"%s\":[", kHistoryColumnNames[stream.column - 1]);
+    } else if (stream.token <= stream.count) {
+      uint16_t i = stream.token - 1;
+      n = formatHistoryValue(out, cap, stream.column, i, stream.buckets[i]);
+    } else {
+      n = snprintf(out, cap, "]");
+    }
+    if (++stream.token > stream.count + 1) {
+      stream.token = 0;
+      stream.column++;
+    }
+  } else if (!stream.done) {
+    n = snprintf(out, cap, "}}");
+    stream.done = true;
+  } else {
+    return false;
+  }
+  stream.pending_len = n > 0 ? min(static_cast<size_t>(n), cap - 1) : 0;
+  stream.pending_off = 0;
+  return true;
+}
+
+// Chunked-response filler for streams that render one token at a time into
+// stream.pending; Next returns false once the body is complete.
+template <typename Stream, bool (*Next)(Stream &)>
+size_t fillChunk(Stream &stream, uint8_t *buf, size_t max_len) {
+  size_t len = 0;
+  while (len < max_len) {
+    if (stream.pending_off == stream.pending_len && !Next(stream)) {
+      break;
+    }
+    size_t take = min(stream.pending_len - stream.pending_off, max_len - len);
+    memcpy(buf + len, stream.pending + stream.pending_off, take);
+    stream.pending_off += take;
+    len += take;
+  }
+  return len;
+}
+
+uint32_t argU32(AsyncWebServerRequest *request, const char *name, uint32_t fallback) {
+  const AsyncWebParameter *param = request->getParam(name);
+  return param ? strtoul(param->value().c_str(), nullptr, 10) : fallback;
+}
+
+// GET /api/history?zone=&from=&to=&points= (uptime ms, bucket count).
+// Columnar JSON: bucket i starts at t0 + i * dt.
+void handleHistory(AsyncWebServerRequest *request) {
+  uint32_t zone = argU32(request, "zone", 0);
+  if (zone >= halZoneCount()) {
+    sendJson(request, 400, "{\"ok\":false,\"error\":\"BAD_ZONE\"}");
+    return;
+  }
+  uint32_t from_ms = argU32(request, "from", 0);
+  uint32_t to_ms = argU32(request, "to", UINT32_MAX);
+  uint32_t points = argU32(request, "points", HISTORY_DEFAULT_POINTS);
+  if (points == 0 || points > HISTORY_MAX_POINTS) {
+    points = HISTORY_MAX_POINTS;
+  }
+
+  HistoryStream *stream = requestState<HistoryStream, WEB_STREAM_SLOTS>(request);
+  if (!stream) {
+    sendJson(request, 503, "{\"ok\":false,\"error\":\"BUSY\"}");
+    return;
+  }
+  HistoryBucket *buckets = allocBuckets(stream->buckets, points);
+  if (!buckets) {
+    sendJson(request, 503, "{\"ok\":false,\"error\":\"NO_MEMORY\"}");
     return;
   }
-  if (uri.startsWith("/api/profiles/")) {
-    String name = uri.substring(strlen("/api/profiles/"));
-    if (name.isEmpty()) {
-      g_server.send(400, "application/json", "{\"ok\":false,\"error\":\"PROFILE_ID_REQUIRED\"}");
+  stream->count = telemetryHistoryQuery(static_cast<uint8_t>(zone), from_ms, to_ms, static_cast<uint16_t>(points), buckets,
+                                        stream->range);
+  request->send(request->beginChunkedResponse(
+      "application/json", [stream](uint8_t *buf, size_t max_len, size_t index) -> size_t {
+        (void)index;
+        return fillChunk<HistoryStream, nextHistoryToken>(*stream, buf, max_len);
+      }));
+}
+
+// POST body of a ZERO_HEAP build, in a fixed slot.
+struct RequestBody {
+  char text[WEB_MAX_BODY_BYTES + 1];
+};
+
+// Collects a request body into request->_tempObject: a RequestBody slot in
+// ZERO_HEAP builds, else a buffer of its size that the server frees.
+void collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (total > WEB_MAX_BODY_BYTES) {
+    return;
+  }
+  if (index == 0 && !request->_tempObject) {
+    if constexpr (ZERO_HEAP) {
+      requestState<RequestBody, WEB_BODY_SLOTS>(request);
+    } else {
+      request->_tempObject = malloc(total + 1);
+    }
+  }
+  char *body = static_cast<char *>(request->_tempObject);
+  if (!body || index + len > total) {
+    return;
+  }
+  memcpy(body + index, data, len);
+  if (index + len == total) {
+    body[total] = '\0';
+  }
+}
+
+// Returns the buffered body, or nullptr (with a response sent) when it was
+// missing, too large or found no buffer.
+const char *requestBody(AsyncWebServerRequest *request, bool required) {
+  if (request->contentLength() > WEB_MAX_BODY_BYTES) {
+    sendJson(request, 413, "{\"ok\":false,\"error\":\"BODY_TOO_LARGE\"}");
+    return nullptr;
+  }
+  if (!request->_tempObject) {
+    if (request->contentLength() > 0) {
+      sendJson(request, 503, kNoStateJson);
+    } else if (required) {
+      sendJson(request, 400, "{\"ok\":false,\"error\":\"BODY_REQUIRED\"}");
+    }
+    return nullptr;
+  }
+  return static_cast<const char *>(request->_tempObject);
+}
+
+// Parses a buffered body into doc; false (with a response sent) when it is
+// not JSON or does not fit the document's memory.
+bool parseBody(AsyncWebServerRequest *request, const char *body, JsonDocument &doc) {
+  DeserializationError err = deserializeJson(doc, body);
+  if (err == DeserializationError::NoMemory) {
+    sendJson(request, 413, "{\"ok\":false,\"error\":\"BODY_TOO_LARGE\"}");
+    return false;
+  }
+  if (err) {
+    sendJson(request, 400, "{\"ok\":false,\"error\":\"BAD_JSON\"}");
+    return false;
+  }
+  return true;
+}
+
+void handleRun(AsyncWebServerRequest *request) {
+  if (request->contentLength() > 0) {
+    const char *body = requestBody(request, true);
+    if (!body) {
       return;
     }
-    if (g_server.method() == HTTP_GET) {
-      Profile profile{};
-      if (!profileGet(name, profile)) {
-        g_server.send(404, "application/json", "{\"ok\":false,\"error\":\"PROFILE_NOT_FOUND\"}");
+    JsonDocument doc(requestAllocator());
+    if (!parseBody(request, body, doc)) {
+      return;
+    }
+    // "profile_id" runs one profile on every zone; "zones" names one per
+    // zone (zone 0 first) and overrides it.
+    uint8_t zones = halZoneCount();
+    // Names point into doc.
+    const char *names[MAX_ZONES] = {};
+    bool any = false;
+    if (doc["profile_id"]) {
+      const char *name = doc["profile_id"] | "";
+      for (uint8_t z = 0; z < zones; ++z) {
+        names[z] = name;
+      }
+      any = true;
+    }
+    JsonArrayConst list = doc["zones"].as<JsonArrayConst>();
+    if (!list.isNull()) {
+      if (list.size() != zones) {
+        sendJson(request, 400, "{\"ok\":false,\"error\":\"ZONE_COUNT_MISMATCH\"}");
         return;
       }
-      JsonDocument doc;
-      doc["name"] = profile.name;
-      doc["end_behavior"] = profile.end_behavior == EndBehavior::STOP ? "stop" : "hold_last";
-      JsonArray points = doc["points"].to<JsonArray>();
-      for (uint8_t i = 0; i < profile.count; ++i) {
-        JsonObject point = points.add<JsonObject>();
-        point["t_sec"] = profile.points[i].t_sec;
-        point["temp_c"] = profile.points[i].temp_c;
+      uint8_t z = 0;
+      for (JsonVariantConst name : list) {
+        names[z++] = name | "";
       }
-      String payload;
-      serializeJson(doc, payload);
-      g_server.send(200, "application/json", payload);
-      return;
+      any = true;
     }
-    if (g_server.method() == HTTP_DELETE) {
-      if (!profileDelete(name)) {
-        g_server.send(404, "application/json", "{\"ok\":false,\"error\":\"PROFILE_NOT_FOUND\"}");
+    for (uint8_t z = 0; any && z < zones; ++z) {
+      if (!profileStartRun(z, names[z])) {
+        profileClearActive();
+        sendJson(request, 404, "{\"ok\":false,\"error\":\"PROFILE_NOT_FOUND\"}");
         return;
       }
-      storageSaveProfiles();
-      g_server.send(200, "application/json", "{\"ok\":true}");
-      return;
     }
   }
-  g_server.send(404, "application/json", "{\"ok\":false,\"error\":\"NOT_FOUND\"}");
+  bool ok = controlTryStartRun();
+  sendJson(request, ok ? 200 : 409, ok ? "{\"ok\":true}" : "{\"ok\":false}");
+}
+
+void handleStop(AsyncWebServerRequest *request) {
+  controlStopRun();
+  sendJson(request, 200, "{\"ok\":true}");
+}
+
+// GET /api/profiles/{id} and GET /api/profiles bodies, rendered from the
+// store as the response drains: points are read a page at a time, so
+// memory does not grow with the profile or the number of profiles.
+struct ProfileStream {
+  bool list = false;
+  ProfileInfo info{};  // item: the profile
+  uint16_t next = 0;   // next point (item) or index entry (list)
+  uint8_t stage = 0;   // 0 head, 1 elements, 2 done
+  ProfilePoint page[PROFILE_PAGE_POINTS];
+  uint16_t page_first = 0;
+  uint16_t page_count = 0;
+  char pending[224];   // an escaped 31-character name fits
+  size_t pending_len = 0;
+  size_t pending_off = 0;
+};
+
+bool nextProfileToken(ProfileStream &stream) {
+  char *out = stream.pending;
+  size_t cap = sizeof(stream.pending);
+  size_t len = 0;
+  uint16_t total = stream.list ? profileStoreCount() : stream.info.count;
+  if (stream.stage == 0) {
+    JsonWriter head(out, cap);
+    if (stream.list) {
+      head.raw("{\"profiles\":[");
+    } else {
+      head.beginObject();
+      head.field("name", stream.info.name);
+      head.field("end_behavior", profileEndBehaviorName(stream.info.end_behavior));
+      head.raw(",\"points\":[");
+    }
+    len = head.length();
+    stream.stage = 1;
+  } else if (stream.stage == 1 && stream.next < total) {
+    const char *sep = stream.next == 0 ? "" : ",";
+    if (stream.list) {
+      ProfileInfo info;
+      if (!profileStoreInfoAt(stream.next, info)) {
+        return false;
+      }
+      JsonWriter item(out, cap);
+      item.raw(sep);
+      item.beginObject();
+      item.field("name", info.name);
+      item.field("points", static_cast<uint32_t>(info.count));
+      item.field("end_behavior", profileEndBehaviorName(info.end_behavior));
+      item.endObject();
+      len = item.length();
+    } else {
+      if (stream.next >= stream.page_first + stream.page_count) {
+        // Fails if a rewrite moved the points since the header was read:
+        // the body ends short (invalid JSON) rather than mixing versions.
+        uint16_t n = min<uint16_t>(PROFILE_PAGE_POINTS, total - stream.next);
+        if (!profileStoreReadPoints(stream.info, stream.next, stream.page, n)) {
+          return false;
+        }
+        stream.page_first = stream.next;
+        stream.page_count = n;
+      }
+      const ProfilePoint &point = stream.page[stream.next - stream.page_first];
+      int n = snprintf(out, cap, "%s{\"t_sec\":%lu,\"temp_c\":%.7g}", sep,
+                       static_cast<unsigned long>(point.t_sec), point.temp_c);
+      len = n > 0 ? min(static_cast<size_t>(n), cap - 1) : 0;
+    }
+    stream.next++;
+  } else if (stream.stage == 1) {
+    len = strlcpy(out, "]}", cap);
+    stream.stage = 2;
+  } else {
+    return false;
+  }
+  stream.pending_len = len;
+  stream.pending_off = 0;
+  return true;
 }
 
-void handleProfilesList() {
-  String payload;
-  profileList(payload);
-  g_server.send(200, "application/json", payload);
+void sendProfileStream(AsyncWebServerRequest *request, ProfileStream *stream) {
+  request->send(request->beginChunkedResponse(
+      "application/json", [stream](uint8_t *buf, size_t max_len, size_t index) -> size_t {
+        (void)index;
+        return fillChunk<ProfileStream, nextProfileToken>(*stream, buf, max_len);
+      }));
 }
 
-void handleProfilesUpsert() {
-  if (!g_server.hasArg("plain")) {
-    g_server.send(400, "application/json", "{\"ok\":false,\"error\":\"BODY_REQUIRED\"}");
+// GET/DELETE /api/profiles/{id}
+void handleProfileItem(AsyncWebServerRequest *request) {
+  const char *name = request->url().c_str() + strlen("/api/profiles/");
+  if (*name == '\0') {
+    sendJson(request, 400, "{\"ok\":false,\"error\":\"PROFILE_ID_REQUIRED\"}");
     return;
   }
-  JsonDocument doc;
-  DeserializationError err = deserializeJson(doc, g_server.arg("plain"));
-  if (err) {
-    g_server.send(400, "application/json", "{\"ok\":false,\"error\":\"BAD_JSON\"}");
+  if (request->method() == HTTP_GET) {
+    ProfileStream *stream = requestState<ProfileStream, WEB_STREAM_SLOTS>(request);
+    if (!stream) {
+      sendJson(request, 503, "{\"ok\":false,\"error\":\"BUSY\"}");
+      return;
+    }
+    if (!profileStoreFind(name, stream->info)) {
+      sendJson(request, 404, "{\"ok\":false,\"error\":\"PROFILE_NOT_FOUND\"}");
+      return;
+    }
+    sendProfileStream(request, stream);
     return;
   }
-  Profile profile{};
-  profile.name = doc["name"].as<String>();
-  String end_behavior = doc["end_behavior"] | "hold_last";
-  if (end_behavior == "stop") {
-    profile.end_behavior = EndBehavior::STOP;
+  if (!profileDelete(name)) {
+    sendJson(request, 404, "{\"ok\":false,\"error\":\"PROFILE_NOT_FOUND\"}");
+    return;
   }
-  JsonArray points = doc["points"].as<JsonArray>();
-  if (points.isNull()) {
-    g_server.send(400, "application/json", "{\"ok\":false,\"error\":\"POINTS_REQUIRED\"}");
+  sendJson(request, 200, "{\"ok\":true}");
+}
+
+// GET /api/runs/{id}: raw run log download.
+void handleRunDownload(AsyncWebServerRequest *request) {
+  const char *id = request->url().c_str() + strlen("/api/runs/");
+  uint32_t run_id = strtoul(id, nullptr, 10);
+  char path[kRunlogPathSize];
+  runlogPath(run_id, path, sizeof(path));
+  if (*id == '\0' || !LittleFS.exists(path)) {
+    sendJson(request, 404, "{\"ok\":false,\"error\":\"RUN_NOT_FOUND\"}");
     return;
   }
-  uint8_t count = 0;
-  for (JsonObject point : points) {
-    if (count >= 32) {
-      break;
+  char disposition[48];
+  snprintf(disposition, sizeof(disposition), "attachment; filename=run-%lu.bin", static_cast<unsigned long>(run_id));
+  AsyncWebServerResponse *response = request->beginResponse(LittleFS, path, "application/octet-stream");
+  response->addHeader("Content-Disposition", disposition);
+  request->send(response);
+}
+
+// Serves manifest assets: gzip body, strong ETag, 304 on If-None-Match.
+// Browsers revalidate on each load (no-cache), which costs one round trip
+// and no body once the asset is cached.
+class AssetHandler : public AsyncWebHandler {
+public:
+  bool canHandle(AsyncWebServerRequest *request) const override {
+    return request->method() == HTTP_GET && webAssetFind(request->url().c_str()) != nullptr;
+  }
+
+  void handleRequest(AsyncWebServerRequest *request) override {
+    MetricTimer timer(Metric::HTTP_ASSET);
+    const WebAsset *asset = webAssetFind(request->url().c_str());
+    if (!asset) {
+      request->send(404);
+      return;
+    }
+    const AsyncWebHeader *match = request->getHeader("If-None-Match");
+    AsyncWebServerResponse *response;
+    if (match && (match->value() == "*" || match->value().indexOf(asset->etag) >= 0)) {
+      response = request->beginResponse(304);
+    } else {
+      response = request->beginResponse(LittleFS, asset->file, asset->type);
+      response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+  }
+};
+
+AssetHandler g_asset_handler;
+
+void handleNotFound(AsyncWebServerRequest *request) {
+  sendJson(request, 404, "{\"ok\":false,\"error\":\"NOT_FOUND\"}");
+}
+
+// GET /api/metrics: Prometheus text exposition.
+void handleMetrics(AsyncWebServerRequest *request) {
+  AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+  metricsWritePrometheus(*response);
+  request->send(response);
+}
+
+// GET /api/log: levels and drop counters per module.
+// POST /api/log {"levels":{"control":"debug",...}}
+void handleLog(AsyncWebServerRequest *request) {
+  if (request->method() == HTTP_POST) {
+    const char *body = requestBody(request, true);
+    if (!body) {
+      return;
+    }
+    JsonDocument doc(requestAllocator());
+    if (!parseBody(request, body, doc)) {
+      return;
+    }
+    JsonObjectConst levels = doc["levels"].as<JsonObjectConst>();
+    // Validate everything before applying anything.
+    for (JsonPairConst item : levels) {
+      LogModule module;
+      LogLevel level;
+      if (!item.value().is<const char *>() || !logParseModule(item.key().c_str(), module) ||
+          !logParseLevel(item.value().as<const char *>(), level)) {
+        sendJson(request, 400, "{\"ok\":false,\"error\":\"BAD_LOG_LEVEL\"}");
+        return;
+      }
+    }
+    for (JsonPairConst item : levels) {
+      LogModule module;
+      LogLevel level;
+      logParseModule(item.key().c_str(), module);
+      logParseLevel(item.value().as<const char *>(), level);
+      logSetLevel(module, level);
+    }
+  }
+  char buf[512];
+  JsonWriter out(buf, sizeof(buf));
+  out.raw("{\"ok\":true,\"data\":{\"levels\":");
+  out.beginObject();
+  for (uint8_t i = 0; i < static_cast<uint8_t>(LogModule::COUNT); ++i) {
+    LogModule module = static_cast<LogModule>(i);
+    out.field(logModuleName(module), logLevelName(logGetLevel(module)));
+  }
+  out.endObject();
+  out.raw(",\"dropped\":");
+  out.beginObject();
+  for (uint8_t i = 0; i < static_cast<uint8_t>(LogModule::COUNT); ++i) {
+    LogModule module = static_cast<LogModule>(i);
+    out.field(logModuleName(module), logDropped(module));
+  }
+  out.endObject();
+  out.raw("}}");
+  if (out.length() == 0) {
+    sendJson(request, 500, "{\"ok\":false,\"error\":\"OVERFLOW\"}");
+    return;
+  }
+  sendJson(request, 200, buf);
+}
+
+// POST starts a relay autotune (autotune.h) with the body's fields over the
+// AutotuneConfig defaults; GET (and POST) return the last experiment.
+void handleAutotune(AsyncWebServerRequest *request) {
+  if (request->method() == HTTP_POST) {
+    AutotuneConfig config;
+    if (request->contentLength() > 0) {
+      const char *body = requestBody(request, true);
+      if (!body) {
+        return;
+      }
+      JsonDocument doc(requestAllocator());
+      if (!parseBody(request, body, doc)) {
+        return;
+      }
+      config.setpoint_c = doc["setpoint_c"] | config.setpoint_c;
+      config.hysteresis_c = doc["hysteresis_c"] | config.hysteresis_c;
+      config.high_duty = doc["high_duty"] | config.high_duty;
+      config.cycles = doc["cycles"] | config.cycles;
+      config.max_s = doc["max_s"] | config.max_s;
+      config.apply = doc["apply"] | config.apply;
+    }
+    const char *error = nullptr;
+    if (!controlStartAutotune(config, error)) {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "{\"ok\":false,\"error\":\"%s\"}", error);
+      sendJson(request, strcmp(error, "BAD_SETPOINT") == 0 ? 400 : 409, buf);
+      return;
     }
-    profile.points[count].t_sec = point["t_sec"] | 0;
-    profile.points[count].temp_c = point["temp_c"] | 0.0f;
-    count++;
   }
-  profile.count = count;
+  AutotuneState state;
+  controlGetAutotune(state);
+  char buf[384 + MAX_ZONES * 256];
+  JsonWriter out(buf, sizeof(buf));
+  out.raw("{\"ok\":true,\"data\":");
+  out.beginObject();
+  out.field("phase", autotunePhaseName(state.phase));
+  out.field("reason", state.reason);
+  out.field("setpoint_c", state.config.setpoint_c, 1);
+  out.field("hysteresis_c", state.config.hysteresis_c, 2);
+  out.field("high_duty", state.config.high_duty, 2);
+  out.field("cycles", static_cast<uint32_t>(state.config.cycles));
+  out.field("apply", state.config.apply);
+  bool active = state.phase == AutotunePhase::HEATING || state.phase == AutotunePhase::RELAY;
+  out.field("elapsed_ms", active ? halMillis() - state.start_ms : state.end_ms - state.start_ms);
+  out.beginArray("zones");
+  for (uint8_t z = 0; z < state.zone_count; ++z) {
+    const AutotuneZone &zone = state.zones[z];
+    const AutotuneResult &result = zone.result;
+    out.beginObject();
+    out.field("phase", autotunePhaseName(zone.phase));
+    out.field("half_cycles", static_cast<uint32_t>(zone.up_count + zone.down_count));
+    out.field("valid", result.valid);
+    out.field("ku", result.ku, 5);
+    out.field("pu_s", result.pu_s, 1);
+    out.field("amplitude_c", result.amplitude_c, 2);
+    out.field("theta_s", result.theta_s, 2);
+    out.field("tau_s", result.tau_s, 1);
+    out.field("gain_c", result.gain_c, 1);
+    out.field("kp", result.kp, 5);
+    out.field("ki", result.ki, 6);
+    out.field("kd", result.kd, 4);
+    out.field("ff_gain", result.ff_gain, 4);
+    out.field("ff_lead_s", result.ff_lead_s, 1);
+    out.endObject();
+  }
+  out.endArray();
+  out.endObject();
+  out.raw("}");
+  if (out.length() == 0) {
+    sendJson(request, 500, "{\"ok\":false,\"error\":\"OVERFLOW\"}");
+    return;
+  }
+  sendJson(request, 200, buf);
+}
 
-  String error;
-  if (!profileAddOrUpdate(profile, error)) {
-    String payload = "{\"ok\":false,\"error\":\"";
-    payload += error;
-    payload += "\"}";
-    g_server.send(400, "application/json", payload);
+void handleRunsList(AsyncWebServerRequest *request) {
+  JsonDocument doc(requestAllocator());
+  runlogList(doc);
+  if (doc.overflowed()) {
+    sendJson(request, 500, "{\"ok\":false,\"error\":\"OVERFLOW\"}");
     return;
   }
-  storageSaveProfiles();
-  g_server.send(200, "application/json", "{\"ok\":true}");
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  serializeJson(doc, *response);
+  request->send(response);
 }
 
-bool setupMdns() {
-  if (MDNS.begin(MDNS_HOST)) {
-    MDNS.addService("http", "tcp", 80);
-    Serial.print("mDNS: http://");
-    Serial.print(MDNS_HOST);
-    Serial.println(".local/");
-    return true;
+void handleProfilesList(AsyncWebServerRequest *request) {
+  ProfileStream *stream = requestState<ProfileStream, WEB_STREAM_SLOTS>(request);
+  if (!stream) {
+    sendJson(request, 503, "{\"ok\":false,\"error\":\"BUSY\"}");
+    return;
   }
-  Serial.println("mDNS start failed");
-  return false;
+  stream->list = true;
+  sendProfileStream(request, stream);
 }
 
-bool setupWifi() {
-#if defined(WIFI_SSID) && defined(WIFI_PASSWORD)
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+// Profile upload state (requestState()): the body is parsed as it arrives
+// and points go straight to the store's staging file, so memory is fixed no
+// matter how large the upload is.
+struct ProfileUpload {
+  ProfileParser parser;
+  bool too_large = false;
+  // Frees the store session if the client went away mid-upload; a no-op
+  // once the parser has committed or failed.
+  ~ProfileUpload() { profileStoreWriteAbort(parser.session()); }
+};
+
+// Free heap when the last upload started and the lowest seen while it ran.
+std::atomic<uint32_t> g_upload_heap_before{0};
+std::atomic<uint32_t> g_upload_heap_min{0};
 
-  uint32_t start_ms = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - start_ms < 15000) {
-    delay(250);
+void noteUploadHeap() {
+  uint32_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  if (free_bytes < g_upload_heap_min.load()) {
+    g_upload_heap_min.store(free_bytes);
   }
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.print("WiFi connected: ");
-    Serial.println(WiFi.localIP());
-    setupMdns();
-    return true;
+void parseProfileBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (index == 0 && !request->_tempObject) {
+    uint32_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    g_upload_heap_before.store(free_bytes);
+    g_upload_heap_min.store(free_bytes);
+    ProfileUpload *upload = requestState<ProfileUpload, WEB_UPLOAD_SLOTS>(request);
+    if (!upload) {
+      return;
+    }
+    upload->too_large = total > PROFILE_UPLOAD_MAX_BYTES;
+    if (!upload->too_large) {
+      upload->parser.begin();
+    }
   }
-  Serial.println("WiFi connect failed");
-#else
-  Serial.println("WiFi credentials missing. Starting AP mode.");
-#endif
+  ProfileUpload *upload = static_cast<ProfileUpload *>(request->_tempObject);
+  if (!upload || upload->too_large) {
+    return;
+  }
+  upload->parser.feed(reinterpret_cast<const char *>(data), len);
+  noteUploadHeap();
+}
 
-  WiFi.mode(WIFI_AP);
-  bool ok = WiFi.softAP(AP_SSID, AP_PASSWORD);
-  if (ok) {
-    Serial.print("AP started: ");
-    Serial.println(AP_SSID);
-    Serial.print("AP IP: ");
-    Serial.println(WiFi.softAPIP());
-    setupMdns();
-  } else {
-    Serial.println("AP start failed");
+void handleProfilesUpsert(AsyncWebServerRequest *request) {
+  ProfileUpload *upload = static_cast<ProfileUpload *>(request->_tempObject);
+  if (!upload) {
+    bool empty = request->contentLength() == 0;
+    sendJson(request, empty ? 400 : 503, empty ? "{\"ok\":false,\"error\":\"BODY_REQUIRED\"}" : kNoStateJson);
+    return;
+  }
+  if (upload->too_large) {
+    sendJson(request, 413, "{\"ok\":false,\"error\":\"BODY_TOO_LARGE\"}");
+    return;
   }
-  return ok;
+  if (upload->parser.finish()) {
+    noteUploadHeap();
+    sendJson(request, 200, "{\"ok\":true}");
+    return;
+  }
+  const char *error = upload->parser.error();
+  int code = 400;
+  if (strcmp(error, "too_many_points") == 0) {
+    code = 413;
+  } else if (strcmp(error, "upload_busy") == 0) {
+    code = 409;
+  } else if (strcmp(error, "storage_failed") == 0) {
+    code = 500;
+  }
+  char buf[96];
+  JsonWriter out(buf, sizeof(buf));
+  out.beginObject();
+  out.field("ok", false);
+  out.field("error", error);
+  out.field("offset", static_cast<uint32_t>(upload->parser.position()));
+  out.endObject();
+  sendJson(request, code, buf);
 }
 
 void setupServer() {
-  g_server.serveStatic("/", LittleFS, "/index.html");
-  g_server.serveStatic("/index.html", LittleFS, "/index.html");
-  g_server.serveStatic("/styles.css", LittleFS, "/styles.css");
-  g_server.serveStatic("/app.js", LittleFS, "/app.js");
-  g_server.on("/api/status", HTTP_GET, handleStatus);
-  g_server.on("/api/profiles", HTTP_GET, handleProfilesList);
-  g_server.on("/api/profiles", HTTP_POST, handleProfilesUpsert);
-  g_server.on("/api/run", HTTP_POST, handleRun);
-  g_server.on("/api/stop", HTTP_POST, handleStop);
-  g_server.onNotFound(handleNotFound);
+  webAssetsLoad();
+  g_event_lock = xSemaphoreCreateRecursiveMutex();
+  g_events.onConnect(onEventConnect);
+  g_events.onDisconnect(onEventDisconnect);
+  g_server.addHandler(&g_events);
+
+  // Item routes first: a plain "/api/runs" route also matches "/api/runs/...".
+  g_server.on("/api/profiles/*", HTTP_GET | HTTP_DELETE, timed<handleProfileItem, Metric::HTTP_PROFILE_ITEM>);
+  g_server.on("/api/runs/*", HTTP_GET, timed<handleRunDownload, Metric::HTTP_RUN_DOWNLOAD>);
+  g_server.on("/api/status", HTTP_GET, timed<handleStatus, Metric::HTTP_STATUS>);
+  g_server.on("/api/history", HTTP_GET, timed<handleHistory, Metric::HTTP_HISTORY>);
+  g_server.on("/api/metrics", HTTP_GET, timed<handleMetrics, Metric::HTTP_METRICS>);
+  g_server.on("/api/profiles", HTTP_GET, timed<handleProfilesList, Metric::HTTP_PROFILES>);
+  g_server.on("/api/profiles", HTTP_POST, timed<handleProfilesUpsert, Metric::HTTP_PROFILES>, nullptr,
+             parseProfileBody);
+  g_server.on("/api/runs", HTTP_GET, timed<handleRunsList, Metric::HTTP_RUNS>);
+  g_server.on("/api/run", HTTP_POST, timed<handleRun, Metric::HTTP_RUN>, nullptr, collectBody);
+  g_server.on("/api/log", HTTP_GET | HTTP_POST, timed<handleLog, Metric::HTTP_LOG>, nullptr, collectBody);
+  g_server.on("/api/stop", HTTP_POST, timed<handleStop, Metric::HTTP_STOP>);
+  g_server.on("/api/autotune", HTTP_GET | HTTP_POST, timed<handleAutotune, Metric::HTTP_AUTOTUNE>, nullptr,
+              collectBody);
+  g_server.addHandler(&g_asset_handler);
+  g_server.onNotFound(timed<handleNotFound, Metric::HTTP_NOT_FOUND>);
   g_server.begin();
   g_server_started = true;
 }
 } // namespace
 
-bool webSetup() {
-  if (!setupWifi()) {
-    return false;
-  }
+void webProfileUploadHeap(uint32_t &out_before, uint32_t &out_min_free) {
+  out_before = g_upload_heap_before.load();
+  out_min_free = g_upload_heap_min.load();
+}
+
+void webArenaStats(WebArenaStats &out_stats) {
+  out_stats.json_high_water = ZERO_HEAP ? g_json_arena.highWater() : 0;
+  out_stats.json_failures = g_json_arena.failures();
+  out_stats.slot_busy = g_slot_busy;
+}
+
+void webSetup() {
   setupServer();
-  return true;
 }
 
-void webHandleClient() {
+void webPumpEvents() {
   if (g_server_started) {
-    g_server.handleClient();
+    pumpEvents();
   }
 }
@@ -0,0 +1,57 @@
+#include "web_assets.h"
+#include "log.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+
+namespace {
+constexpr char kManifestPath[] = "/manifest.json";
+constexpr uint8_t kMaxAssets = 16;
+
+WebAsset g_assets[kMaxAssets];
+uint8_t g_asset_count = 0;
+} // namespace
+
+bool webAssetsLoad() {
+  g_asset_count = 0;
+  File file = LittleFS.open(kManifestPath, "r");
+  if (!file) {
+    logWarn(LogModule::WEB, "asset manifest missing (run uploadfs)");
+    return false;
+  }
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, file);
+  file.close();
+  if (err) {
+    logError(LogModule::WEB, "asset manifest load failed: %s", err.c_str());
+    return false;
+  }
+
+  for (JsonObjectConst item : doc["assets"].as<JsonArrayConst>()) {
+    if (g_asset_count >= kMaxAssets) {
+      logWarn(LogModule::WEB, "asset manifest truncated");
+      break;
+    }
+    const char *path = item["path"] | "";
+    const char *name = item["file"] | "";
+    const char *etag = item["etag"] | "";
+    if (!*path || !*name || !*etag || strlen(path) >= sizeof(WebAsset::path) ||
+        strlen(name) >= sizeof(WebAsset::file) || strlen(etag) + 2 >= sizeof(WebAsset::etag)) {
+      continue;
+    }
+    WebAsset &asset = g_assets[g_asset_count++];
+    strlcpy(asset.path, path, sizeof(asset.path));
+    strlcpy(asset.file, name, sizeof(asset.file));
+    snprintf(asset.etag, sizeof(asset.etag), "\"%s\"", etag);
+    strlcpy(asset.type, item["type"] | "application/octet-stream", sizeof(asset.type));
+  }
+  return g_asset_count > 0;
+}
+
+const WebAsset *webAssetFind(const char *path) {
+  for (uint8_t i = 0; i < g_asset_count; ++i) {
+    if (strcmp(g_assets[i].path, path) == 0) {
+      return &g_assets[i];
+    }
+  }
+  return nullptr;
+}
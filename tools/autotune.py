@@ -0,0 +1,333 @@
+#!/usr/bin/env python3
+"""Sweep controller settings against the oven model on every CPU core.
+
+    pio run -e native
+    python3 tools/runlog_decode.py run.bin > run.csv          # optional
+    python3 tools/autotune.py --fit run.csv --out tuned.json
+
+Each worker thread drives one simulator process in --batch mode (the
+firmware's control, filter and profile code against the FOPDT plant), so a
+run costs milliseconds. Work is split into per-worker deques; a worker that
+runs dry steals from the back of the fullest one.
+
+--fit estimates the plant (ambient, gain, time constant, dead time) from a
+recorded run (runlog_decode.py output, or a simulator --csv trace) by
+replaying its duty through the model. Otherwise --gain/--tau/--dead/--ambient
+are used as given.
+
+Grids are NAME=SPEC where NAME is a simulator option (kp, bias, window,
+smooth, ki, kd, ff, ff-lead, median, ema, ...) and SPEC is lo:hi:steps or a
+comma list. Prints the Pareto front of RMS tracking error against SSR
+switches and the chosen ControlConfig: the fewest switches within
+--rms-slack of the best error, or the lowest error within --max-switches.
+"""
+import argparse
+import collections
+import csv
+import itertools
+import json
+import math
+import os
+import subprocess
+import sys
+import threading
+import time
+
+DEFAULT_GRIDS = [
+    "kp=0.005:0.12:16",
+    "bias=0:0.3:5",
+    "window=500,1000,2000,4000",
+    "smooth=1,2,4,8",
+]
+
+# Simulator option -> ControlConfig field (include/app_state.h).
+CONFIG_FIELDS = {
+    "kp": "kp",
+    "bias": "bias",
+    "ki": "ki",
+    "kd": "kd",
+    "kb": "kb",
+    "ff": "ff_gain",
+    "ff-lead": "ff_lead_s",
+    "window": "window_ms",
+    "min-on": "min_on_ms",
+    "min-off": "min_off_ms",
+    "smooth": "filter.average_window",
+    "median": "filter.median_window",
+    "ema": "filter.ema_alpha",
+    "rate": "filter.rate_window",
+}
+
+
+def parse_grid(text):
+    name, _, spec = text.partition("=")
+    if not spec:
+        sys.exit(f"bad grid {text!r}: expected NAME=lo:hi:steps or NAME=a,b,c")
+    if ":" in spec:
+        lo, hi, steps = spec.split(":")
+        lo, hi, steps = float(lo), float(hi), int(steps)
+        values = [lo + (hi - lo) * i / max(1, steps - 1) for i in range(steps)]
+    else:
+        values = [float(v) for v in spec.split(",")]
+    return name, values
+
+
+def format_value(value):
+    return str(int(value)) if float(value).is_integer() else f"{value:.6g}"
+
+
+# --- plant fit ---------------------------------------------------------------
+
+def load_trace(path):
+    times, temps, duties = [], [], []
+    with open(path) as f:
+        rows = csv.DictReader(line for line in f if not line.startswith("#"))
+        for row in rows:
+            if row.get("zone", "0") not in ("0", ""):
+                continue
+            if not row.get("t_meas") or not row.get("duty"):
+                continue
+            times.append(float(row["t_s"]))
+            temps.append(float(row["t_meas"]))
+            duties.append(float(row["duty"]))
+    if len(times) < 50:
+        sys.exit(f"{path}: need at least 50 zone-0 samples with t_meas and duty")
+    return times, temps, duties
+
+
+def simulate_fopdt(times, duties, ambient, gain, tau, dead):
+    temp = ambient
+    out = []
+    j = 0
+    for i, t in enumerate(times):
+        # Duty in effect dead seconds ago (held between samples).
+        while j + 1 < len(times) and times[j + 1] <= t - dead:
+            j += 1
+        u = duties[j] if times[j] <= t - dead else 0.0
+        if i:
+            dt = t - times[i - 1]
+            temp += (ambient + gain * u - temp) * (1.0 - math.exp(-dt / tau))
+        out.append(temp)
+    return out
+
+
+def fit_plant(path):
+    times, temps, duties = load_trace(path)
+    ambient = temps[0]
+
+    def cost(p):
+        gain, tau, dead = p
+        if gain <= 0 or tau <= 1 or dead < 0:
+            return float("inf")
+        model = simulate_fopdt(times, duties, ambient, gain, tau, dead)
+        return sum((m - y) ** 2 for m, y in zip(model, temps)) / len(temps)
+
+    # Coordinate descent with golden-section line searches.
+    params = [300.0, 160.0, 8.0]
+    bounds = [(20.0, 1000.0), (10.0, 1500.0), (0.0, 60.0)]
+    golden = (math.sqrt(5) - 1) / 2
+    for _ in range(5):
+        for k in range(3):
+            lo, hi = bounds[k]
+            for _ in range(40):
+                a = hi - golden * (hi - lo)
+                b = lo + golden * (hi - lo)
+                pa, pb = list(params), list(params)
+                pa[k], pb[k] = a, b
+                if cost(pa) < cost(pb):
+                    hi = b
+                else:
+                    lo = a
+            params[k] = (lo + hi) / 2
+    rms = math.sqrt(cost(params))
+    return {"ambient": ambient, "gain": params[0], "tau": params[1], "dead": params[2], "rms": rms}
+
+
+# --- work-stealing pool ------------------------------------------------------
+
+class StealingPool:
+    """Per-worker deques; owners pop the front, thieves take the back."""
+
+    def __init__(self, tasks, workers):
+        self.lock = threading.Lock()
+        per = math.ceil(len(tasks) / workers)
+        self.queues = [collections.deque(tasks[i * per:(i + 1) * per]) for i in range(workers)]
+        self.steals = 0
+
+    def next(self, worker):
+        with self.lock:
+            own = self.queues[worker]
+            if own:
+                return own.popleft()
+            victim = max(self.queues, key=len)
+            if victim:
+                self.steals += 1
+                return victim.pop()
+            return None
+
+
+def run_sweep(args, base_options, combos, names):
+    results = [None] * len(combos)
+    pool = StealingPool(list(range(len(combos))), args.jobs)
+    done = [0]
+    done_lock = threading.Lock()
+    errors = []
+
+    def worker(index):
+        proc = subprocess.Popen([args.sim, "--batch"] + base_options, stdin=subprocess.PIPE,
+                                stdout=subprocess.PIPE, text=True, bufsize=1)
+        try:
+            while True:
+                task = pool.next(index)
+                if task is None:
+                    break
+                line = " ".join(f"--{n} {format_value(v)}" for n, v in zip(names, combos[task]))
+                proc.stdin.write(line + "\n")
+                reply = proc.stdout.readline().split()
+                if not reply:
+                    errors.append(f"simulator exited on: {line}")
+                    break
+                if reply[0] == "ok":
+                    results[task] = dict(field.split("=", 1) for field in reply[1:])
+                with done_lock:
+                    done[0] += 1
+                    if done[0] % 200 == 0:
+                        print(f"  {done[0]}/{len(combos)}", file=sys.stderr)
+        finally:
+            proc.stdin.close()
+            proc.wait()
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(args.jobs)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    if errors:
+        sys.exit(errors[0])
+    return results, pool.steals
+
+
+# --- selection -----------------------------------------------------------------
+
+def pareto_front(points):
+    """points: (rms, switches, index); both minimised."""
+    front = []
+    best_switches = float("inf")
+    for rms, switches, index in sorted(points):
+        if switches < best_switches:
+            front.append((rms, switches, index))
+            best_switches = switches
+    return front
+
+
+def pick(front, max_switches, rms_slack):
+    if max_switches is not None:
+        within = [p for p in front if p[1] <= max_switches]
+        return min(within) if within else None
+    # Fewest switches that stay within rms_slack of the best error.
+    limit = front[0][0] * (1.0 + rms_slack)
+    return min((p for p in front if p[0] <= limit), key=lambda p: p[1])
+
+
+def control_config(names, values, base):
+    config = {}
+    for name, value in zip(names, values):
+        field = CONFIG_FIELDS.get(name)
+        if field is None:
+            continue
+        if name in ("window", "min-on", "min-off", "smooth", "median", "rate"):
+            value = int(value)
+        config[field] = value
+    if "filter.average_window" in config:
+        config["filter.smoothing"] = "MOVING_AVERAGE"
+    if "filter.ema_alpha" in config:
+        config["filter.smoothing"] = "EMA"
+    config.update(base)
+    return config
+
+
+def cpp_snippet(config):
+    lines = ["ControlConfig tuned;"]
+    for field, value in config.items():
+        if field == "controller":
+            value = f"ControllerKind::{value}"
+        elif field == "filter.smoothing":
+            value = f"FilterSmoothing::{value}"
+        elif isinstance(value, float):
+            text = f"{value:.6g}"
+            value = (text if "." in text or "e" in text else text + ".0") + "f"
+        lines.append(f"tuned.{field} = {value};")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--sim", default=".pio/build/native/program", help="simulator binary (env:native)")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--grid", action="append", help="NAME=SPEC, repeatable (default: %s)" % " ".join(DEFAULT_GRIDS))
+    parser.add_argument("--controller", choices=["p", "pid"], default="p")
+    parser.add_argument("--fit", metavar="CSV", help="fit the plant to a recorded run first")
+    parser.add_argument("--gain", type=float, default=300.0)
+    parser.add_argument("--tau", type=float, default=160.0)
+    parser.add_argument("--dead", type=float, default=8.0)
+    parser.add_argument("--ambient", type=float, default=25.0)
+    parser.add_argument("--noise", type=float, default=0.0)
+    parser.add_argument("--profile", help="profile CSV for the simulator (default: its built-in reflow)")
+    parser.add_argument("--max-switches", type=int, help="pick the lowest error at or below this many SSR switches")
+    parser.add_argument("--rms-slack", type=float, default=0.05,
+                        help="error allowed above the best when trading it for fewer switches (fraction)")
+    parser.add_argument("--out", help="write the chosen ControlConfig as JSON")
+    args = parser.parse_args()
+    args.jobs = max(1, args.jobs)
+
+    plant = {"ambient": args.ambient, "gain": args.gain, "tau": args.tau, "dead": args.dead}
+    if args.fit:
+        fitted = fit_plant(args.fit)
+        print(f"fitted plant: ambient={fitted['ambient']:.1f}C gain={fitted['gain']:.1f}C "
+              f"tau={fitted['tau']:.1f}s dead={fitted['dead']:.1f}s (rms {fitted['rms']:.2f}C)")
+        plant = {k: fitted[k] for k in ("ambient", "gain", "tau", "dead")}
+
+    base_options = []
+    for key, value in plant.items():
+        base_options += [f"--{key}", format_value(round(value, 3))]
+    base_options += ["--noise", format_value(args.noise), "--controller", args.controller]
+    if args.profile:
+        base_options += ["--profile", args.profile]
+
+    grids = [parse_grid(g) for g in (args.grid or DEFAULT_GRIDS)]
+    names = [name for name, _ in grids]
+    combos = list(itertools.product(*(values for _, values in grids)))
+    print(f"{len(combos)} combinations on {args.jobs} workers")
+
+    start = time.monotonic()
+    results, steals = run_sweep(args, base_options, combos, names)
+    elapsed = time.monotonic() - start
+    print(f"{len(combos)} runs in {elapsed:.1f}s ({len(combos) / elapsed:.0f}/s, {steals} steals)")
+
+    points = [(float(r["rms"]), int(r["switches"]), i) for i, r in enumerate(results)
+              if r and r["state"] != "ERROR"]
+    if not points:
+        sys.exit("no run finished without a fault")
+    front = pareto_front(points)
+    print("\nPareto front (rms error vs SSR switches):")
+    print("  " + "  ".join(f"{n:>8}" for n in names) + "       rms  switches  overshoot")
+    for rms, switches, i in front:
+        values = "  ".join(f"{format_value(v):>8}" for v in combos[i])
+        print(f"  {values}  {rms:8.2f}  {switches:8d}  {float(results[i]['overshoot']):9.2f}")
+
+    chosen = pick(front, args.max_switches, args.rms_slack)
+    if chosen is None:
+        sys.exit(f"no front point at or below {args.max_switches} switches")
+    rms, switches, i = chosen
+    config = control_config(names, combos[i], {"controller": args.controller.upper()})
+    print(f"\nchosen: rms={rms:.2f}C switches={switches}")
+    print(cpp_snippet(config))
+    print("simulator: " + " ".join(base_options + [f"--{n} {format_value(v)}" for n, v in zip(names, combos[i])]))
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump({"plant": plant, "rms_c": rms, "ssr_switches": switches, "control_config": config}, f, indent=2)
+            f.write("\n")
+
+
+if __name__ == "__main__":
+    main()
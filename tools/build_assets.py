@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Gzip and content-hash the dashboard assets in data/ for the LittleFS image.
+
+    python3 tools/build_assets.py data .pio/www
+
+Output layout (becomes the LittleFS root):
+    /manifest.json   {"assets":[{"path","file","etag","type","size"}, ...]}
+    /w/<hash>        gzip body of one asset, named by its content hash
+
+The firmware loads manifest.json once at boot (src/web_assets.cpp) and serves
+every asset with Content-Encoding: gzip and its hash as a strong ETag.
+index.html is also published as "/".
+
+As a PlatformIO pre-script it regenerates the output on every build and points
+PROJECT_DATA_DIR at it, so `pio run -t uploadfs` flashes the processed tree.
+"""
+import gzip
+import hashlib
+import json
+import os
+import shutil
+import sys
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+}
+HASH_CHARS = 16
+
+
+def build(src_dir, out_dir):
+    if os.path.isdir(out_dir):
+        shutil.rmtree(out_dir)
+    os.makedirs(os.path.join(out_dir, "w"))
+
+    assets = []
+    for root, _, files in os.walk(src_dir):
+        for name in sorted(files):
+            src = os.path.join(root, name)
+            rel = "/" + os.path.relpath(src, src_dir).replace(os.sep, "/")
+            with open(src, "rb") as f:
+                raw = f.read()
+            # mtime=0 keeps the output (and therefore the hash) reproducible.
+            body = gzip.compress(raw, compresslevel=9, mtime=0)
+            digest = hashlib.sha256(raw).hexdigest()[:HASH_CHARS]
+            with open(os.path.join(out_dir, "w", digest), "wb") as f:
+                f.write(body)
+            ext = os.path.splitext(name)[1].lower()
+            entry = {
+                "path": rel,
+                "file": "/w/" + digest,
+                "etag": digest,
+                "type": CONTENT_TYPES.get(ext, "application/octet-stream"),
+                "size": len(body),
+            }
+            assets.append(entry)
+            if rel == "/index.html":
+                assets.append(dict(entry, path="/"))
+            print(f"assets: {rel} {len(raw)} -> {len(body)} bytes ({digest})")
+
+    assets.sort(key=lambda a: a["path"])
+    with open(os.path.join(out_dir, "manifest.json"), "w") as f:
+        json.dump({"assets": assets}, f, separators=(",", ":"))
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.exit(f"usage: {argv[0]} SRC_DIR OUT_DIR")
+    build(argv[1], argv[2])
+
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO SCons environment)
+except NameError:
+    if __name__ == "__main__":
+        main(sys.argv)
+else:
+    out = env.subst("$BUILD_DIR/www")  # noqa: F821
+    build(env.subst("$PROJECT_DIR/data"), out)  # noqa: F821
+    env.Replace(PROJECT_DATA_DIR=out)  # noqa: F821
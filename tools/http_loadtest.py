@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Measure /api/status latency while static assets download concurrently.
+
+    python3 tools/http_loadtest.py esp32-oven.local --seconds 30 --pollers 2 --downloaders 4
+
+Pollers reuse one keep-alive connection each; downloaders fetch the dashboard
+assets in a loop. Prints p50/p99/max latency per path and the error count.
+"""
+import argparse
+import http.client
+import threading
+import time
+
+ASSETS = ["/", "/app.js", "/styles.css"]
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return float("nan")
+    index = min(len(sorted_values) - 1, int(round(pct / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[index]
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latency = {}
+        self.errors = {}
+        self.bytes = 0
+
+    def ok(self, path, seconds, size):
+        with self.lock:
+            self.latency.setdefault(path, []).append(seconds)
+            self.bytes += size
+
+    def error(self, path):
+        with self.lock:
+            self.errors[path] = self.errors.get(path, 0) + 1
+
+
+def worker(host, port, paths, deadline, interval, stats):
+    conn = None
+    i = 0
+    while time.monotonic() < deadline:
+        path = paths[i % len(paths)]
+        i += 1
+        if conn is None:
+            conn = http.client.HTTPConnection(host, port, timeout=10)
+        start = time.monotonic()
+        try:
+            conn.request("GET", path)
+            resp = conn.getresponse()
+            body = resp.read()
+            if resp.status != 200:
+                raise http.client.HTTPException(f"status {resp.status}")
+            stats.ok(path, time.monotonic() - start, len(body))
+            if resp.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            stats.error(path)
+            if conn is not None:
+                conn.close()
+            conn = None
+        if interval > 0:
+            time.sleep(interval)
+    if conn is not None:
+        conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--seconds", type=float, default=20.0)
+    parser.add_argument("--pollers", type=int, default=2, help="/api/status clients")
+    parser.add_argument("--downloaders", type=int, default=4, help="static asset clients")
+    parser.add_argument("--interval", type=float, default=0.2, help="poll interval (s)")
+    args = parser.parse_args()
+
+    stats = Stats()
+    deadline = time.monotonic() + args.seconds
+    threads = []
+    for _ in range(args.pollers):
+        threads.append(threading.Thread(
+            target=worker, args=(args.host, args.port, ["/api/status"], deadline, args.interval, stats)))
+    for _ in range(args.downloaders):
+        threads.append(threading.Thread(
+            target=worker, args=(args.host, args.port, ASSETS, deadline, 0.0, stats)))
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    print(f"{'path':<14}{'count':>7}{'p50 ms':>9}{'p99 ms':>9}{'max ms':>9}{'errors':>8}")
+    for path in sorted(set(stats.latency) | set(stats.errors)):
+        values = sorted(stats.latency.get(path, []))
+        print(f"{path:<14}{len(values):>7}"
+              f"{percentile(values, 50) * 1000:>9.1f}{percentile(values, 99) * 1000:>9.1f}"
+              f"{(values[-1] if values else float('nan')) * 1000:>9.1f}{stats.errors.get(path, 0):>8}")
+    print(f"downloaded {stats.bytes / 1024:.1f} KiB in {args.seconds:.0f} s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Upload profiles of increasing size and report the heap cost of each upload.
+
+    python3 tools/profile_upload_bench.py esp32-oven.local --points 2,32,33,500,4096,4097
+
+Each profile is POSTed to /api/profiles in small TCP writes (like a slow
+client); after each upload the firmware's upload heap gauges are read from
+/api/metrics. "peak" is free heap at the start of the upload minus the
+lowest free heap seen while it was parsed and stored. Profiles that exceed
+the firmware limits must come back as errors (413 too_many_points), never
+as a truncated 200.
+"""
+import argparse
+import http.client
+import json
+import re
+import time
+
+
+def make_profile(name, points, pad):
+    step = max(1, 600 // max(1, points - 1))
+    body = {
+        "name": name,
+        "end_behavior": "stop",
+        "points": [{"t_sec": i * step, "temp_c": 25.0 + (i % 200)} for i in range(points)],
+    }
+    if pad:
+        body["comment"] = "x" * pad
+    return json.dumps(body).encode()
+
+
+def metric(text, name):
+    match = re.search(r"^%s (\S+)$" % re.escape(name), text, re.M)
+    return int(float(match.group(1))) if match else None
+
+
+def upload(host, port, body, chunk):
+    conn = http.client.HTTPConnection(host, port, timeout=20)
+    conn.putrequest("POST", "/api/profiles")
+    conn.putheader("Content-Type", "application/json")
+    conn.putheader("Content-Length", str(len(body)))
+    conn.endheaders()
+    for i in range(0, len(body), chunk):
+        conn.send(body[i:i + chunk])
+    resp = conn.getresponse()
+    payload = resp.read().decode(errors="replace")
+    conn.close()
+    return resp.status, payload
+
+
+def delete(host, port, name):
+    conn = http.client.HTTPConnection(host, port, timeout=10)
+    conn.request("DELETE", "/api/profiles/" + name)
+    conn.getresponse().read()
+    conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--points", default="2,8,32,33,500,4096,4097")
+    parser.add_argument("--pad", type=int, default=0, help="bytes of unknown field per profile")
+    parser.add_argument("--chunk", type=int, default=256, help="bytes per TCP write")
+    args = parser.parse_args()
+
+    print(f"{'points':>7}{'bytes':>8}{'status':>8}{'peak B':>9}  response")
+    for count in (int(p) for p in args.points.split(",")):
+        name = f"bench{count}"
+        body = make_profile(name, count, args.pad)
+        status, payload = upload(args.host, args.port, body, args.chunk)
+        time.sleep(0.2)
+        conn = http.client.HTTPConnection(args.host, args.port, timeout=10)
+        conn.request("GET", "/api/metrics")
+        text = conn.getresponse().read().decode()
+        conn.close()
+        before = metric(text, "oven_profile_upload_heap_free_before_bytes")
+        low = metric(text, "oven_profile_upload_heap_free_min_bytes")
+        peak = before - low if before is not None and low is not None else float("nan")
+        print(f"{count:>7}{len(body):>8}{status:>8}{peak:>9}  {payload[:60]}")
+        if status == 200:
+            delete(args.host, args.port, name)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Decode a run log downloaded from /api/runs/<id> into CSV.
+
+    curl -o run.bin http://esp32-oven.local/api/runs/12
+    python3 tools/runlog_decode.py run.bin > run.csv
+
+Layout is documented in include/runlog.h.
+"""
+import binascii
+import struct
+import sys
+
+FILE_HEADER = struct.Struct("<IHHIIHH32sI")
+# Versions 1 and 2: the profile name cut to 23 characters.
+FILE_HEADER_V2 = struct.Struct("<IHHIIHH24sI")
+FILE_PREFIX = struct.Struct("<IH")
+FRAME_HEADER = struct.Struct("<HHI")
+RECORD = struct.Struct("<hhBBBB")
+FILE_MAGIC = 0x4C52564F
+FRAME_MAGIC = 0xB10C
+TEMP_SCALE = 16.0
+TEMP_INVALID = -32768
+STATES = {0: "IDLE", 1: "RUNNING", 2: "DISABLED", 3: "ERROR", 4: "AUTOTUNE"}
+
+
+def temp(value):
+    return "" if value == TEMP_INVALID else f"{value / TEMP_SCALE:.2f}"
+
+
+def main(path):
+    data = open(path, "rb").read()
+    if len(data) < FILE_PREFIX.size:
+        sys.exit("file too short")
+    header = FILE_HEADER if FILE_PREFIX.unpack_from(data)[1] >= 3 else FILE_HEADER_V2
+    if len(data) < header.size:
+        sys.exit("file too short")
+    magic, version, record_size, run_id, start_ms, period_ms, zones, profile, crc = header.unpack_from(data)
+    if magic != FILE_MAGIC or binascii.crc32(data[:header.size - 4]) != crc:
+        sys.exit("bad file header")
+    if record_size != RECORD.size:
+        sys.exit(f"unsupported record size {record_size}")
+    if version < 2 or zones == 0:
+        zones = 1
+    profile = profile.split(b"\0", 1)[0].decode(errors="replace")
+    print(f"# run={run_id} version={version} profile={profile} start_ms={start_ms} period_ms={period_ms} zones={zones}")
+    print("tick,t_s,zone,t_meas,t_set,duty,state,fault")
+
+    offset = header.size
+    while offset + FRAME_HEADER.size <= len(data):
+        frame_magic, count, first_tick = FRAME_HEADER.unpack_from(data, offset)
+        end = offset + FRAME_HEADER.size + count * RECORD.size
+        if frame_magic != FRAME_MAGIC or end + 4 > len(data):
+            print(f"# truncated frame at byte {offset}", file=sys.stderr)
+            break
+        (crc,) = struct.unpack_from("<I", data, end)
+        if binascii.crc32(data[offset:end]) != crc:
+            print(f"# CRC mismatch at byte {offset}", file=sys.stderr)
+            break
+        for i in range(count):
+            t_meas, t_set, duty, state, fault, _ = RECORD.unpack_from(data, offset + FRAME_HEADER.size + i * RECORD.size)
+            tick = first_tick + i // zones
+            print(f"{tick},{tick * period_ms / 1000:.1f},{i % zones},{temp(t_meas)},{temp(t_set)},"
+                  f"{duty / 255:.3f},{STATES.get(state, state)},{fault}")
+        offset = end + 4
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    main(sys.argv[1])
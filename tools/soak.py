@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Check that the heap stays flat over a long run of API calls.
+
+    python3 tools/soak.py esp32-oven.local --calls 100000 --clients 2
+
+Clients cycle through the read-only API (and a no-op POST /api/log) on
+keep-alive connections; every --sample calls /api/metrics is read for the
+heap gauges. After --warmup calls the largest free block must not end more
+than --tolerance bytes below where it started; exits 1 if it does. Nothing
+here starts a run or an autotune.
+"""
+import argparse
+import http.client
+import json
+import re
+import threading
+import time
+
+PATHS = [
+    ("GET", "/api/status", None),
+    ("GET", "/api/history?points=300", None),
+    ("GET", "/api/profiles", None),
+    ("GET", "/api/runs", None),
+    ("GET", "/api/log", None),
+    ("POST", "/api/log", json.dumps({"levels": {}})),
+    ("GET", "/api/autotune", None),
+    ("GET", "/api/profiles/soak-missing", None),
+]
+GAUGES = ["oven_heap_largest_free_block_bytes", "oven_heap_free_bytes", "oven_web_json_arena_high_water_bytes",
+          "oven_web_json_arena_failures_total", "oven_web_slot_busy_total"]
+
+
+class Counter:
+    def __init__(self, limit):
+        self.lock = threading.Lock()
+        self.limit = limit
+        self.issued = 0
+        self.errors = 0
+
+    def take(self):
+        with self.lock:
+            if self.issued >= self.limit:
+                return None
+            self.issued += 1
+            return self.issued
+
+    def error(self):
+        with self.lock:
+            self.errors += 1
+
+
+def request(conn, method, path, body):
+    headers = {"Content-Type": "application/json"} if body else {}
+    conn.request(method, path, body=body, headers=headers)
+    resp = conn.getresponse()
+    data = resp.read()
+    return resp, data
+
+
+def worker(host, port, counter, offset):
+    conn = None
+    while True:
+        n = counter.take()
+        if n is None:
+            break
+        method, path, body = PATHS[(n + offset) % len(PATHS)]
+        if conn is None:
+            conn = http.client.HTTPConnection(host, port, timeout=10)
+        try:
+            resp, _ = request(conn, method, path, body)
+            # 404 is the expected answer for the missing profile.
+            if resp.status >= 500:
+                raise http.client.HTTPException(f"status {resp.status}")
+            if resp.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            counter.error()
+            if conn is not None:
+                conn.close()
+            conn = None
+    if conn is not None:
+        conn.close()
+
+
+def read_gauges(host, port):
+    conn = http.client.HTTPConnection(host, port, timeout=10)
+    try:
+        _, data = request(conn, "GET", "/api/metrics", None)
+    finally:
+        conn.close()
+    values = {}
+    for name in GAUGES:
+        match = re.search(rf"^{name} (\S+)$", data.decode(errors="replace"), re.MULTILINE)
+        values[name] = float(match.group(1)) if match else float("nan")
+    return values
+
+
+def slope(xs, ys):
+    n = len(xs)
+    if n < 2:
+        return 0.0
+    mx = sum(xs) / n
+    my = sum(ys) / n
+    den = sum((x - mx) ** 2 for x in xs)
+    return sum((x - mx) * (y - my) for x, y in zip(xs, ys)) / den if den else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--calls", type=int, default=100000)
+    parser.add_argument("--clients", type=int, default=2)
+    parser.add_argument("--sample", type=int, default=2000, help="calls between heap samples")
+    parser.add_argument("--warmup", type=int, default=2000, help="calls before the baseline sample")
+    parser.add_argument("--tolerance", type=int, default=1024, help="allowed drop of the largest block (bytes)")
+    args = parser.parse_args()
+
+    warmup = Counter(args.warmup)
+    threads = [threading.Thread(target=worker, args=(args.host, args.port, warmup, i)) for i in range(args.clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    samples = [(0, read_gauges(args.host, args.port))]
+    done = 0
+    errors = warmup.errors
+    start = time.monotonic()
+    print(f"{'calls':>8}{'largest':>10}{'free':>10}{'arena hw':>10}{'arena fail':>12}{'busy':>6}")
+    while done < args.calls:
+        batch = Counter(min(args.sample, args.calls - done))
+        threads = [threading.Thread(target=worker, args=(args.host, args.port, batch, done + i))
+                   for i in range(args.clients)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        done += batch.issued
+        errors += batch.errors
+        samples.append((done, read_gauges(args.host, args.port)))
+        g = samples[-1][1]
+        print(f"{done:>8}{g[GAUGES[0]]:>10.0f}{g[GAUGES[1]]:>10.0f}{g[GAUGES[2]]:>10.0f}"
+              f"{g[GAUGES[3]]:>12.0f}{g[GAUGES[4]]:>6.0f}")
+
+    calls = [c for c, _ in samples]
+    largest = [g[GAUGES[0]] for _, g in samples]
+    drop = largest[0] - min(largest[-max(1, len(largest) // 10):])
+    elapsed = time.monotonic() - start
+    print(f"{done} calls in {elapsed:.0f} s ({done / elapsed:.0f}/s), {errors} errors")
+    print(f"largest free block: start {largest[0]:.0f} end {largest[-1]:.0f} min {min(largest):.0f} "
+          f"slope {slope(calls, largest) * 10000:+.1f} B per 10k calls")
+    if drop > args.tolerance:
+        print(f"FAIL: largest free block dropped {drop:.0f} B (tolerance {args.tolerance} B)")
+        raise SystemExit(1)
+    print("OK: largest free block flat")
+
+
+if __name__ == "__main__":
+    main()